@@ -502,6 +502,22 @@ void BaseView::blit(Surface *surface)
 	}
 }
 
+/**
+ * Gets the changed area of the base view, including
+ * the facility selector.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool BaseView::getDamage(SDL_Rect &rect)
+{
+	bool damaged = Surface::getDamage(rect);
+	if (_selector != 0)
+	{
+		damaged = _selector->getDamage(rect) || damaged;
+	}
+	return damaged;
+}
+
 /**
  * Selects the facility the mouse is over.
  * @param action Pointer to an action.
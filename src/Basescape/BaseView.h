@@ -90,6 +90,8 @@ public:
 	void draw();
 	/// Blits the base view onto another surface.
 	void blit(Surface *surface);
+	/// Gets the changed area of the base view.
+	bool getDamage(SDL_Rect &rect);
 	/// Special handling for mouse hovers.
 	void mouseOver(Action *action, State *state);
 	/// Special handling for mouse hovering out.
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AIAnalysis.h"
+#include <algorithm>
+#include "Pathfinding.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Savegame/Tile.h"
+#include "../Mod/Armor.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Orders the keys of the reachable tile lists.
+ * @param other Key to compare with.
+ * @return True if this key comes first.
+ */
+bool AIAnalysis::ReachableKey::operator<(const ReachableKey &other) const
+{
+	if (unit != other.unit)
+		return unit < other.unit;
+	if (tuMax != other.tuMax)
+		return tuMax < other.tuMax;
+	if (energy != other.energy)
+		return energy < other.energy;
+	return spotted < other.spotted;
+}
+
+/**
+ * Compares the remembered states of a unit.
+ * @param other State to compare with.
+ * @return True if anything the AI looks at differs.
+ */
+bool AIAnalysis::UnitState::operator!=(const UnitState &other) const
+{
+	return pos != other.pos || size != other.size || faction != other.faction || flags != other.flags || turnsSinceSpotted != other.turnsSinceSpotted;
+}
+
+/**
+ * Creates the AI analysis for a battle.
+ * @param save Pointer to the battle.
+ * @param pathfinding Pathfinding to work out the reachable tiles with.
+ */
+AIAnalysis::AIAnalysis(SavedBattleGame *save, Pathfinding *pathfinding) : _save(save), _pathfinding(pathfinding), _turn(-1), _side(-1), _terrainStamp(Tile::getTerrainChanges()), _fireStamp(Tile::getFireChanges())
+{
+}
+
+/**
+ * Cleans up the AI analysis.
+ */
+AIAnalysis::~AIAnalysis()
+{
+}
+
+/**
+ * Forgets all the answers.
+ */
+void AIAnalysis::forget()
+{
+	_reachable.clear();
+	_spotters.clear();
+}
+
+/**
+ * Forgets the answers that something changing on a square
+ * of tiles, on any level, could affect: spotter counts for
+ * tiles close enough to it to be seen across it, and
+ * reachable tiles passing next to it.
+ * @param pos Top left corner of the square.
+ * @param size Size of the square.
+ */
+void AIAnalysis::forgetAround(const Position &pos, int size)
+{
+	int minX = std::max(0, pos.x - SPOTTING_RANGE);
+	int maxX = std::min(_save->getMapSizeX() - 1, pos.x + size - 1 + SPOTTING_RANGE);
+	int minY = std::max(0, pos.y - SPOTTING_RANGE);
+	int maxY = std::min(_save->getMapSizeY() - 1, pos.y + size - 1 + SPOTTING_RANGE);
+	for (std::map<int, std::vector<int> >::iterator i = _spotters.begin(); i != _spotters.end(); ++i)
+	{
+		for (int z = 0; z < _save->getMapSizeZ(); ++z)
+		{
+			for (int y = minY; y <= maxY; ++y)
+			{
+				int index = _save->getTileIndex(Position(minX, y, z));
+				std::fill(i->second.begin() + index, i->second.begin() + index + maxX - minX + 1, -1);
+			}
+		}
+	}
+	// units next to a path block it, and large units reach one tile further
+	for (std::map<ReachableKey, Reachable>::iterator i = _reachable.begin(); i != _reachable.end();)
+	{
+		const Reachable &r = i->second;
+		if (pos.x + size - 1 >= r.min.x - 2 && pos.x <= r.max.x + 2 &&
+			pos.y + size - 1 >= r.min.y - 2 && pos.y <= r.max.y + 2 &&
+			pos.z >= r.min.z - 1 && pos.z <= r.max.z + 1)
+		{
+			_reachable.erase(i++);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+/**
+ * Forgets the answers worked out for a unit, when the unit
+ * itself changed.
+ * @param id ID of the unit.
+ */
+void AIAnalysis::forgetUnit(int id)
+{
+	_spotters.erase(id);
+	ReachableKey key;
+	key.unit = id;
+	key.tuMax = key.energy = key.spotted = -1;
+	std::map<ReachableKey, Reachable>::iterator i = _reachable.lower_bound(key);
+	while (i != _reachable.end() && i->first.unit == id)
+	{
+		_reachable.erase(i++);
+	}
+}
+
+/**
+ * Forgets the answers that what changed in the battle since the
+ * last update could affect. A new turn forgets everything; a
+ * unit that moved, kneeled, got spotted or died and tiles whose
+ * terrain changed only forget the answers around them. The AI
+ * calls this every time it starts thinking, nothing changes
+ * while it does.
+ */
+void AIAnalysis::update()
+{
+	if (_turn != _save->getTurn() || _side != _save->getSide())
+	{
+		_turn = _save->getTurn();
+		_side = _save->getSide();
+		forget();
+	}
+
+	if (_fireStamp != Tile::getFireChanges())
+	{
+		_fireStamp = Tile::getFireChanges();
+		// fire changes what paths cost, but not who can see what
+		_reachable.clear();
+	}
+
+	if (_terrainStamp != Tile::getTerrainChanges())
+	{
+		// the stamps only go up, so a tile changed since the last update if its stamp is newer
+		std::vector<int> changed;
+		for (int i = 0; i < _save->getMapSizeXYZ() && changed.size() <= (size_t)MAX_CHANGED_TILES; ++i)
+		{
+			if (_save->getTiles()[i]->getTerrainStamp() > _terrainStamp)
+			{
+				changed.push_back(i);
+			}
+		}
+		if (changed.size() > (size_t)MAX_CHANGED_TILES)
+		{
+			forget();
+		}
+		else
+		{
+			for (std::vector<int>::const_iterator i = changed.begin(); i != changed.end(); ++i)
+			{
+				forgetAround(_save->getTiles()[*i]->getPosition(), 1);
+			}
+		}
+		_terrainStamp = Tile::getTerrainChanges();
+	}
+
+	_current.clear();
+	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	{
+		UnitState &state = _current[(*i)->getId()];
+		state.pos = (*i)->getPosition();
+		state.size = (*i)->getArmor()->getSize();
+		state.faction = (*i)->getFaction();
+		state.flags = ((*i)->isOut() ? 1 : 0) | ((*i)->isKneeled() ? 2 : 0) | ((*i)->getVisible() ? 4 : 0);
+		state.turnsSinceSpotted = (*i)->getTurnsSinceSpotted();
+		std::map<int, UnitState>::iterator old = _units.find((*i)->getId());
+		if (old == _units.end())
+		{
+			forgetAround(state.pos, state.size);
+		}
+		else
+		{
+			if (old->second != state)
+			{
+				forgetAround(old->second.pos, old->second.size);
+				forgetAround(state.pos, state.size);
+				forgetUnit((*i)->getId());
+			}
+			_units.erase(old);
+		}
+	}
+	// whatever is left is gone from the battle
+	for (std::map<int, UnitState>::const_iterator i = _units.begin(); i != _units.end(); ++i)
+	{
+		forgetAround(i->second.pos, i->second.size);
+		forgetUnit(i->first);
+	}
+	_units.swap(_current);
+}
+
+/**
+ * Gets the tiles a unit can reach with some TUs,
+ * finding them if it wasn't done already.
+ * @param unit Pointer to the unit.
+ * @param tuMax The maximum cost of the path to each tile.
+ * @return The reachable tiles, as Pathfinding::findReachable gives them.
+ */
+const std::vector<int> &AIAnalysis::findReachable(BattleUnit *unit, int tuMax)
+{
+	ReachableKey key;
+	key.unit = unit->getId();
+	key.tuMax = tuMax;
+	key.energy = unit->getEnergy();
+	key.spotted = unit->getUnitsSpottedThisTurn().size();
+	std::map<ReachableKey, Reachable>::iterator i = _reachable.find(key);
+	if (i == _reachable.end())
+	{
+		i = _reachable.insert(std::make_pair(key, Reachable())).first;
+		Reachable &r = i->second;
+		r.tiles = _pathfinding->findReachable(unit, tuMax);
+		r.min = r.max = unit->getPosition();
+		for (std::vector<int>::const_iterator j = r.tiles.begin(); j != r.tiles.end(); ++j)
+		{
+			Position pos;
+			_save->getTileCoords(*j, &pos.x, &pos.y, &pos.z);
+			r.min.x = std::min(r.min.x, pos.x);
+			r.min.y = std::min(r.min.y, pos.y);
+			r.min.z = std::min(r.min.z, pos.z);
+			r.max.x = std::max(r.max.x, pos.x);
+			r.max.y = std::max(r.max.y, pos.y);
+			r.max.z = std::max(r.max.z, pos.z);
+		}
+	}
+	return i->second.tiles;
+}
+
+/**
+ * Gets the number of enemies that were found to be able
+ * to see a unit standing at a position.
+ * @param unit Pointer to the unit.
+ * @param pos Position to check.
+ * @param spotters Gets the number of spotting enemies.
+ * @return True if the number is known.
+ */
+bool AIAnalysis::getSpotters(BattleUnit *unit, const Position &pos, int *spotters) const
+{
+	std::map<int, std::vector<int> >::const_iterator i = _spotters.find(unit->getId());
+	if (i == _spotters.end() || i->second[_save->getTileIndex(pos)] < 0)
+	{
+		return false;
+	}
+	*spotters = i->second[_save->getTileIndex(pos)];
+	return true;
+}
+
+/**
+ * Remembers the number of enemies that can see
+ * a unit standing at a position.
+ * @param unit Pointer to the unit.
+ * @param pos Position checked.
+ * @param spotters Number of spotting enemies.
+ */
+void AIAnalysis::setSpotters(BattleUnit *unit, const Position &pos, int spotters)
+{
+	std::vector<int> &field = _spotters[unit->getId()];
+	if (field.empty())
+	{
+		field.assign(_save->getMapSizeXYZ(), -1);
+	}
+	field[_save->getTileIndex(pos)] = spotters;
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_AIANALYSIS_H
+#define OPENXCOM_AIANALYSIS_H
+
+#include <vector>
+#include <map>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class BattleUnit;
+class Pathfinding;
+
+/**
+ * Remembers the expensive parts of the AI's thinking during a turn:
+ * the tiles each unit can reach and, for each unit asking, a field of
+ * how many enemies could see it on each tile. When a unit moves or
+ * changes, or the terrain of a tile changes, only the answers that
+ * change could touch are forgotten; a fire starting or going out
+ * forgets the reachable tiles. So the answers are always the same
+ * as working them out again.
+ */
+class AIAnalysis
+{
+private:
+	struct ReachableKey
+	{
+		int unit, tuMax, energy, spotted;
+		bool operator<(const ReachableKey &other) const;
+	};
+	struct Reachable
+	{
+		std::vector<int> tiles;
+		Position min, max;
+	};
+	struct UnitState
+	{
+		Position pos;
+		int size, faction, flags, turnsSinceSpotted;
+		bool operator!=(const UnitState &other) const;
+	};
+	// spotters further than 20 tiles are never counted, plus room for large units
+	static const int SPOTTING_RANGE = 22;
+	// past this many changed tiles it's cheaper to start over
+	static const int MAX_CHANGED_TILES = 64;
+	SavedBattleGame *_save;
+	Pathfinding *_pathfinding;
+	int _turn, _side;
+	unsigned int _terrainStamp, _fireStamp;
+	std::map<int, UnitState> _units, _current;
+	std::map<ReachableKey, Reachable> _reachable;
+	std::map<int, std::vector<int> > _spotters;
+	/// Forgets everything.
+	void forget();
+	/// Forgets the answers a change on some tiles could affect.
+	void forgetAround(const Position &pos, int size);
+	/// Forgets the answers for a unit that changed.
+	void forgetUnit(int id);
+public:
+	/// Creates the analysis for a battle.
+	AIAnalysis(SavedBattleGame *save, Pathfinding *pathfinding);
+	/// Cleans up the analysis.
+	~AIAnalysis();
+	/// Forgets whatever changed in the battle since the last update.
+	void update();
+	/// Gets the tiles a unit can reach.
+	const std::vector<int> &findReachable(BattleUnit *unit, int tuMax);
+	/// Gets the number of enemies spotting a unit at a position, if known.
+	bool getSpotters(BattleUnit *unit, const Position &pos, int *spotters) const;
+	/// Sets the number of enemies spotting a unit at a position.
+	void setSpotters(BattleUnit *unit, const Position &pos, int spotters);
+};
+
+}
+
+#endif
@@ -0,0 +1,445 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AIPlanner.h"
+#include <algorithm>
+#include <climits>
+#include "AlienBAIState.h"
+#include "AIAnalysis.h"
+#include "Pathfinding.h"
+#include "TileEngine.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Savegame/BattleItem.h"
+#include "../Savegame/Tile.h"
+#include "../Savegame/Node.h"
+#include "../Mod/RuleItem.h"
+#include "../Engine/Options.h"
+#include "../Engine/ThreadPool.h"
+
+namespace OpenXcom
+{
+
+/**
+ * The units being planned in one go.
+ */
+struct AIPlanner::PlanJob
+{
+	AIPlanner *planner;
+	std::vector<BattleUnit*> units;
+	std::vector<Plan*> plans;
+};
+
+/**
+ * Notes down everything about a unit that a plan could depend on.
+ * @param unit Pointer to the unit.
+ */
+AIPlanner::UnitRecord::UnitRecord(BattleUnit *unit) : pos(unit->getPosition()), direction(unit->getDirection()), status(unit->getStatus()), faction(unit->getFaction()),
+	tu(unit->getTimeUnits()), energy(unit->getEnergy()), health(unit->getHealth()), stun(unit->getStunlevel()), morale(unit->getMorale()),
+	turnsSinceSpotted(unit->getTurnsSinceSpotted()), spotted(unit->getUnitsSpottedThisTurn().size()), rounds(0),
+	visible(unit->getVisible()), kneeled(unit->isKneeled()), charging(unit->getCharging()), weapon(unit->getMainHandWeapon()), ammo(0)
+{
+	if (weapon)
+	{
+		ammo = weapon->getAmmoItem();
+	}
+	if (ammo)
+	{
+		rounds = ammo->getAmmoQuantity();
+	}
+}
+
+/**
+ * Checks if a unit changed since it was noted down.
+ * @param other Record to compare with.
+ * @return True if anything is different.
+ */
+bool AIPlanner::UnitRecord::operator!=(const UnitRecord &other) const
+{
+	return pos != other.pos || direction != other.direction || status != other.status || faction != other.faction ||
+		tu != other.tu || energy != other.energy || health != other.health || stun != other.stun || morale != other.morale ||
+		turnsSinceSpotted != other.turnsSinceSpotted || spotted != other.spotted || rounds != other.rounds ||
+		visible != other.visible || kneeled != other.kneeled || charging != other.charging || weapon != other.weapon || ammo != other.ammo;
+}
+
+/**
+ * Initializes the planner for a battle.
+ * @param save Pointer to the saved battle.
+ */
+AIPlanner::AIPlanner(SavedBattleGame *save) : _save(save), _battlePathfinding(0), _mutex(0), _turn(-1), _side(-1), _terrainStamp(0), _fireStamp(0), _hazardStamp(0)
+{
+	_mutex = SDL_CreateMutex();
+}
+
+/**
+ * Deletes the plans and everything they were made with.
+ */
+AIPlanner::~AIPlanner()
+{
+	discard();
+	for (std::vector<Planner*>::iterator i = _planners.begin(); i != _planners.end(); ++i)
+	{
+		delete (*i)->analysis;
+		delete (*i)->pathfinding;
+		delete *i;
+	}
+	if (_mutex)
+	{
+		SDL_DestroyMutex(_mutex);
+	}
+}
+
+/**
+ * Checks if a unit has an empty gun in hand and would
+ * try to reload it before thinking, which changes the battle,
+ * so it can't be planned ahead.
+ * @param unit Pointer to the unit.
+ * @return True if the unit might reload.
+ */
+bool AIPlanner::needsReload(BattleUnit *unit)
+{
+	if (unit->getTimeUnits() < 15)
+	{
+		return false;
+	}
+	BattleItem *hands[] = { unit->getItem("STR_RIGHT_HAND"), unit->getItem("STR_LEFT_HAND") };
+	for (int i = 0; i < 2; ++i)
+	{
+		if (hands[i] && hands[i]->getAmmoItem() == 0 && hands[i]->getRules()->getBattleType() != BT_MELEE)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Throws away all the plans that weren't used.
+ */
+void AIPlanner::discard()
+{
+	for (std::map<BattleUnit*, Plan>::iterator i = _plans.begin(); i != _plans.end(); ++i)
+	{
+		delete i->second.ai;
+	}
+	_plans.clear();
+}
+
+/**
+ * Makes sure there's a pathfinding and analysis for each
+ * thread to plan with, sized for the current map.
+ * @param threads Number of threads that will plan.
+ */
+void AIPlanner::preparePlanners(int threads)
+{
+	if (_battlePathfinding != _save->getPathfinding())
+	{
+		// the map changed, start over
+		for (std::vector<Planner*>::iterator i = _planners.begin(); i != _planners.end(); ++i)
+		{
+			delete (*i)->analysis;
+			delete (*i)->pathfinding;
+			delete *i;
+		}
+		_planners.clear();
+		_battlePathfinding = _save->getPathfinding();
+	}
+	while ((int)_planners.size() < threads)
+	{
+		Planner *planner = new Planner;
+		planner->pathfinding = new Pathfinding(_save);
+		planner->analysis = new AIAnalysis(_save, planner->pathfinding);
+		planner->busy = false;
+		_planners.push_back(planner);
+	}
+}
+
+/**
+ * Takes a pathfinding and analysis no other thread is using.
+ * @return Pointer to the planner.
+ */
+AIPlanner::Planner *AIPlanner::acquire()
+{
+	if (_mutex)
+	{
+		SDL_mutexP(_mutex);
+	}
+	Planner *planner = 0;
+	for (std::vector<Planner*>::iterator i = _planners.begin(); i != _planners.end() && !planner; ++i)
+	{
+		if (!(*i)->busy)
+		{
+			planner = *i;
+		}
+	}
+	if (!planner)
+	{
+		// more threads showed up than expected
+		planner = new Planner;
+		planner->pathfinding = new Pathfinding(_save);
+		planner->analysis = new AIAnalysis(_save, planner->pathfinding);
+		_planners.push_back(planner);
+	}
+	planner->busy = true;
+	if (_mutex)
+	{
+		SDL_mutexV(_mutex);
+	}
+	return planner;
+}
+
+/**
+ * Lets other tasks plan with a pathfinding and analysis again.
+ * @param planner Pointer to the planner.
+ */
+void AIPlanner::release(Planner *planner)
+{
+	if (_mutex)
+	{
+		SDL_mutexP(_mutex);
+	}
+	planner->busy = false;
+	if (_mutex)
+	{
+		SDL_mutexV(_mutex);
+	}
+}
+
+/**
+ * Lets one unit of a job think on its copy of the AI.
+ * Runs on the worker threads, so it must leave the battle alone.
+ * @param data Pointer to the job.
+ * @param task Index of the unit in the job.
+ */
+void AIPlanner::planTask(void *data, int task)
+{
+	PlanJob *job = (PlanJob*)data;
+	Plan *plan = job->plans[task];
+	Planner *planner = job->planner->acquire();
+	plan->ai->startPlanning(planner->pathfinding, planner->analysis);
+	plan->action.actor = job->units[task];
+	plan->action.number = 1;
+	plan->ai->think(&plan->action);
+	job->planner->release(planner);
+}
+
+/**
+ * Plans the first move of a unit and every unit after it on
+ * the same side, all at once, and notes down the battle as
+ * it was so the plans can be checked before they're used.
+ * @param first Pointer to the unit about to think.
+ */
+void AIPlanner::plan(BattleUnit *first)
+{
+	discard();
+	_turn = _save->getTurn();
+	_side = _save->getSide();
+
+	PlanJob job;
+	job.planner = this;
+	std::vector<BattleUnit*> *units = _save->getUnits();
+	for (std::vector<BattleUnit*>::iterator i = std::find(units->begin(), units->end(), first); i != units->end(); ++i)
+	{
+		AlienBAIState *ai = dynamic_cast<AlienBAIState*>((*i)->getCurrentAIState());
+		if (!ai || (*i)->getFaction() != _side)
+		{
+			continue;
+		}
+		if (*i != first && ((*i)->isOut() || !(*i)->reselectAllowed() || (*i)->getTimeUnits() <= 5))
+		{
+			continue;
+		}
+		Plan &plan = _plans[*i];
+		plan.ai = 0;
+		if (*i != first && needsReload(*i))
+		{
+			// leave it to think on the battle when its go comes
+			continue;
+		}
+		ai->useRandom(_save->getSeed());
+		plan.ai = new AlienBAIState(*ai);
+		plan.visible = *(*i)->getVisibleUnits();
+		job.units.push_back(*i);
+		job.plans.push_back(&plan);
+	}
+
+	_units = *units;
+	_records.clear();
+	for (std::vector<BattleUnit*>::iterator i = units->begin(); i != units->end(); ++i)
+	{
+		_records.push_back(UnitRecord(*i));
+	}
+	_allocated.clear();
+	for (std::vector<Node*>::iterator i = _save->getNodes()->begin(); i != _save->getNodes()->end(); ++i)
+	{
+		_allocated.push_back((*i)->isAllocated());
+	}
+	_terrainStamp = Tile::getTerrainChanges();
+	_fireStamp = Tile::getFireChanges();
+	_hazardStamp = Tile::getHazardChanges();
+
+	if (job.units.empty())
+	{
+		return;
+	}
+	// the workers only read the voxel grid
+	_save->getTileEngine()->updateVoxels();
+	int tasks = job.units.size();
+	if (_mutex)
+	{
+		preparePlanners(std::min(tasks, ThreadPool::getShared()->getThreadCount()));
+		ThreadPool::getShared()->run(planTask, &job, tasks);
+	}
+	else
+	{
+		preparePlanners(1);
+		for (int i = 0; i < tasks; ++i)
+		{
+			planTask(&job, i);
+		}
+	}
+
+	for (std::vector<Plan*>::iterator i = job.plans.begin(); i != job.plans.end(); ++i)
+	{
+		if ((*i)->ai->isPlanSerial())
+		{
+			delete (*i)->ai;
+			(*i)->ai = 0;
+		}
+	}
+}
+
+/**
+ * Checks if nothing the plan could have looked at changed
+ * since it was made: the unit itself, the units and terrain
+ * around it, fire, smoke and grenades anywhere, and the other
+ * side and the patrol nodes if it looked across the map.
+ * @param unit Pointer to the unit.
+ * @param plan The unit's plan.
+ * @return True if the plan still holds.
+ */
+bool AIPlanner::isValid(BattleUnit *unit, const Plan &plan) const
+{
+	if (_turn != _save->getTurn() || _side != _save->getSide() || _units != *_save->getUnits() ||
+		_fireStamp != Tile::getFireChanges() || _hazardStamp != Tile::getHazardChanges())
+	{
+		return false;
+	}
+	if (plan.visible != *unit->getVisibleUnits())
+	{
+		return false;
+	}
+	size_t self = std::find(_units.begin(), _units.end(), unit) - _units.begin();
+	if (self == _units.size())
+	{
+		return false;
+	}
+	UnitRecord now(unit);
+	// the unit is hidden right before it thinks
+	now.visible = _records[self].visible;
+	if (now != _records[self])
+	{
+		return false;
+	}
+
+	bool global = plan.ai->isPlanGlobal();
+	if (global)
+	{
+		if (_terrainStamp != Tile::getTerrainChanges() || _allocated.size() != _save->getNodes()->size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < _allocated.size(); ++i)
+		{
+			if (_allocated[i] != _save->getNodes()->at(i)->isAllocated())
+			{
+				return false;
+			}
+		}
+	}
+	else if (_save->getTileEngine()->terrainChangeDistanceSq(unit->getPosition(), PLAN_RANGE, _terrainStamp) != INT_MAX)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < _units.size(); ++i)
+	{
+		if (i == self || !(UnitRecord(_units[i]) != _records[i]))
+		{
+			continue;
+		}
+		if (global || _records[i].faction != _side || _units[i]->getFaction() != _side)
+		{
+			return false;
+		}
+		if (_save->getTileEngine()->distance(_records[i].pos, unit->getPosition()) <= PLAN_RANGE ||
+			_save->getTileEngine()->distance(_units[i]->getPosition(), unit->getPosition()) <= PLAN_RANGE)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Lets an alien think on the worker threads' plans: the first
+ * alien without a plan gets the others planned along with it,
+ * and the plan is used if it still holds, otherwise the alien
+ * thinks again on the battle from the same random state.
+ * @param unit Pointer to the unit about to think.
+ * @param action Pointer to the action to fill in.
+ * @return False if the unit should just think on the battle.
+ */
+bool AIPlanner::think(BattleUnit *unit, BattleAction *action)
+{
+	AlienBAIState *ai = dynamic_cast<AlienBAIState*>(unit->getCurrentAIState());
+	if (!Options::parallelAI || Options::traceAI || !ai || _save->getSide() != FACTION_HOSTILE || unit->getFaction() != FACTION_HOSTILE)
+	{
+		discard();
+		return false;
+	}
+	if (_turn != _save->getTurn() || _side != _save->getSide())
+	{
+		discard();
+	}
+	ai->useRandom(_save->getSeed());
+	unit->checkAmmo();
+	if (action->number == 1 && _plans.find(unit) == _plans.end())
+	{
+		plan(unit);
+	}
+
+	std::map<BattleUnit*, Plan>::iterator i = _plans.find(unit);
+	if (i != _plans.end())
+	{
+		Plan plan = i->second;
+		_plans.erase(i);
+		if (plan.ai && action->number == 1 && isValid(unit, plan))
+		{
+			plan.ai->finishPlanning();
+			unit->setAIState(plan.ai);
+			*action = plan.action;
+			return true;
+		}
+		delete plan.ai;
+	}
+	ai->think(action);
+	return true;
+}
+
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_AIPLANNER_H
+#define OPENXCOM_AIPLANNER_H
+
+#include <vector>
+#include <map>
+#include <SDL_thread.h>
+#include "Position.h"
+#include "BattlescapeGame.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class BattleUnit;
+class BattleItem;
+class AlienBAIState;
+class Pathfinding;
+class AIAnalysis;
+
+/**
+ * Thinks ahead for the aliens during their turn. When an alien
+ * is about to think and has no plan yet, it and every alien after
+ * it in the unit list think at once on the worker threads, each on
+ * a copy of its AI with its own pathfinding, its own analysis and
+ * its own random stream seeded from the battle seed, while the
+ * battle itself is only read. The plans are then used one by one
+ * in unit order as each alien gets its go. If anything the plan
+ * could have looked at changed in the meantime, the alien thinks
+ * again on the battle, from the same point in its random stream.
+ * Either way what the aliens do only depends on the battle and
+ * its seed, not on the number of threads or how fast they are.
+ */
+class AIPlanner
+{
+private:
+	/// What a unit looked like when the plans were made.
+	struct UnitRecord
+	{
+		Position pos;
+		int direction, status, faction, tu, energy, health, stun, morale, turnsSinceSpotted, spotted, rounds;
+		bool visible, kneeled;
+		BattleUnit *charging;
+		BattleItem *weapon, *ammo;
+		UnitRecord(BattleUnit *unit);
+		bool operator!=(const UnitRecord &other) const;
+	};
+	/// A plan waiting for its unit's go.
+	struct Plan
+	{
+		AlienBAIState *ai;
+		BattleAction action;
+		std::vector<BattleUnit*> visible;
+	};
+	/// What a thread plans with.
+	struct Planner
+	{
+		Pathfinding *pathfinding;
+		AIAnalysis *analysis;
+		bool busy;
+	};
+	struct PlanJob;
+	// as far as a unit can walk, look or throw from where it stands
+	static const int PLAN_RANGE = 32;
+	SavedBattleGame *_save;
+	Pathfinding *_battlePathfinding;
+	std::vector<Planner*> _planners;
+	SDL_mutex *_mutex;
+	std::map<BattleUnit*, Plan> _plans;
+	std::vector<BattleUnit*> _units;
+	std::vector<UnitRecord> _records;
+	std::vector<bool> _allocated;
+	int _turn, _side;
+	unsigned int _terrainStamp, _fireStamp, _hazardStamp;
+	/// Checks if a unit would reload before thinking.
+	static bool needsReload(BattleUnit *unit);
+	/// Throws away the plans.
+	void discard();
+	/// Makes sure there's something to plan with for each thread.
+	void preparePlanners(int threads);
+	/// Takes something free to plan with.
+	Planner *acquire();
+	/// Gives back what a task planned with.
+	void release(Planner *planner);
+	/// Plans one unit of a job.
+	static void planTask(void *data, int task);
+	/// Plans a unit and the ones after it.
+	void plan(BattleUnit *first);
+	/// Checks if a plan still holds.
+	bool isValid(BattleUnit *unit, const Plan &plan) const;
+public:
+	/// Creates a planner for a battle.
+	AIPlanner(SavedBattleGame *save);
+	/// Cleans up the planner.
+	~AIPlanner();
+	/// Lets a unit think, using its plan if it still holds.
+	bool think(BattleUnit *unit, BattleAction *action);
+};
+
+}
+
+#endif
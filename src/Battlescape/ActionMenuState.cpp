@@ -248,6 +248,7 @@ void ActionMenuState::btnActionMenuItemClick(Action *action)
 			}
 			if (!targetUnit)
 			{
+				_game->getSavedGame()->getSavedBattle()->getTileEngine()->updateVoxels();
 				if (_game->getSavedGame()->getSavedBattle()->getTileEngine()->validMeleeRange(
 					_action->actor->getPosition(),
 					_action->actor->getDirection(),
@@ -305,6 +306,7 @@ void ActionMenuState::btnActionMenuItemClick(Action *action)
 		}
 		else if (_action->type == BA_HIT)
 		{
+			_game->getSavedGame()->getSavedBattle()->getTileEngine()->updateVoxels();
 			// check beforehand if we have enough time units
 			if (_action->TU > _action->actor->getTimeUnits())
 			{
@@ -20,6 +20,7 @@
 #include <cmath>
 #include <climits>
 #include <algorithm>
+#include <set>
 #include "AlienBAIState.h"
 #include "../Savegame/BattleUnit.h"
 #include "../Savegame/BattleItem.h"
@@ -31,6 +32,7 @@
 #include "BattlescapeState.h"
 #include "../Savegame/Tile.h"
 #include "Pathfinding.h"
+#include "AIAnalysis.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Logger.h"
 #include "../Engine/Game.h"
@@ -50,7 +52,9 @@ namespace OpenXcom
  */
 AlienBAIState::AlienBAIState(SavedBattleGame *save, BattleUnit *unit, Node *node) : BattleAIState(save, unit), _aggroTarget(0), _knownEnemies(0), _visibleEnemies(0), _spottingEnemies(0),
 																				_escapeTUs(0), _ambushTUs(0), _reserveTUs(0), _rifle(false), _melee(false), _blaster(false),
-																				_didPsi(false), _AIMode(AI_PATROL), _closestDist(100), _fromNode(node), _toNode(0)
+																				_didPsi(false), _AIMode(AI_PATROL), _closestDist(100), _fromNode(node), _toNode(0),
+																				_random(0), _pathfinding(0), _analysis(0), _planning(false), _planSerial(false), _planGlobal(false), _planHiding(false),
+																				_planCharging(0), _planTUs(0), _planNode(0)
 {
 	_traceAI = Options::traceAI;
 
@@ -63,6 +67,31 @@ AlienBAIState::AlienBAIState(SavedBattleGame *save, BattleUnit *unit, Node *node
 	_psiAction = new BattleAction();
 }
 
+/**
+ * Copies an AI state, so the unit can think ahead on the
+ * copy while its own state stays as it is.
+ * @param other AI state to copy.
+ */
+AlienBAIState::AlienBAIState(const AlienBAIState &other) : BattleAIState(other._save, other._unit), _aggroTarget(other._aggroTarget),
+																				_knownEnemies(other._knownEnemies), _visibleEnemies(other._visibleEnemies), _spottingEnemies(other._spottingEnemies),
+																				_escapeTUs(other._escapeTUs), _ambushTUs(other._ambushTUs), _reserveTUs(other._reserveTUs),
+																				_rifle(other._rifle), _melee(other._melee), _blaster(other._blaster), _traceAI(other._traceAI), _didPsi(other._didPsi),
+																				_AIMode(other._AIMode), _intelligence(other._intelligence), _closestDist(other._closestDist), _fromNode(other._fromNode), _toNode(other._toNode),
+																				_reachable(other._reachable), _reachableWithAttack(other._reachableWithAttack), _wasHitBy(other._wasHitBy), _reserve(other._reserve),
+																				_random(0), _pathfinding(0), _analysis(0), _planning(false), _planSerial(false), _planGlobal(false), _planHiding(false),
+																				_planCharging(0), _planTUs(0), _planNode(0)
+{
+	_escapeAction = new BattleAction(*other._escapeAction);
+	_ambushAction = new BattleAction(*other._ambushAction);
+	_attackAction = new BattleAction(*other._attackAction);
+	_patrolAction = new BattleAction(*other._patrolAction);
+	_psiAction = new BattleAction(*other._psiAction);
+	if (other._random)
+	{
+		_random = new RNG::RandomState(*other._random);
+	}
+}
+
 /**
  * Deletes the BattleAIState.
  */
@@ -73,6 +102,7 @@ AlienBAIState::~AlienBAIState()
 	delete _attackAction;
 	delete _patrolAction;
 	delete _psiAction;
+	delete _random;
 }
 
 /**
@@ -94,6 +124,12 @@ void AlienBAIState::load(const YAML::Node &node)
 	{
 		_toNode = _save->getNodes()->at(toNodeID);
 	}
+	if (node["random"])
+	{
+		delete _random;
+		_random = new RNG::RandomState(0, 0);
+		_random->setSeed(node["random"].as<uint64_t>());
+	}
 }
 
 /**
@@ -113,6 +149,10 @@ YAML::Node AlienBAIState::save() const
 	node["toNode"] = toNodeID;
 	node["AIMode"] = _AIMode;
 	node["wasHitBy"] = _wasHitBy;
+	if (_random)
+	{
+		node["random"] = _random->getSeed();
+	}
 	return node;
 }
 
@@ -148,18 +188,23 @@ void AlienBAIState::think(BattleAction *action)
 	_attackAction->weapon = action->weapon;
 	_attackAction->number = action->number;
 	_escapeAction->number = action->number;
+	getAnalysis()->update();
+	if (!_planning)
+	{
+		_save->getTileEngine()->updateVoxels();
+	}
 	_knownEnemies = countKnownTargets();
 	_visibleEnemies = selectNearestTarget();
 	_spottingEnemies = getSpottingUnits(_unit->getPosition());
 	_melee = _unit->getMeleeWeapon() != 0;
 	_rifle = false;
 	_blaster = false;
-	_reachable = _save->getPathfinding()->findReachable(_unit, _unit->getTimeUnits());
+	_reachable = getAnalysis()->findReachable(_unit, _unit->getTimeUnits());
 	_wasHitBy.clear();
 
-	if (_unit->getCharging() && _unit->getCharging()->isOut())
+	if (getCharging() && getCharging()->isOut())
 	{
-		_unit->setCharging(0);
+		setCharging(0);
 	}
 
 	if (_traceAI)
@@ -194,18 +239,18 @@ void AlienBAIState::think(BattleAction *action)
 				if (!rule->isWaypoint())
 				{
 					_rifle = true;
-					_reachableWithAttack = _save->getPathfinding()->findReachable(_unit, _unit->getTimeUnits() - _unit->getActionTUs(BA_SNAPSHOT, action->weapon));
+					_reachableWithAttack = getAnalysis()->findReachable(_unit, _unit->getTimeUnits() - _unit->getActionTUs(BA_SNAPSHOT, action->weapon));
 				}
 				else
 				{
 					_blaster = true;
-					_reachableWithAttack = _save->getPathfinding()->findReachable(_unit, _unit->getTimeUnits() - _unit->getActionTUs(BA_AIMEDSHOT, action->weapon));
+					_reachableWithAttack = getAnalysis()->findReachable(_unit, _unit->getTimeUnits() - _unit->getActionTUs(BA_AIMEDSHOT, action->weapon));
 				}
 			}
 			else if (rule->getBattleType() == BT_MELEE)
 			{
 				_melee = true;
-				_reachableWithAttack = _save->getPathfinding()->findReachable(_unit, _unit->getTimeUnits() - _unit->getActionTUs(BA_HIT, action->weapon));
+				_reachableWithAttack = getAnalysis()->findReachable(_unit, _unit->getTimeUnits() - _unit->getActionTUs(BA_HIT, action->weapon));
 			}
 		}
 		else
@@ -252,7 +297,7 @@ void AlienBAIState::think(BattleAction *action)
 	}
 	else if (_AIMode == AI_PATROL)
 	{
-		if (_spottingEnemies || _visibleEnemies || _knownEnemies || RNG::percent(10))
+		if (_spottingEnemies || _visibleEnemies || _knownEnemies || percent(10))
 		{
 			evaluate = true;
 		}
@@ -315,7 +360,7 @@ void AlienBAIState::think(BattleAction *action)
 	switch (_AIMode)
 	{
 	case AI_ESCAPE:
-		_unit->setCharging(0);
+		setCharging(0);
 		action->type = _escapeAction->type;
 		action->target = _escapeAction->target;
 		// end this unit's turn.
@@ -323,10 +368,17 @@ void AlienBAIState::think(BattleAction *action)
 		// ignore new targets.
 		action->desperate = true;
 		// spin 180 at the end of your route.
-		_unit->setHiding(true);
+		if (_planning)
+		{
+			_planHiding = true;
+		}
+		else
+		{
+			_unit->setHiding(true);
+		}
 		break;
 	case AI_PATROL:
-		_unit->setCharging(0);
+		setCharging(0);
 		if (action->weapon && action->weapon->getRules()->getBattleType() == BT_FIREARM)
 		{
 			switch (_unit->getAggression())
@@ -353,7 +405,14 @@ void AlienBAIState::think(BattleAction *action)
 		action->weapon = _attackAction->weapon;
 		if (action->weapon && action->type == BA_THROW && action->weapon->getRules()->getBattleType() == BT_GRENADE)
 		{
-			_unit->spendTimeUnits(4 + _unit->getActionTUs(BA_PRIME, action->weapon));
+			if (_planning)
+			{
+				_planTUs += 4 + _unit->getActionTUs(BA_PRIME, action->weapon);
+			}
+			else
+			{
+				_unit->spendTimeUnits(4 + _unit->getActionTUs(BA_PRIME, action->weapon));
+			}
 		}
 		// if this is a firepoint action, set our facing.
 		action->finalFacing = _attackAction->finalFacing;
@@ -371,7 +430,7 @@ void AlienBAIState::think(BattleAction *action)
 		}
 		break;
 	case AI_AMBUSH:
-		_unit->setCharging(0);
+		setCharging(0);
 		action->type = _ambushAction->type;
 		action->target = _ambushAction->target;
 		// face where we think our target will appear.
@@ -427,6 +486,13 @@ void AlienBAIState::setupPatrol()
 	_patrolAction->TU = 0;
 	if (_toNode != 0 && _unit->getPosition() == _toNode->getPosition())
 	{
+		if (_planning)
+		{
+			// freeing the node and peeking through the window change the battle
+			_planSerial = true;
+			_patrolAction->type = BA_RETHINK;
+			return;
+		}
 		if (_traceAI)
 		{
 			Log(LOG_INFO) << "Patrol destination reached!";
@@ -470,6 +536,8 @@ void AlienBAIState::setupPatrol()
 
 	while (_toNode == 0 && triesLeft)
 	{
+		// any node on the map could be picked
+		_planGlobal = true;
 		triesLeft--;
 		// look for a new node to walk towards
 		bool scout = true;
@@ -539,27 +607,34 @@ void AlienBAIState::setupPatrol()
 
 		if (_toNode == 0)
 		{
-			_toNode = _save->getPatrolNode(scout, _unit, _fromNode);
+			_toNode = _save->getPatrolNode(scout, _unit, _fromNode, getPathfinding(), _random);
 			if (_toNode == 0)
 			{
-				_toNode = _save->getPatrolNode(!scout, _unit, _fromNode);
+				_toNode = _save->getPatrolNode(!scout, _unit, _fromNode, getPathfinding(), _random);
 			}
 		}
 
 		if (_toNode != 0)
 		{
-			_save->getPathfinding()->calculate(_unit, _toNode->getPosition());
-			if (_save->getPathfinding()->getStartDirection() == -1)
+			getPathfinding()->calculate(_unit, _toNode->getPosition());
+			if (getPathfinding()->getStartDirection() == -1)
 			{
 				_toNode = 0;
 			}
-			_save->getPathfinding()->abortPath();
+			getPathfinding()->abortPath();
 		}
 	}
 
 	if (_toNode != 0)
 	{
-		_toNode->allocateNode();
+		if (_planning)
+		{
+			_planNode = _toNode;
+		}
+		else
+		{
+			_toNode->allocateNode();
+		}
 		_patrolAction->actor = _unit;
 		_patrolAction->type = BA_WALK;
 		_patrolAction->target = _toNode->getPosition();
@@ -611,18 +686,18 @@ void AlienBAIState::setupAmbush()
 			// make sure we can't be seen here.
 			if (!_save->getTileEngine()->canTargetUnit(&origin, tile, &target, _aggroTarget, _unit) && !getSpottingUnits(pos))
 			{
-				_save->getPathfinding()->calculate(_unit, pos);
-				int ambushTUs = _save->getPathfinding()->getTotalTUCost();
+				getPathfinding()->calculate(_unit, pos);
+				int ambushTUs = getPathfinding()->getTotalTUCost();
 				// make sure we can move here
-				if (_save->getPathfinding()->getStartDirection() != -1)
+				if (getPathfinding()->getStartDirection() != -1)
 				{
 					int score = BASE_SYSTEMATIC_SUCCESS;
 					score -= ambushTUs;
 
 					// make sure our enemy can reach here too.
-					_save->getPathfinding()->calculate(_aggroTarget, pos);
+					getPathfinding()->calculate(_aggroTarget, pos);
 
-					if (_save->getPathfinding()->getStartDirection() != -1)
+					if (getPathfinding()->getStartDirection() != -1)
 					{
 						// ideally we'd like to be behind some cover, like say a window or a low wall.
 						if (_save->getTileEngine()->faceWindow(pos) != -1)
@@ -631,7 +706,7 @@ void AlienBAIState::setupAmbush()
 						}
 						if (score > bestScore)
 						{
-							path = _save->getPathfinding()->copyPath();
+							path = getPathfinding()->copyPath();
 							bestScore = score;
 							_ambushTUs = (pos == _unit->getPosition()) ? 1 : ambushTUs;
 							_ambushAction->target = pos;
@@ -653,13 +728,13 @@ void AlienBAIState::setupAmbush()
 				// 4 because -2 is eyes and 2 below that is the rifle (or at least that's my understanding)
 				Position(8,8, _unit->getHeight() + _unit->getFloatHeight() - _save->getTile(_ambushAction->target)->getTerrainLevel() - 4);
 			Position currentPos = _aggroTarget->getPosition();
-			_save->getPathfinding()->setUnit(_aggroTarget);
+			getPathfinding()->setUnit(_aggroTarget);
 			Position nextPos;
 			size_t tries = path.size();
 			// hypothetically walk the target through the path.
 			while (tries > 0)
 			{
-				_save->getPathfinding()->getTUCost(currentPos, path.back(), &nextPos, _aggroTarget, 0, false);
+				getPathfinding()->getTUCost(currentPos, path.back(), &nextPos, _aggroTarget, 0, false);
 				path.pop_back();
 				currentPos = nextPos;
 				Tile *tile = _save->getTile(currentPos);
@@ -749,7 +824,7 @@ void AlienBAIState::setupAttack()
 		}
 		return;
 	}
-	else if (_spottingEnemies || _unit->getAggression() < RNG::generate(0, 3))
+	else if (_spottingEnemies || _unit->getAggression() < generate(0, 3))
 	{
 		// if enemies can see us, or if we're feeling lucky, we can try to spot the enemy.
 		if (findFirePoint())
@@ -796,9 +871,11 @@ void AlienBAIState::setupEscape()
 	const int BASE_SYSTEMATIC_SUCCESS = 100;
 	const int BASE_DESPERATE_SUCCESS = 110;
 	const int FAST_PASS_THRESHOLD = 100; // a score that's good enough to quit the while loop early; it's subjective, hand-tuned and may need tweaking
+	const int SPOTTER_BATCH = 16; // how many tiles of the systematic search to count spotters for at once
 
 	std::vector<Position> randomTileSearch = _save->getTileSearch();
-	RNG::shuffle(randomTileSearch);
+	shuffle(randomTileSearch);
+	std::set<int> reachable(_reachable.begin(), _reachable.end());
 	
 	while (tries < 150 && !coverFound)
 	{
@@ -822,6 +899,20 @@ void AlienBAIState::setupEscape()
 		}
 		else if (tries < 121) 
 		{
+			// count who'd see us on the next few reachable tiles all at once, as the search gets to them
+			if (tries % SPOTTER_BATCH == 0)
+			{
+				std::vector<Position> batch;
+				for (int i = tries; i < tries + SPOTTER_BATCH && i < 121; ++i)
+				{
+					Position pos = _unit->getPosition() + Position(randomTileSearch[i].x, randomTileSearch[i].y, 0);
+					if (_save->getTile(pos) && reachable.find(_save->getTileIndex(pos)) != reachable.end())
+					{
+						batch.push_back(pos);
+					}
+				}
+				prepareSpotters(batch);
+			}
 			// looking for cover
 			_escapeAction->target.x += randomTileSearch[tries].x;
 			_escapeAction->target.y += randomTileSearch[tries].y;
@@ -831,8 +922,8 @@ void AlienBAIState::setupEscape()
 				if (unitsSpottingMe > 0)
 				{
 					// maybe don't stay in the same spot? move or something if there's any point to it?
-					_escapeAction->target.x += RNG::generate(-20,20);
-					_escapeAction->target.y += RNG::generate(-20,20);
+					_escapeAction->target.x += generate(-20,20);
+					_escapeAction->target.y += generate(-20,20);
 				}
 				else
 				{
@@ -853,9 +944,9 @@ void AlienBAIState::setupEscape()
 						
 			score = BASE_DESPERATE_SUCCESS; // ruuuuuuun
 			_escapeAction->target = _unit->getPosition();
-			_escapeAction->target.x += RNG::generate(-10,10);
-			_escapeAction->target.y += RNG::generate(-10,10);
-			_escapeAction->target.z = _unit->getPosition().z + RNG::generate(-1,1);
+			_escapeAction->target.x += generate(-10,10);
+			_escapeAction->target.y += generate(-10,10);
+			_escapeAction->target.z = _unit->getPosition().z + generate(-1,1);
 			if (_escapeAction->target.z < 0)
 			{
 				_escapeAction->target.z = 0;
@@ -886,9 +977,9 @@ void AlienBAIState::setupEscape()
 		}
 		else
 		{
-			spotters = getSpottingUnits(_escapeAction->target);
-			if (std::find(_reachable.begin(), _reachable.end(), _save->getTileIndex(_escapeAction->target))  == _reachable.end())
+			if (reachable.find(_save->getTileIndex(_escapeAction->target)) == reachable.end())
 				continue; // just ignore unreachable tiles
+			spotters = getSpottingUnits(_escapeAction->target);
 					
 			if (_spottingEnemies || spotters)
 			{
@@ -922,12 +1013,12 @@ void AlienBAIState::setupEscape()
 		if (tile && score > bestTileScore)
 		{
 			// calculate TUs to tile; we could be getting this from findReachable() somehow but that would break something for sure...
-			_save->getPathfinding()->calculate(_unit, _escapeAction->target);
-			if (_escapeAction->target == _unit->getPosition() || _save->getPathfinding()->getStartDirection() != -1)
+			getPathfinding()->calculate(_unit, _escapeAction->target);
+			if (_escapeAction->target == _unit->getPosition() || getPathfinding()->getStartDirection() != -1)
 			{
 				bestTileScore = score;
 				bestTile = _escapeAction->target;
-				_escapeTUs = _save->getPathfinding()->getTotalTUCost();
+				_escapeTUs = getPathfinding()->getTotalTUCost();
 				if (_escapeAction->target == _unit->getPosition())
 				{
 					_escapeTUs = 1;
@@ -939,7 +1030,7 @@ void AlienBAIState::setupEscape()
 					tile->setTUMarker(score);
 				}
 			}
-			_save->getPathfinding()->abortPath();
+			getPathfinding()->abortPath();
 			if (bestTileScore > FAST_PASS_THRESHOLD) coverFound = true; // good enough, gogogo
 		}
 	}
@@ -992,9 +1083,31 @@ int AlienBAIState::countKnownTargets() const
  */
 int AlienBAIState::getSpottingUnits(Position pos) const
 {
+	int tally = 0;
+	if (_save->getTile(pos) && getAnalysis()->getSpotters(_unit, pos, &tally))
+	{
+		return tally;
+	}
+	tally = countSpottingUnits(pos);
+	if (_save->getTile(pos))
+	{
+		getAnalysis()->setSpotters(_unit, pos, tally);
+	}
+	return tally;
+}
+
+/**
+ * Counts the known units that could see this unit at a position,
+ * without going through the cache. Only reads the battle, so it
+ * can be run on several positions at once.
+ * @param pos The position to check.
+ * @return The number of units spotting that position.
+ */
+int AlienBAIState::countSpottingUnits(Position pos) const
+{
+	int tally = 0;
 	// if we don't actually occupy the position being checked, we need to do a virtual LOF check.
 	bool checking = pos != _unit->getPosition();
-	int tally = 0;
 	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
 	{
 		if (validTarget(*i, false, false))
@@ -1023,6 +1136,65 @@ int AlienBAIState::getSpottingUnits(Position pos) const
 	return tally;
 }
 
+/**
+ * Positions to count spotters for on the worker threads.
+ */
+struct SpotterJob
+{
+	const AlienBAIState *ai;
+	std::vector<Position> positions;
+	std::vector<int> tallies;
+};
+
+/**
+ * Counts the spotters of one position of a job.
+ * @param data Pointer to the SpotterJob.
+ * @param task Index of the position.
+ */
+void AlienBAIState::spotterTask(void *data, int task)
+{
+	SpotterJob *job = (SpotterJob*)data;
+	job->tallies[task] = job->ai->countSpottingUnits(job->positions[task]);
+}
+
+/**
+ * Counts the spotters of a batch of positions up front, spread
+ * over the line of sight threads, so a search over them only
+ * has to look them up. Positions already known are skipped. The results are stored in the order
+ * of the positions, the same as if they were counted one by one.
+ * @param positions Positions that are about to be checked.
+ */
+void AlienBAIState::prepareSpotters(const std::vector<Position> &positions)
+{
+	if (_planning)
+	{
+		// the threads are already busy planning
+		return;
+	}
+	SpotterJob job;
+	job.ai = this;
+	int tally = 0;
+	std::set<int> queued;
+	for (std::vector<Position>::const_iterator i = positions.begin(); i != positions.end(); ++i)
+	{
+		if (_save->getTile(*i) && !getAnalysis()->getSpotters(_unit, *i, &tally) &&
+			queued.insert(_save->getTileIndex(*i)).second)
+		{
+			job.positions.push_back(*i);
+		}
+	}
+	if (job.positions.empty())
+	{
+		return;
+	}
+	job.tallies.resize(job.positions.size(), 0);
+	_save->getTileEngine()->runChecks(spotterTask, &job, job.positions.size());
+	for (size_t i = 0; i < job.positions.size(); ++i)
+	{
+		getAnalysis()->setSpotters(_unit, job.positions[i], job.tallies[i]);
+	}
+}
+
 /**
  * Selects the nearest known living target we can see/reach and returns the number of visible enemies.
  * This function includes civilians as viable targets.
@@ -1114,7 +1286,7 @@ bool AlienBAIState::selectRandomTarget()
 	{
 		if (validTarget(*i, true, true))
 		{
-			int dist = RNG::generate(0,20) - _save->getTileEngine()->distance(_unit->getPosition(), (*i)->getPosition());
+			int dist = generate(0,20) - _save->getTileEngine()->distance(_unit->getPosition(), (*i)->getPosition());
 			if (dist > farthest)
 			{
 				farthest = dist;
@@ -1150,18 +1322,18 @@ bool AlienBAIState::selectPointNearTarget(BattleUnit *target, int maxTUs) const
 						continue;
 					int dir = _save->getTileEngine()->getDirectionTo(checkPath, target->getPosition());
 					bool valid = _save->getTileEngine()->validMeleeRange(checkPath, dir, _unit, target, 0);
-					bool fitHere = _save->setUnitPosition(_unit, checkPath, true);
+					bool fitHere = _save->setUnitPosition(_unit, checkPath, true, getPathfinding());
 
 					if (valid && fitHere && !_save->getTile(checkPath)->getDangerous())
 					{
-						_save->getPathfinding()->calculate(_unit, checkPath, 0, maxTUs);
-						if (_save->getPathfinding()->getStartDirection() != -1 && _save->getPathfinding()->getPath().size() < distance)
+						getPathfinding()->calculate(_unit, checkPath, 0, maxTUs);
+						if (getPathfinding()->getStartDirection() != -1 && getPathfinding()->getPath().size() < distance)
 						{
 							_attackAction->target = checkPath;
 							returnValue = true;
-							distance = _save->getPathfinding()->getPath().size();
+							distance = getPathfinding()->getPath().size();
 						}
-						_save->getPathfinding()->abortPath();
+						getPathfinding()->abortPath();
 					}
 				}
 			}
@@ -1175,7 +1347,7 @@ bool AlienBAIState::selectPointNearTarget(BattleUnit *target, int maxTUs) const
  */
 void AlienBAIState::evaluateAIMode()
 {
-	if (_unit->getCharging() && _attackAction->type != BA_RETHINK)
+	if (getCharging() && _attackAction->type != BA_RETHINK)
 	{
 		_AIMode = AI_COMBAT;
 		return;
@@ -1186,7 +1358,7 @@ void AlienBAIState::evaluateAIMode()
 	{
 		escapeOdds = 12;
 	}
-	if (_unit->getTimeUnits() > _unit->getBaseStats()->tu / 2 || _unit->getCharging())
+	if (_unit->getTimeUnits() > _unit->getBaseStats()->tu / 2 || getCharging())
 	{
 		escapeOdds = 5;
 	}
@@ -1339,7 +1511,7 @@ void AlienBAIState::evaluateAIMode()
 	}
 
 	// generate a random number to represent our decision.
-	int decision = RNG::generate(1, std::max(1, patrolOdds + ambushOdds + escapeOdds + combatOdds));
+	int decision = generate(1, std::max(1, patrolOdds + ambushOdds + escapeOdds + combatOdds));
 
 	if (decision > escapeOdds)
 	{
@@ -1365,7 +1537,7 @@ void AlienBAIState::evaluateAIMode()
 	}
 
 	// if the aliens are cheating, or the unit is charging, enforce combat as a priority.
-	if (_save->isCheating() || _unit->getCharging() != 0)
+	if (_save->isCheating() || getCharging() != 0)
 	{
 		_AIMode = AI_COMBAT;
 	}
@@ -1421,7 +1593,7 @@ bool AlienBAIState::findFirePoint()
 	if (!selectClosestKnownEnemy())
 		return false;
 	std::vector<Position> randomTileSearch = _save->getTileSearch();
-	RNG::shuffle(randomTileSearch);
+	shuffle(randomTileSearch);
 	Position target;
 	const int BASE_SYSTEMATIC_SUCCESS = 100;
 	const int FAST_PASS_THRESHOLD = 125;
@@ -1442,12 +1614,12 @@ bool AlienBAIState::findFirePoint()
 
 		if (_save->getTileEngine()->canTargetUnit(&origin, _aggroTarget->getTile(), &target, _unit))
 		{
-			_save->getPathfinding()->calculate(_unit, pos);
+			getPathfinding()->calculate(_unit, pos);
 			// can move here
-			if (_save->getPathfinding()->getStartDirection() != -1)
+			if (getPathfinding()->getStartDirection() != -1)
 			{
 				score = BASE_SYSTEMATIC_SUCCESS - getSpottingUnits(pos) * 10;
-				score += _unit->getTimeUnits() - _save->getPathfinding()->getTotalTUCost();
+				score += _unit->getTimeUnits() - getPathfinding()->getTotalTUCost();
 				if (!_aggroTarget->checkViewSector(pos))
 				{
 					score += 10;
@@ -1612,7 +1784,7 @@ void AlienBAIState::meleeAction()
 			{
 				_aggroTarget = (*i);
 				_attackAction->type = BA_WALK;
-				_unit->setCharging(_aggroTarget);
+				setCharging(_aggroTarget);
 				distance = newDistance;
 			}
 
@@ -1636,18 +1808,20 @@ void AlienBAIState::meleeAction()
  */
 void AlienBAIState::wayPointAction()
 {
+	// missile paths can go anywhere on the map
+	_planGlobal = true;
 	_aggroTarget = 0;
 	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end() && _aggroTarget == 0; ++i)
 	{
 		if (!validTarget(*i, true, true))
 			continue;
-		_save->getPathfinding()->calculate(_unit, (*i)->getPosition(), *i, -1);
-		if (_save->getPathfinding()->getStartDirection() != -1 &&
+		getPathfinding()->calculate(_unit, (*i)->getPosition(), *i, -1);
+		if (getPathfinding()->getStartDirection() != -1 &&
 			explosiveEfficacy((*i)->getPosition(), _unit, (_unit->getMainHandWeapon()->getAmmoItem()->getRules()->getPower()/20)+1, _attackAction->diff))
 		{
 			_aggroTarget = *i;
 		}
-		_save->getPathfinding()->abortPath();
+		getPathfinding()->abortPath();
 	}
 
 	if (_aggroTarget != 0)
@@ -1668,12 +1842,12 @@ void AlienBAIState::wayPointAction()
 		Position CurrentPosition = _unit->getPosition();
 		Position DirectionVector;
 
-		_save->getPathfinding()->calculate(_unit, _aggroTarget->getPosition(), _aggroTarget, -1);
-		PathDirection = _save->getPathfinding()->dequeuePath();
+		getPathfinding()->calculate(_unit, _aggroTarget->getPosition(), _aggroTarget, -1);
+		PathDirection = getPathfinding()->dequeuePath();
 		while (PathDirection != -1)
 		{
 			LastPosition = CurrentPosition;
-			_save->getPathfinding()->directionToVector(PathDirection, &DirectionVector);
+			getPathfinding()->directionToVector(PathDirection, &DirectionVector);
 			CurrentPosition = CurrentPosition + DirectionVector;
 			Position voxelPosA ((CurrentPosition.x * 16)+8, (CurrentPosition.y * 16)+8, (CurrentPosition.z * 24)+16);
 			Position voxelPosb ((LastWayPoint.x * 16)+8, (LastWayPoint.y * 16)+8, (LastWayPoint.z * 24)+16);
@@ -1693,7 +1867,7 @@ void AlienBAIState::wayPointAction()
 				}
 			}
 
-			PathDirection = _save->getPathfinding()->dequeuePath();
+			PathDirection = getPathfinding()->dequeuePath();
 		}
 		_attackAction->target = _attackAction->waypoints.front();
 		if ((int) _attackAction->waypoints.size() > 6 + (_attackAction->diff * 2) || LastWayPoint != _aggroTarget->getPosition())
@@ -1870,7 +2044,7 @@ bool AlienBAIState::psiAction()
 					+ (((*i)->getBaseStats()->psiSkill > 0) ? (*i)->getBaseStats()->psiSkill * -0.4 : 0)
 					- _save->getTileEngine()->distance((*i)->getPosition(), _unit->getPosition())
 					- ((*i)->getBaseStats()->psiStrength)
-					+ RNG::generate(55, 105);
+					+ generate(55, 105);
 
 				if (chanceToAttackMe > chanceToAttack)
 				{
@@ -1889,7 +2063,7 @@ bool AlienBAIState::psiAction()
 				return false;
 			}
 		}
-		else if (RNG::generate(35, 155) >= chanceToAttack)
+		else if (generate(35, 155) >= chanceToAttack)
 		{
 			return false;
 		}
@@ -1921,7 +2095,7 @@ bool AlienBAIState::psiAction()
 			{
 				controlOdds = 100;
 			}
-			if (RNG::percent(controlOdds))
+			if (percent(controlOdds))
 			{
 				_psiAction->type = BA_MINDCONTROL;
 				_psiAction->target = _aggroTarget->getPosition();
@@ -1942,9 +2116,17 @@ bool AlienBAIState::psiAction()
  */
 void AlienBAIState::meleeAttack()
 {
-	_unit->lookAt(_aggroTarget->getPosition() + Position(_unit->getArmor()->getSize()-1, _unit->getArmor()->getSize()-1, 0), false);
-	while (_unit->getStatus() == STATUS_TURNING)
-		_unit->turn();
+	if (_planning)
+	{
+		// turning to face the target changes the battle
+		_planSerial = true;
+	}
+	else
+	{
+		_unit->lookAt(_aggroTarget->getPosition() + Position(_unit->getArmor()->getSize()-1, _unit->getArmor()->getSize()-1, 0), false);
+		while (_unit->getStatus() == STATUS_TURNING)
+			_unit->turn();
+	}
 	if (_traceAI) { Log(LOG_INFO) << "Attack unit: " << _aggroTarget->getId(); }
 	_attackAction->target = _aggroTarget->getPosition();
 	_attackAction->type = BA_HIT;
@@ -2039,10 +2221,10 @@ void AlienBAIState::selectMeleeOrRanged()
 			meleeOdds += 10 * _unit->getAggression();
 		}
 
-		if (RNG::percent(meleeOdds))
+		if (percent(meleeOdds))
 		{
 			_rifle = false;
-			_reachableWithAttack = _save->getPathfinding()->findReachable(_unit, _unit->getTimeUnits() - _unit->getActionTUs(BA_HIT, meleeWeapon));
+			_reachableWithAttack = getAnalysis()->findReachable(_unit, _unit->getTimeUnits() - _unit->getActionTUs(BA_HIT, meleeWeapon));
 			return;
 		}
 	}
@@ -2107,4 +2289,175 @@ BattleUnit* AlienBAIState::getTarget()
 	return _aggroTarget;
 }
 
+/**
+ * Makes the AI draw its random numbers from a stream of its
+ * own instead of the game's generator, so its decisions don't
+ * depend on who else used the generator before it. The stream
+ * is seeded from the battle seed and the unit ID, and it's
+ * saved along with the AI.
+ * @param seed Battle seed.
+ */
+void AlienBAIState::useRandom(uint64_t seed)
+{
+	if (!_random)
+	{
+		_random = new RNG::RandomState(seed, _unit->getId());
+	}
+}
+
+/**
+ * Starts planning: until the plan is finished, the AI thinks
+ * with its own pathfinding and analysis and only notes down
+ * what it would change on its unit and the nodes, so it can
+ * think on a worker thread while the battle stays untouched.
+ * @param pathfinding Pathfinding to think with.
+ * @param analysis Analysis to think with, working off the same pathfinding.
+ */
+void AlienBAIState::startPlanning(Pathfinding *pathfinding, AIAnalysis *analysis)
+{
+	_pathfinding = pathfinding;
+	_analysis = analysis;
+	_planning = true;
+	_planSerial = false;
+	_planGlobal = false;
+	_planHiding = false;
+	_planCharging = _unit->getCharging();
+	_planTUs = 0;
+	_planNode = 0;
+}
+
+/**
+ * Applies the changes noted down while planning to the unit
+ * and the nodes, and goes back to thinking on the battle.
+ */
+void AlienBAIState::finishPlanning()
+{
+	if (!_planning)
+	{
+		return;
+	}
+	_unit->setCharging(_planCharging);
+	if (_planHiding)
+	{
+		_unit->setHiding(true);
+	}
+	if (_planTUs)
+	{
+		_unit->spendTimeUnits(_planTUs);
+	}
+	if (_planNode)
+	{
+		_planNode->allocateNode();
+	}
+	_pathfinding = 0;
+	_analysis = 0;
+	_planning = false;
+}
+
+/**
+ * Gets whether the plan ran into something that can only be
+ * done on the battle itself, like turning the unit around.
+ * @return True if the unit has to think again on the battle.
+ */
+bool AlienBAIState::isPlanSerial() const
+{
+	return _planSerial;
+}
+
+/**
+ * Gets whether the plan looked further than the area around
+ * the unit, like picking a patrol node or a missile path.
+ * @return True if a change anywhere on the map can spoil the plan.
+ */
+bool AlienBAIState::isPlanGlobal() const
+{
+	return _planGlobal;
+}
+
+/**
+ * Gets the pathfinding the AI thinks with: its own
+ * while planning, the battle's otherwise.
+ * @return Pointer to the pathfinding.
+ */
+Pathfinding *AlienBAIState::getPathfinding() const
+{
+	return _pathfinding ? _pathfinding : _save->getPathfinding();
+}
+
+/**
+ * Gets the analysis the AI thinks with: its own
+ * while planning, the battle's otherwise.
+ * @return Pointer to the analysis.
+ */
+AIAnalysis *AlienBAIState::getAnalysis() const
+{
+	return _analysis ? _analysis : _save->getAIAnalysis();
+}
+
+/**
+ * Gets the unit this unit is charging at, as planned so far.
+ * @return Pointer to the target, or 0 if not charging.
+ */
+BattleUnit *AlienBAIState::getCharging() const
+{
+	return _planning ? _planCharging : _unit->getCharging();
+}
+
+/**
+ * Sets the unit this unit is charging at, or notes
+ * it down for later while planning.
+ * @param target Pointer to the target, or 0 to stop charging.
+ */
+void AlienBAIState::setCharging(BattleUnit *target)
+{
+	if (_planning)
+	{
+		_planCharging = target;
+	}
+	else
+	{
+		_unit->setCharging(target);
+	}
+}
+
+/**
+ * Generates a random integer number within a certain
+ * range, from the AI's stream if it has one.
+ * @param min Minimum number, inclusive.
+ * @param max Maximum number, inclusive.
+ * @return Generated number.
+ */
+int AlienBAIState::generate(int min, int max)
+{
+	return _random ? _random->generate(min, max) : RNG::generate(min, max);
+}
+
+/**
+ * Generates a random percent chance of an event occurring,
+ * from the AI's stream if it has one.
+ * @param value Value percentage (0-100%)
+ * @return True if the chance succeeded.
+ */
+bool AlienBAIState::percent(int value)
+{
+	return _random ? _random->percent(value) : RNG::percent(value);
+}
+
+/**
+ * Shuffles a list of positions randomly, with
+ * the AI's stream if it has one.
+ * @param list The list to randomize.
+ */
+void AlienBAIState::shuffle(std::vector<Position> &list)
+{
+	if (_random)
+	{
+		_random->shuffle(list);
+	}
+	else
+	{
+		RNG::shuffle(list);
+	}
+}
+
 }
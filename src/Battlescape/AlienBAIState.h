@@ -22,6 +22,7 @@
 #include "BattleAIState.h"
 #include "BattlescapeGame.h"
 #include "Position.h"
+#include "../Engine/RNG.h"
 #include <vector>
 
 namespace OpenXcom
@@ -31,6 +32,8 @@ class SavedBattleGame;
 class BattleUnit;
 class BattlescapeState;
 class Node;
+class Pathfinding;
+class AIAnalysis;
 
 /**
  * This class is used by the BattleUnit AI.
@@ -48,9 +51,34 @@ protected:
 	Node *_fromNode, *_toNode;
 	std::vector<int> _reachable, _reachableWithAttack, _wasHitBy;
 	BattleActionType _reserve;
+	RNG::RandomState *_random;
+	Pathfinding *_pathfinding;
+	AIAnalysis *_analysis;
+	bool _planning, _planSerial, _planGlobal, _planHiding;
+	BattleUnit *_planCharging;
+	int _planTUs;
+	Node *_planNode;
+	/// Gets the pathfinding to think with.
+	Pathfinding *getPathfinding() const;
+	/// Gets the analysis to think with.
+	AIAnalysis *getAnalysis() const;
+	/// Gets the unit being charged at.
+	BattleUnit *getCharging() const;
+	/// Sets the unit to charge at.
+	void setCharging(BattleUnit *target);
+	/// Generates a random integer number, inclusive.
+	int generate(int min, int max);
+	/// Generates a percentage chance.
+	bool percent(int value);
+	/// Shuffles a list of positions randomly.
+	void shuffle(std::vector<Position> &list);
+	// Disable assignments.
+	AlienBAIState &operator=(const AlienBAIState &);
 public:
 	/// Creates a new AlienBAIState linked to the game and a certain unit.
 	AlienBAIState(SavedBattleGame *save, BattleUnit *unit, Node *node);
+	/// Creates a copy of an AlienBAIState to plan with.
+	AlienBAIState(const AlienBAIState &other);
 	/// Cleans up the AlienBAIState.
 	~AlienBAIState();
 	/// Loads the AI state from YAML.
@@ -63,6 +91,16 @@ public:
 	void exit();
 	/// Runs state functionality every AI cycle.
 	void think(BattleAction *action);
+	/// Makes the AI use its own random stream.
+	void useRandom(uint64_t seed);
+	/// Starts thinking without touching the battle.
+	void startPlanning(Pathfinding *pathfinding, AIAnalysis *analysis);
+	/// Applies what was planned to the battle.
+	void finishPlanning();
+	/// Gets whether the plan has to be made on the battle.
+	bool isPlanSerial() const;
+	/// Gets whether the plan looked at the whole map.
+	bool isPlanGlobal() const;
 	/// Sets the "unit was hit" flag true.
 	void setWasHitBy(BattleUnit *attacker);
 	/// Gets whether the unit was hit.
@@ -79,6 +117,12 @@ public:
 	int countKnownTargets() const;
 	/// count how many known XCom units are able to see this unit.
 	int getSpottingUnits(Position pos) const;
+	/// Counts the known units able to see a position, without caching.
+	int countSpottingUnits(Position pos) const;
+	/// Counts the spotters of one position of a job.
+	static void spotterTask(void *data, int task);
+	/// Counts the spotters of several positions in parallel.
+	void prepareSpotters(const std::vector<Position> &positions);
 	/// Selects the nearest target we can see, and return the number of viable targets.
 	int selectNearestTarget();
 	/// Selects the closest known xcom unit for ambushing.
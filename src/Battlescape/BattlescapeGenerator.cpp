@@ -17,8 +17,8 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <assert.h>
-#include <fstream>
 #include <sstream>
+#include <algorithm>
 #include "BattlescapeGenerator.h"
 #include "TileEngine.h"
 #include "Inventory.h"
@@ -36,10 +36,10 @@
 #include "../Savegame/Node.h"
 #include "../Engine/Game.h"
 #include "../Engine/LocalizedText.h"
-#include "../Engine/FileMap.h"
 #include "../Engine/Options.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Exception.h"
+#include "../Engine/ThreadPool.h"
 #include "../Mod/MapBlock.h"
 #include "../Mod/MapDataSet.h"
 #include "../Mod/RuleUfo.h"
@@ -69,17 +69,26 @@ namespace OpenXcom
  * @param game pointer to Game object.
  */
 BattlescapeGenerator::BattlescapeGenerator(Game *game) : _game(game), _save(game->getSavedGame()->getSavedBattle()), _mod(game->getMod()), _craft(0), _ufo(0), _base(0), _mission(0), _alienBase(0), _terrain(0),
-														 _mapsize_x(0), _mapsize_y(0), _mapsize_z(0), _worldTexture(0), _worldShade(0), _unitSequence(0), _craftInventoryTile(0), _alienItemLevel(0), _baseInventory(false), _generateFuel(true), _craftDeployed(false), _craftZ(0)
+														 _mapsize_x(0), _mapsize_y(0), _mapsize_z(0), _worldTexture(0), _worldShade(0), _unitSequence(0), _craftInventoryTile(0), _alienItemLevel(0), _baseInventory(false), _generateFuel(true), _craftDeployed(false), _craftZ(0),
+														 _dummy(0), _thread(0), _mutex(0), _progress(0), _background(false)
 {
 	_allowAutoLoadout = !Options::disableAutoEquip;
 }
 
 /**
- * Deletes the BattlescapeGenerator.
+ * Deletes the BattlescapeGenerator. Waits for the
+ * background generator if it's still running.
  */
 BattlescapeGenerator::~BattlescapeGenerator()
 {
-
+	if (_thread != 0)
+	{
+		SDL_WaitThread(_thread, 0);
+	}
+	if (_mutex != 0)
+	{
+		SDL_DestroyMutex(_mutex);
+	}
 }
 
 /**
@@ -511,16 +520,24 @@ void BattlescapeGenerator::run()
 		throw Exception("Map generator encountered an error: " + _terrain->getScript() + " script not found.");
 	}
 
+	setProgress(5);
+
 	generateMap(script);
 
+	setProgress(60);
+
 	setupObjectives(ruleDeploy);
 
 	deployXCOM();
 
+	setProgress(70);
+
 	size_t unitCount = _save->getUnits()->size();
 
 	deployAliens(ruleDeploy);
 
+	setProgress(80);
+
 	if (unitCount == _save->getUnits()->size())
 	{
 		throw Exception("Map generator encountered an error: no alien units could be placed on the map.");
@@ -549,12 +566,199 @@ void BattlescapeGenerator::run()
 	// set shade (alien bases are a little darker, sites depend on worldshade)
 	_save->setGlobalShade(_worldShade);
 
+	setProgress(85);
+
 	_save->getTileEngine()->calculateSunShading();
 	_save->getTileEngine()->calculateTerrainLighting();
 	_save->getTileEngine()->calculateUnitLighting();
 	_save->getTileEngine()->recalculateFOV();
 }
 
+/**
+ * Runs the generator on a thread of its own, so the game can
+ * keep the screen going while the map gets built. Nothing else
+ * may use the battle or the random number generator until the
+ * generator is done, so the battle comes out the same as if it
+ * was generated with run(). Changes to the geoscape (like items
+ * taken from the base stores) wait for finish(), so they're
+ * made on the main thread.
+ */
+void BattlescapeGenerator::start()
+{
+	if (_mutex == 0)
+	{
+		_mutex = SDL_CreateMutex();
+	}
+	_progress = 0;
+	_background = true;
+	_error.clear();
+	_thread = SDL_CreateThread(runThread, this);
+	if (_thread == 0)
+	{
+		runThread(this);
+	}
+}
+
+/**
+ * Entry point for the background generator. Errors are
+ * kept to be passed on once the generator is finished.
+ * @param generator Pointer to the BattlescapeGenerator.
+ * @return Always 0.
+ */
+int BattlescapeGenerator::runThread(void *generator)
+{
+	BattlescapeGenerator *self = (BattlescapeGenerator*)generator;
+	std::string error;
+	try
+	{
+		self->run();
+	}
+	catch (std::exception &e)
+	{
+		error = e.what();
+		if (error.empty())
+		{
+			error = "Map generator encountered an error.";
+		}
+	}
+	catch (...)
+	{
+		error = "Map generator encountered an error.";
+	}
+	SDL_mutexP(self->_mutex);
+	self->_error = error;
+	self->_progress = 100;
+	SDL_mutexV(self->_mutex);
+	return 0;
+}
+
+/**
+ * Sets how far along the background generator is.
+ * @param progress Progress in percent.
+ */
+void BattlescapeGenerator::setProgress(int progress)
+{
+	if (_mutex == 0)
+	{
+		return;
+	}
+	SDL_mutexP(_mutex);
+	_progress = progress;
+	SDL_mutexV(_mutex);
+}
+
+/**
+ * Gets how far along the background generator is.
+ * @return Progress in percent.
+ */
+int BattlescapeGenerator::getProgress()
+{
+	if (_mutex == 0)
+	{
+		return _progress;
+	}
+	SDL_mutexP(_mutex);
+	int progress = _progress;
+	SDL_mutexV(_mutex);
+	return progress;
+}
+
+/**
+ * Checks if the background generator is done.
+ * @return True if the battle is ready, or failed.
+ */
+bool BattlescapeGenerator::isDone()
+{
+	return getProgress() == 100;
+}
+
+/**
+ * Waits for the background generator to finish and
+ * passes on any error it ran into. Otherwise makes the
+ * changes to the geoscape the generator held back.
+ */
+void BattlescapeGenerator::finish()
+{
+	if (_thread != 0)
+	{
+		SDL_WaitThread(_thread, 0);
+		_thread = 0;
+	}
+	_background = false;
+	if (!_error.empty())
+	{
+		std::string error = _error;
+		_error.clear();
+		throw Exception(error);
+	}
+	takeStorageItems();
+}
+
+/**
+ * Removes the items the battle took from the base
+ * stores, once it's safe to change the base.
+ */
+void BattlescapeGenerator::takeStorageItems()
+{
+	for (std::map<std::string, int>::iterator i = _storageTaken.begin(); i != _storageTaken.end(); ++i)
+	{
+		_base->getStorageItems()->removeItem(i->first, i->second);
+	}
+	_storageTaken.clear();
+}
+
+/**
+ * Map data sets to load on the worker threads.
+ */
+struct DataSetJob
+{
+	std::vector<MapDataSet*> sets;
+	std::vector<std::string> errors;
+};
+
+/**
+ * Loads one map data set of a job.
+ * @param data Pointer to the DataSetJob.
+ * @param task Index of the data set.
+ */
+void BattlescapeGenerator::loadDataTask(void *data, int task)
+{
+	DataSetJob *job = (DataSetJob*)data;
+	try
+	{
+		job->sets[task]->loadData();
+	}
+	catch (std::exception &e)
+	{
+		job->errors[task] = e.what();
+	}
+}
+
+/**
+ * Loads the MCD and sprites of all the map data sets of
+ * a terrain at once, spread over several threads.
+ * @param terrain Pointer to the terrain.
+ */
+void BattlescapeGenerator::loadMapDataSets(RuleTerrain *terrain)
+{
+	DataSetJob job;
+	job.sets = *terrain->getMapDataSets();
+	// a set used twice must only be loaded once
+	std::sort(job.sets.begin(), job.sets.end());
+	job.sets.erase(std::unique(job.sets.begin(), job.sets.end()), job.sets.end());
+	job.errors.resize(job.sets.size());
+	ThreadPool::getShared()->run(loadDataTask, &job, job.sets.size());
+	// report the first error in the order of the terrain
+	for (std::vector<MapDataSet*>::iterator i = terrain->getMapDataSets()->begin(); i != terrain->getMapDataSets()->end(); ++i)
+	{
+		size_t set = std::lower_bound(job.sets.begin(), job.sets.end(), *i) - job.sets.begin();
+		if (!job.errors[set].empty())
+		{
+			throw Exception(job.errors[set]);
+		}
+	}
+}
+
 /**
  * Deploys all the X-COM units and equipment based
  * on the Geoscape base / craft.
@@ -652,7 +856,7 @@ void BattlescapeGenerator::deployXCOM()
 		if (_game->getSavedGame()->getMonthsPassed() != -1)
 		{
 			// add items that are in the base
-			for (std::map<std::string, int>::iterator i = _base->getStorageItems()->getContents()->begin(); i != _base->getStorageItems()->getContents()->end();)
+			for (std::map<std::string, int>::iterator i = _base->getStorageItems()->getContents()->begin(); i != _base->getStorageItems()->getContents()->end(); ++i)
 			{
 				// only put items in the battlescape that make sense (when the item got a sprite, it's probably ok)
 				RuleItem *rule = _game->getMod()->getItem(i->first);
@@ -662,15 +866,14 @@ void BattlescapeGenerator::deployXCOM()
 					{
 						_craftInventoryTile->addItem(new BattleItem(_game->getMod()->getItem(i->first), _save->getCurrentItemId()), ground);
 					}
-					std::map<std::string, int>::iterator tmp = i;
-					++i;
-					_base->getStorageItems()->removeItem(tmp->first, tmp->second);
-				}
-				else
-				{
-					++i;
+					_storageTaken[i->first] += i->second;
 				}
 			}
+			// a background generator leaves the base alone until it's finished
+			if (!_background)
+			{
+				takeStorageItems();
+			}
 		}
 		// add items from crafts in base
 		for (std::vector<Craft*>::iterator c = _base->getCrafts()->begin(); c != _base->getCrafts()->end(); ++c)
@@ -1425,24 +1628,29 @@ int BattlescapeGenerator::loadMAP(MapBlock *mapblock, int xoff, int yoff, RuleTe
 {
 	int sizex, sizey, sizez;
 	int x = xoff, y = yoff, z = 0;
-	char size[3];
-	unsigned char value[4];
 	std::ostringstream filename;
 	filename << "MAPS/" << mapblock->getName() << ".MAP";
 	unsigned int terrainObjectID;
 
-	// Load file
-	std::ifstream mapFile (FileMap::getFilePath(filename.str()).c_str(), std::ios::in| std::ios::binary);
-	if (!mapFile)
+	// the block keeps the file around, so it's only read from disk once
+	const std::vector<char> &mapFile = mapblock->getMapFile();
+	if (mapFile.size() < 3)
 	{
-		throw Exception(filename.str() + " not found");
+		throw Exception("Invalid MAP file: " + filename.str());
 	}
 
-	mapFile.read((char*)&size, sizeof(size));
+	const char *size = &mapFile[0];
 	sizey = (int)size[0];
 	sizex = (int)size[1];
 	sizez = (int)size[2];
 
+	// every tile of the block takes a whole record
+	size_t records = (size_t)sizex * sizey * sizez;
+	if (sizex <= 0 || sizey <= 0 || sizez <= 0 || mapFile.size() < 3 + records * 4)
+	{
+		throw Exception("Invalid MAP file: " + filename.str());
+	}
+
 	mapblock->setSizeZ(sizez);
 
 	std::ostringstream ss;
@@ -1481,8 +1689,9 @@ int BattlescapeGenerator::loadMAP(MapBlock *mapblock, int xoff, int yoff, RuleTe
 		throw Exception("Something is wrong in your map definitions, craft/ufo map is too tall?");
 	}
 
-	while (mapFile.read((char*)&value, sizeof(value)))
+	for (size_t record = 0; record < records; ++record)
 	{
+		const char *value = &mapFile[3 + record * 4];
 		for (int part = 0; part < 4; ++part)
 		{
 			terrainObjectID = ((unsigned char)value[part]);
@@ -1515,13 +1724,6 @@ int BattlescapeGenerator::loadMAP(MapBlock *mapblock, int xoff, int yoff, RuleTe
 		}
 	}
 
-	if (!mapFile.eof())
-	{
-		throw Exception("Invalid MAP file: " + filename.str());
-	}
-
-	mapFile.close();
-
 	if (_generateFuel)
 	{
 		// if one of the mapBlocks has an items array defined, don't deploy fuel algorithmically
@@ -1550,21 +1752,18 @@ int BattlescapeGenerator::loadMAP(MapBlock *mapblock, int xoff, int yoff, RuleTe
  */
 void BattlescapeGenerator::loadRMP(MapBlock *mapblock, int xoff, int yoff, int segment)
 {
-	unsigned char value[24];
-	std::ostringstream filename;
-	filename << "ROUTES/" << mapblock->getName() << ".RMP";
-
-	// Load file
-	std::ifstream mapFile (FileMap::getFilePath(filename.str()).c_str(), std::ios::in| std::ios::binary);
-	if (!mapFile)
+	// the block keeps the file around, so it's only read from disk once
+	const std::vector<char> &mapFile = mapblock->getRouteFile();
+	if (mapFile.size() % 24 != 0)
 	{
-		throw Exception(filename.str() + " not found");
+		throw Exception("Invalid RMP file: ROUTES/" + mapblock->getName() + ".RMP");
 	}
 
 	size_t nodeOffset = _save->getNodes()->size();
 
-	while (mapFile.read((char*)&value, sizeof(value)))
+	for (size_t record = 0; record + 24 <= mapFile.size(); record += 24)
 	{
+		const unsigned char *value = (const unsigned char*)&mapFile[record];
 		int pos_x = value[1];
 		int pos_y = value[0];
 		int pos_z = value[2];
@@ -1595,13 +1794,6 @@ void BattlescapeGenerator::loadRMP(MapBlock *mapblock, int xoff, int yoff, int s
 			_save->getNodes()->push_back(node);
 		}
 	}
-
-	if (!mapFile.eof())
-	{
-		throw Exception("Invalid RMP file");
-	}
-
-	mapFile.close();
 }
 
 /**
@@ -1812,13 +2004,14 @@ void BattlescapeGenerator::generateMap(const std::vector<MapScript*> *script)
 	// create an array to track command success/failure
 	std::map<int, bool> conditionals;
 
+	loadMapDataSets(_terrain);
 	for (std::vector<MapDataSet*>::iterator i = _terrain->getMapDataSets()->begin(); i != _terrain->getMapDataSets()->end(); ++i)
 	{
-		(*i)->loadData();
 		if (_game->getMod()->getMCDPatch((*i)->getName()))
 		{
 			_game->getMod()->getMCDPatch((*i)->getName())->modifyData(*i);
 		}
+		(*i)->useData();
 		_save->getMapDataSets()->push_back(*i);
 		mapDataSetIDOffset++;
 	}
@@ -2059,13 +2252,14 @@ void BattlescapeGenerator::generateMap(const std::vector<MapScript*> *script)
 
 	if (!ufoMaps.empty() && ufoTerrain)
 	{
+		loadMapDataSets(ufoTerrain);
 		for (std::vector<MapDataSet*>::iterator i = ufoTerrain->getMapDataSets()->begin(); i != ufoTerrain->getMapDataSets()->end(); ++i)
 		{
-			(*i)->loadData();
 			if (_game->getMod()->getMCDPatch((*i)->getName()))
 			{
 				_game->getMod()->getMCDPatch((*i)->getName())->modifyData(*i);
 			}
+			(*i)->useData();
 			_save->getMapDataSets()->push_back(*i);
 			craftDataSetIDOffset++;
 		}
@@ -2086,13 +2280,14 @@ void BattlescapeGenerator::generateMap(const std::vector<MapScript*> *script)
 
 	if (craftMap)
 	{
+		loadMapDataSets(_craft->getRules()->getBattlescapeTerrainData());
 		for (std::vector<MapDataSet*>::iterator i = _craft->getRules()->getBattlescapeTerrainData()->getMapDataSets()->begin(); i != _craft->getRules()->getBattlescapeTerrainData()->getMapDataSets()->end(); ++i)
 		{
-			(*i)->loadData();
 			if (_game->getMod()->getMCDPatch((*i)->getName()))
 			{
 				_game->getMod()->getMCDPatch((*i)->getName())->modifyData(*i);
 			}
+			(*i)->useData();
 			_save->getMapDataSets()->push_back(*i);
 		}
 		loadMAP(craftMap, _craftPos.x * 10, _craftPos.y * 10, _craft->getRules()->getBattlescapeTerrainData(), mapDataSetIDOffset + craftDataSetIDOffset, true, true);
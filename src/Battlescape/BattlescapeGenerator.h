@@ -20,6 +20,9 @@
 #define OPENXCOM_BATTLESCAPEGENERATOR_H
 
 #include <vector>
+#include <map>
+#include <string>
+#include <SDL_thread.h>
 #include "../Mod/RuleTerrain.h"
 #include "../Mod/MapScript.h"
 
@@ -45,6 +48,7 @@ class AlienBase;
 class BattleUnit;
 class MapScript;
 class Texture;
+class MapDataSet;
 
 /**
  * A utility class that generates the initial battlescape data. Taking into account mission type, craft and ufo involved, terrain type,...
@@ -77,7 +81,23 @@ private:
 	std::vector< std::vector<bool> > _landingzone;
 	std::vector< std::vector<int> > _segments, _drillMap;
 	MapBlock *_dummy;
+	SDL_Thread *_thread;
+	SDL_mutex *_mutex;
+	int _progress;
+	bool _background;
+	std::string _error;
+	std::map<std::string, int> _storageTaken;
 
+	/// Runs the generator on its own thread.
+	static int runThread(void *generator);
+	/// Sets how far along the generator is.
+	void setProgress(int progress);
+	/// Loads the map data set of a job.
+	static void loadDataTask(void *data, int task);
+	/// Loads the map data sets of a terrain.
+	void loadMapDataSets(RuleTerrain *terrain);
+	/// Removes the items taken into battle from the base stores.
+	void takeStorageItems();
 	/// sets the map size and associated vars
 	void init();
 	/// Generates a new battlescape map.
@@ -161,6 +181,14 @@ public:
 	void setTerrain(RuleTerrain *terrain);
 	/// Runs the generator.
 	void run();
+	/// Starts running the generator in the background.
+	void start();
+	/// Gets how far along the background generator is.
+	int getProgress();
+	/// Checks if the background generator is done.
+	bool isDone();
+	/// Waits for the background generator to finish.
+	void finish();
 	/// Sets up the next stage (for Cydonia/TFTD missions).
 	void nextStage();
 	/// Generates an inventory battlescape.
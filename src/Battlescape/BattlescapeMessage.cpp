@@ -131,6 +131,20 @@ void BattlescapeMessage::blit(Surface *surface)
 	_text->blit(surface);
 }
 
+/**
+ * Gets the changed area of the message, including
+ * its window and text.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool BattlescapeMessage::getDamage(SDL_Rect &rect)
+{
+	bool damaged = Surface::getDamage(rect);
+	damaged = _window->getDamage(rect) || damaged;
+	damaged = _text->getDamage(rect) || damaged;
+	return damaged;
+}
+
 /*
  * Special handling for setting the height of the battlescape message.
  * @param height the new height.
@@ -185,11 +185,12 @@ BattlescapeState::BattlescapeState() : _reserve(0), _xBeforeMouseScrolling(0), _
 	}
 
 	// there is some cropping going on here, because the icons image is 320x200 while we only need the bottom of it.
-	SDL_Rect *r = icons->getCrop();
-	r->x = 0;
-	r->y = 200 - iconsHeight;
-	r->w = iconsWidth;
-	r->h = iconsHeight;
+	SDL_Rect r;
+	r.x = 0;
+	r.y = 200 - iconsHeight;
+	r.w = iconsWidth;
+	r.h = iconsHeight;
+	icons->setCrop(r);
 	// we need to blit the icons before we add the battlescape buttons, as they copy the underlying parent surface.
 	icons->blit(_icons);
 
@@ -1705,6 +1706,7 @@ void BattlescapeState::saveVoxelView()
 	double dist;
 	bool _debug = _save->getDebugMode();
 	double dir = ((float)bu->getDirection()+4)/4*M_PI;
+	_save->getTileEngine()->updateVoxels();
 	image.clear();
 	for (int y = -256+32; y < 256+32; ++y)
 	{
@@ -1820,6 +1822,7 @@ void BattlescapeState::saveVoxelMap()
 
 	Tile *tile;
 
+	_save->getTileEngine()->updateVoxels();
 	for (int z = 0; z < _save->getMapSizeZ()*12; ++z)
 	{
 		image.clear();
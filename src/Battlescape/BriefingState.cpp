@@ -18,6 +18,7 @@
  */
 #include "BriefingState.h"
 #include "BattlescapeState.h"
+#include "BattlescapeGenerator.h"
 #include "AliensCrashState.h"
 #include "../Engine/Game.h"
 #include "../Engine/LocalizedText.h"
@@ -46,8 +47,10 @@ namespace OpenXcom
  * @param game Pointer to the core game.
  * @param craft Pointer to the craft in the mission.
  * @param base Pointer to the base in the mission.
+ * @param generator Generator to build the battle in the background while
+ * the briefing is up, or 0 if the battle is ready. The state takes it over.
  */
-BriefingState::BriefingState(Craft *craft, Base *base)
+BriefingState::BriefingState(Craft *craft, Base *base, BattlescapeGenerator *generator) : _generator(generator)
 {
 	_screen = true;
 	// Create objects
@@ -109,7 +112,14 @@ BriefingState::BriefingState(Craft *craft, Base *base)
 	centerAllSurfaces();
 
 	// Set up objects
-	_btnOk->setText(tr("STR_OK"));
+	if (_generator)
+	{
+		_btnOk->setText(Text::formatPercentage(0));
+	}
+	else
+	{
+		_btnOk->setText(tr("STR_OK"));
+	}
 	_btnOk->onMouseClick((ActionHandler)&BriefingState::btnOkClick);
 	_btnOk->onKeyboardPress((ActionHandler)&BriefingState::btnOkClick, Options::keyOk);
 	_btnOk->onKeyboardPress((ActionHandler)&BriefingState::btnOkClick, Options::keyCancel);
@@ -144,6 +154,11 @@ BriefingState::BriefingState(Craft *craft, Base *base)
 		// And make sure the base is unmarked.
 		base->setRetaliationTarget(false);
 	}
+
+	if (_generator)
+	{
+		_generator->start();
+	}
 }
 
 /**
@@ -151,7 +166,7 @@ BriefingState::BriefingState(Craft *craft, Base *base)
  */
 BriefingState::~BriefingState()
 {
-
+	delete _generator;
 }
 
 void BriefingState::init()
@@ -171,12 +186,50 @@ void BriefingState::init()
 	}
 }
 
+/**
+ * Shows how far along the battle is, and lets
+ * the player in once it's been generated.
+ */
+void BriefingState::think()
+{
+	State::think();
+
+	if (_generator)
+	{
+		if (_generator->isDone())
+		{
+			BattlescapeGenerator *generator = _generator;
+			_generator = 0;
+			try
+			{
+				generator->finish();
+			}
+			catch (...)
+			{
+				delete generator;
+				throw;
+			}
+			delete generator;
+			_btnOk->setText(tr("STR_OK"));
+		}
+		else
+		{
+			_btnOk->setText(Text::formatPercentage(_generator->getProgress()));
+		}
+	}
+}
+
 /**
  * Closes the window.
  * @param action Pointer to an action.
  */
 void BriefingState::btnOkClick(Action *)
 {
+	// the battle isn't ready yet
+	if (_generator)
+	{
+		return;
+	}
 	_game->popState();
 	Options::baseXResolution = Options::baseXBattlescape;
 	Options::baseYResolution = Options::baseYBattlescape;
@@ -29,6 +29,7 @@ class Window;
 class Text;
 class Craft;
 class Base;
+class BattlescapeGenerator;
 
 /**
  * Briefing screen which displays info
@@ -41,13 +42,16 @@ private:
 	Window *_window;
 	Text *_txtTitle, *_txtTarget, *_txtCraft, *_txtBriefing;
 	std::string _cutsceneId, _musicId;
+	BattlescapeGenerator *_generator;
 public:
 	/// Creates the Briefing state.
-	BriefingState(Craft *craft = 0, Base *base = 0);
+	BriefingState(Craft *craft = 0, Base *base = 0, BattlescapeGenerator *generator = 0);
 	/// Cleans up the Briefing state.
 	~BriefingState();
 	/// Initialization
 	void init();
+	/// Checks on the battle being generated.
+	void think();
 	/// Handler for clicking the Ok button.
 	void btnOkClick(Action *action);
 };
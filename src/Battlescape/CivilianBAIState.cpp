@@ -21,6 +21,7 @@
 #include "CivilianBAIState.h"
 #include "TileEngine.h"
 #include "Pathfinding.h"
+#include "AIAnalysis.h"
 #include "../Savegame/BattleUnit.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Node.h"
@@ -118,6 +119,8 @@ void CivilianBAIState::think(BattleAction *action)
  	action->type = BA_RETHINK;
 	action->actor = _unit;
 	_escapeAction->number = action->number;
+	_save->getAIAnalysis()->update();
+	_save->getTileEngine()->updateVoxels();
 	_visibleEnemies = selectNearestTarget();
 	_spottingEnemies = getSpottingUnits(_unit->getPosition());
 	
@@ -243,8 +246,12 @@ int CivilianBAIState::selectNearestTarget()
 
 int CivilianBAIState::getSpottingUnits(Position pos) const
 {
-	bool checking = pos != _unit->getPosition();
 	int tally = 0;
+	if (_save->getTile(pos) && _save->getAIAnalysis()->getSpotters(_unit, pos, &tally))
+	{
+		return tally;
+	}
+	bool checking = pos != _unit->getPosition();
 	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
 	{
 		if (!(*i)->isOut() && (*i)->getFaction() == FACTION_HOSTILE)
@@ -270,6 +277,10 @@ int CivilianBAIState::getSpottingUnits(Position pos) const
 			}
 		}
 	}
+	if (_save->getTile(pos))
+	{
+		_save->getAIAnalysis()->setSpotters(_unit, pos, tally);
+	}
 	return tally;
 }
 
@@ -298,7 +309,7 @@ void CivilianBAIState::setupEscape()
 
 	int tu = _unit->getTimeUnits() / 2;
 
-	std::vector<int> reachable = _save->getPathfinding()->findReachable(_unit, tu);
+	const std::vector<int> &reachable = _save->getAIAnalysis()->findReachable(_unit, tu);
 	std::vector<Position> randomTileSearch = _save->getTileSearch();
 	RNG::shuffle(randomTileSearch);
 	
@@ -457,14 +457,50 @@ void Inventory::think()
  */
 void Inventory::blit(Surface *surface)
 {
-	clear();
-	_grid->blit(this);
-	_items->blit(this);
-	_selection->blit(this);
-	_warning->blit(this);
+	if (layersChanged())
+	{
+		clear();
+		_grid->blit(this);
+		_items->blit(this);
+		_selection->blit(this);
+		_warning->blit(this);
+	}
 	Surface::blit(surface);
 }
 
+/**
+ * Checks if any of the layers that make up the
+ * inventory changed since they were last put together.
+ * @return True if the inventory needs recompositing.
+ */
+bool Inventory::layersChanged()
+{
+	SDL_Rect damage = {0, 0, 0, 0};
+	bool changed = _grid->getDamage(damage);
+	changed = _items->getDamage(damage) || changed;
+	changed = _selection->getDamage(damage) || changed;
+	changed = _warning->getDamage(damage) || changed;
+	return changed;
+}
+
+/**
+ * Gets the changed area of the inventory. The layers are
+ * blitted onto the inventory itself, so any change in them
+ * changes the whole inventory.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool Inventory::getDamage(SDL_Rect &rect)
+{
+	bool damaged = Surface::getDamage(rect);
+	if (_visible && !_hidden && layersChanged())
+	{
+		addArea(rect);
+		damaged = true;
+	}
+	return damaged;
+}
+
 /**
  * Moves the selected item.
  * @param action Pointer to an action.
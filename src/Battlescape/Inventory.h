@@ -58,6 +58,8 @@ private:
 	void moveItem(BattleItem *item, RuleInventory *slot, int x, int y);
 	/// Gets the slot in the specified position.
 	RuleInventory *getSlotInPosition(int *x, int *y) const;
+	/// Checks if the inventory layers changed.
+	bool layersChanged();
 public:
 	/// Creates a new inventory view at the specified position and size.
 	Inventory(Game *game, int width, int height, int x = 0, int y = 0, bool base = false);
@@ -87,6 +89,8 @@ public:
 	void think();
 	/// Blits the inventory onto another surface.
 	void blit(Surface *surface);
+	/// Gets the changed area of the inventory.
+	bool getDamage(SDL_Rect &rect);
 	/// Special handling for mouse hovers.
 	void mouseOver(Action *action, State *state);
 	/// Special handling for mouse clicks.
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "LightField.h"
+#include <cmath>
+#include <algorithm>
+#include "../Savegame/Tile.h"
+#include "../fmath.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates an empty light field.
+ * @param layer Tile light layer the field writes to.
+ */
+LightField::LightField(int layer) : _layer(layer), _width(0), _length(0), _height(0), _tiles(0)
+{
+}
+
+/**
+ * Cleans up the light field.
+ */
+LightField::~LightField()
+{
+}
+
+/**
+ * Sets up the field for a map and drops all the light sources.
+ * The tiles are expected to have no light in the field's layer.
+ * @param tiles Tiles of the map.
+ * @param width Map size in the X axis.
+ * @param length Map size in the Y axis.
+ * @param height Map size in the Z axis.
+ */
+void LightField::reset(Tile **tiles, int width, int length, int height)
+{
+	_tiles = tiles;
+	_width = width;
+	_length = length;
+	_height = height;
+	_counts.assign(_width * _length * MAX_LIGHT, 0);
+	_light.assign(_width * _length, 0);
+	_sources.clear();
+}
+
+/**
+ * Gets the cells lit by a light source relative to its center,
+ * with the amount of light each gets. The light loses power
+ * with the rounded distance travelled, like it always has.
+ * The patterns are only worked out once per power.
+ * @param power Power of the light source.
+ * @return List of lit cells.
+ */
+const std::vector<LightField::StencilCell> &LightField::getStencil(int power)
+{
+	if (power >= (int)_stencils.size())
+	{
+		_stencils.resize(power + 1);
+	}
+	std::vector<StencilCell> &stencil = _stencils[power];
+	if (stencil.empty() && power > 0)
+	{
+		for (int y = -power; y <= power; ++y)
+		{
+			for (int x = -power; x <= power; ++x)
+			{
+				int light = power - (int)Round(sqrt(float(x*x + y*y)));
+				if (light > 0)
+				{
+					StencilCell cell;
+					cell.dx = x;
+					cell.dy = y;
+					cell.light = light > MAX_LIGHT ? MAX_LIGHT : light;
+					stencil.push_back(cell);
+				}
+			}
+		}
+	}
+	return stencil;
+}
+
+/**
+ * Adds or removes the light a source casts on the columns around it.
+ * @param source Light source.
+ * @param delta 1 to add the light, -1 to remove it.
+ */
+void LightField::apply(const Source &source, int delta)
+{
+	if (source.second <= 0)
+	{
+		return;
+	}
+	int cx = source.first % _width;
+	int cy = source.first / _width;
+	const std::vector<StencilCell> &stencil = getStencil(source.second);
+	for (std::vector<StencilCell>::const_iterator i = stencil.begin(); i != stencil.end(); ++i)
+	{
+		int x = cx + i->dx;
+		int y = cy + i->dy;
+		if (x < 0 || x >= _width || y < 0 || y >= _length)
+		{
+			continue;
+		}
+		int column = y * _width + x;
+		Uint16 &count = _counts[column * MAX_LIGHT + i->light - 1];
+		count += delta;
+		if (delta > 0 ? i->light > _light[column] : (count == 0 && i->light == _light[column]))
+		{
+			updateColumn(column);
+		}
+	}
+}
+
+/**
+ * Finds the brightest light in a column and passes
+ * it on to all the tiles in the column.
+ * @param column Map column index.
+ */
+void LightField::updateColumn(int column)
+{
+	int light = MAX_LIGHT;
+	while (light > 0 && _counts[column * MAX_LIGHT + light - 1] == 0)
+	{
+		--light;
+	}
+	_light[column] = light;
+	for (int z = 0; z < _height; ++z)
+	{
+		_tiles[z * _width * _length + column]->setLight(light, _layer);
+	}
+}
+
+/**
+ * Gets the light source for a position on the map.
+ * @param center Position of the source.
+ * @param power Power of the source.
+ * @return Light source.
+ */
+LightField::Source LightField::getSource(const Position &center, int power) const
+{
+	return Source(center.y * _width + center.x, power);
+}
+
+/**
+ * Adds the light of a single source to the field,
+ * for example a flare that was just thrown.
+ * @param center Position of the source.
+ * @param power Power of the source.
+ */
+void LightField::addLight(const Position &center, int power)
+{
+	if (center.x < 0 || center.x >= _width || center.y < 0 || center.y >= _length)
+	{
+		return;
+	}
+	Source source = getSource(center, power);
+	_sources.insert(std::upper_bound(_sources.begin(), _sources.end(), source), source);
+	apply(source, 1);
+}
+
+/**
+ * Removes the light of a single source from the field,
+ * for example a unit that moved away or died.
+ * @param center Position of the source.
+ * @param power Power of the source.
+ */
+void LightField::removeLight(const Position &center, int power)
+{
+	if (center.x < 0 || center.x >= _width || center.y < 0 || center.y >= _length)
+	{
+		return;
+	}
+	Source source = getSource(center, power);
+	std::vector<Source>::iterator i = std::lower_bound(_sources.begin(), _sources.end(), source);
+	if (i != _sources.end() && *i == source)
+	{
+		_sources.erase(i);
+		apply(source, -1);
+	}
+}
+
+/**
+ * Replaces all the light sources in the field. Only the
+ * sources that weren't there before or are gone now
+ * change the light, the rest is left as it is.
+ * @param sources New light sources, gets sorted.
+ */
+void LightField::setSources(std::vector<Source> &sources)
+{
+	std::sort(sources.begin(), sources.end());
+	std::vector<Source>::const_iterator oldSource = _sources.begin();
+	std::vector<Source>::const_iterator newSource = sources.begin();
+	while (oldSource != _sources.end() || newSource != sources.end())
+	{
+		if (newSource == sources.end() || (oldSource != _sources.end() && *oldSource < *newSource))
+		{
+			apply(*oldSource, -1);
+			++oldSource;
+		}
+		else if (oldSource == _sources.end() || *newSource < *oldSource)
+		{
+			apply(*newSource, 1);
+			++newSource;
+		}
+		else
+		{
+			++oldSource;
+			++newSource;
+		}
+	}
+	_sources = sources;
+}
+
+/**
+ * Gets the brightest light cast on a map column.
+ * @param x X position of the column.
+ * @param y Y position of the column.
+ * @return Light level.
+ */
+int LightField::getLight(int x, int y) const
+{
+	return _light[y * _width + x];
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_LIGHTFIELD_H
+#define OPENXCOM_LIGHTFIELD_H
+
+#include <vector>
+#include <utility>
+#include <SDL_types.h>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class Tile;
+
+/**
+ * Keeps track of the light cast on the battlescape by a set
+ * of light sources, for one of the tile light layers.
+ * Light falls off with the horizontal distance from a source
+ * and lights up every level of the map equally, so the field
+ * is stored per map column. For every column it counts how
+ * many sources light it at each level, so single sources can
+ * be added and removed without recalculating the rest.
+ */
+class LightField
+{
+public:
+	/// A light source: map column index and power.
+	typedef std::pair<int, int> Source;
+private:
+	static const int MAX_LIGHT = 15;
+	struct StencilCell
+	{
+		int dx, dy, light;
+	};
+	int _layer, _width, _length, _height;
+	Tile **_tiles;
+	std::vector<std::vector<StencilCell> > _stencils;
+	std::vector<Uint16> _counts;
+	std::vector<Uint8> _light;
+	std::vector<Source> _sources;
+	/// Gets the falloff pattern of a light source.
+	const std::vector<StencilCell> &getStencil(int power);
+	/// Adds or removes the light of a source.
+	void apply(const Source &source, int delta);
+	/// Updates the tiles of a column to its brightest light.
+	void updateColumn(int column);
+public:
+	/// Creates a light field for a light layer.
+	LightField(int layer);
+	/// Cleans up the light field.
+	~LightField();
+	/// Sets up the field for a map, dropping all sources.
+	void reset(Tile **tiles, int width, int length, int height);
+	/// Gets the light source at a position.
+	Source getSource(const Position &center, int power) const;
+	/// Adds a light source.
+	void addLight(const Position &center, int power);
+	/// Removes a light source.
+	void removeLight(const Position &center, int power);
+	/// Replaces the light sources, only changing the difference.
+	void setSources(std::vector<Source> &sources);
+	/// Gets the light level of a map column.
+	int getLight(int x, int y) const;
+};
+
+}
+
+#endif
@@ -17,9 +17,10 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <list>
+#include <algorithm>
 #include "Pathfinding.h"
 #include "PathfindingNode.h"
-#include "PathfindingOpenSet.h"
+#include "PathfindingClusters.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
 #include "../Mod/Armor.h"
@@ -38,7 +39,7 @@ int Pathfinding::green = 4;
  * Sets up a Pathfinding.
  * @param save pointer to SavedBattleGame object.
  */
-Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _unit(0), _pathPreviewed(false), _strafeMove(false), _totalTUCost(0), _modifierUsed(false), _movementType(MT_WALK)
+Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _generation(0), _stepCostStamp(0), _bounded(false), _unit(0), _pathPreviewed(false), _strafeMove(false), _totalTUCost(0), _modifierUsed(false), _movementType(MT_WALK)
 {
 	_size = _save->getMapSizeXYZ();
 	// Initialize one node per tile
@@ -49,6 +50,7 @@ Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _unit(0), _pathPr
 		_save->getTileCoords(i, &p.x, &p.y, &p.z);
 		_nodes.push_back(PathfindingNode(p));
 	}
+	_clusters = new PathfindingClusters(_save, this);
 }
 
 /**
@@ -57,7 +59,7 @@ Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _unit(0), _pathPr
  */
 Pathfinding::~Pathfinding()
 {
-	// Nothing more to do here.
+	delete _clusters;
 }
 
 /**
@@ -67,7 +69,28 @@ Pathfinding::~Pathfinding()
  */
 PathfindingNode *Pathfinding::getNode(const Position& pos)
 {
-	return &_nodes[_save->getTileIndex(pos)];
+	PathfindingNode *node = &_nodes[_save->getTileIndex(pos)];
+	node->reset(_generation);
+	return node;
+}
+
+/**
+ * Starts a new search: empties the open set and moves on
+ * to the next generation, which resets every node the
+ * first time the search gets to it.
+ */
+void Pathfinding::newSearch()
+{
+	_openSet.clear();
+	if (++_generation == 0)
+	{
+		// wrapped around, make sure no node looks current
+		for (std::vector<PathfindingNode>::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
+		{
+			it->reset(0);
+		}
+		_generation = 1;
+	}
 }
 
 /**
@@ -164,6 +187,24 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleUnit *
 	{
 		abortPath(); // if bresenham failed, we shouldn't keep the path it was attempting, in case A* fails too.
 	}
+	// AI units going far first look for a route through the clusters,
+	// if there's none they can't get there, otherwise A* stays close to it.
+	if (target == 0 && unit->getFaction() != FACTION_PLAYER && size <= 1 &&
+		std::max(abs(startPosition.x - endPosition.x), abs(startPosition.y - endPosition.y)) > LONG_PATH)
+	{
+		if (!_clusters->findRoute(unit, startPosition, endPosition))
+		{
+			abortPath();
+			return;
+		}
+		_bounded = true;
+		bool found = aStarPath(startPosition, endPosition, target, sneak, maxTUCost);
+		_bounded = false;
+		if (found)
+		{
+			return;
+		}
+	}
 	// Now try through A*.
 	if (!aStarPath(startPosition, endPosition, target, sneak, maxTUCost))
 	{
@@ -184,14 +225,13 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleUnit *
  */
 bool Pathfinding::aStarPath(const Position &startPosition, const Position &endPosition, BattleUnit *target, bool sneak, int maxTUCost)
 {
-	// reset every node, so we have to check them all
-	for (std::vector<PathfindingNode>::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
-		it->reset();
+	// every node we come across gets reset, so we have to check them all
+	newSearch();
 
 	// start position is the first one in our "open" list
 	PathfindingNode *start = getNode(startPosition);
 	start->connect(0, 0, 0, endPosition);
-	PathfindingOpenSet openList;
+	PathfindingOpenSet &openList = _openSet;
 	openList.push(start);
 	bool missile = (target && maxTUCost == -1);
 	// if the open list is empty, we've reached the end
@@ -216,10 +256,12 @@ bool Pathfinding::aStarPath(const Position &startPosition, const Position &endPo
 		for (int direction = 0; direction < 10; direction++)
 		{
 			Position nextPos;
-			int tuCost = getTUCost(currentPos, direction, &nextPos, _unit, target, missile);
+			int tuCost = getCachedTUCost(currentPos, direction, &nextPos, _unit, target, missile);
 			if (tuCost >= 255) // Skip unreachable / blocked
 				continue;
 			if (sneak && _save->getTile(nextPos)->getVisible()) tuCost *= 2; // avoid being seen
+			if (_bounded && !_clusters->inCorridor(nextPos)) // Stay near the route through the clusters.
+				continue;
 			PathfindingNode *nextNode = getNode(nextPos);
 			if (nextNode->isChecked()) // Our algorithm means this node is already at minimum cost.
 				continue;
@@ -249,8 +291,37 @@ bool Pathfinding::aStarPath(const Position &startPosition, const Position &endPo
  * @return TU cost or 255 if movement is impossible.
  */
 int Pathfinding::getTUCost(const Position &startPosition, int direction, Position *endPosition, BattleUnit *unit, BattleUnit *target, bool missile)
+{
+	return calculateTUCost(startPosition, direction, endPosition, unit, target, missile, 0);
+}
+
+/**
+ * Works out the TU cost to move from 1 tile to the other (ONE STEP ONLY).
+ * When a step cost entry is given, only the terrain is checked: the
+ * checks that depend on the units around are recorded in the entry
+ * instead of being done, and fire isn't added to the cost.
+ * @param startPosition The position to start from.
+ * @param direction The direction we are facing.
+ * @param endPosition The position we want to reach.
+ * @param unit The unit moving.
+ * @param target The target unit.
+ * @param missile Is this a guided missile?
+ * @param step Step cost entry to fill in, or 0 to do all the checks.
+ * @return TU cost or 255 if movement is impossible.
+ */
+int Pathfinding::calculateTUCost(const Position &startPosition, int direction, Position *endPosition, BattleUnit *unit, BattleUnit *target, bool missile, StepCost *step)
 {
 	_unit = unit;
+	if (step)
+	{
+		step->state = STEP_BLOCKED;
+		for (int i = 0; i < 4; ++i)
+		{
+			step->floorZ[i] = StepCost::NO_CHECK;
+			step->flyZ[i] = StepCost::NO_CHECK;
+		}
+		step->floorBlocked = 0;
+	}
 	directionToVector(direction, endPosition);
 	*endPosition += startPosition;
 	bool fellDown = false;
@@ -324,7 +395,12 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 						fellDown = true;
 					}
 			}
-			else if (_movementType == MT_FLY && belowDestination && belowDestination->getUnit() && belowDestination->getUnit() != unit)
+			else if (step && _movementType == MT_FLY && belowDestination)
+			{
+				// whoever is below may have moved by the next time
+				step->flyZ[x * (size+1) + y] = belowDestination->getPosition().z - startPosition.z;
+			}
+			else if (!step && _movementType == MT_FLY && belowDestination && belowDestination->getUnit() && belowDestination->getUnit() != unit)
 			{
 				// 2 or more voxels poking into this tile = no go
 				if (belowDestination->getUnit()->getHeight() + belowDestination->getUnit()->getFloatHeight() - belowDestination->getTerrainLevel() > 26)
@@ -365,6 +441,11 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 
 				if (numberOfPartsFalling == (size+1)*(size+1) && direction != DIR_DOWN)
 				{
+						if (step)
+						{
+							step->state = STEP_ZERO;
+							step->endZ = endPosition->z - startPosition.z;
+						}
 						return false;
 				}
 			}
@@ -401,7 +482,20 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 				}
 			}
 			// check if the destination tile can be walked over
-			if (isBlocked(destinationTile, O_FLOOR, target) || isBlocked(destinationTile, O_OBJECT, target))
+			if (step)
+			{
+				// units standing there decide if the floor counts, so leave that for later
+				step->floorZ[x * (size+1) + y] = destinationTile->getPosition().z - startPosition.z;
+				if (isBlocked(destinationTile, O_FLOOR, target, -1, false))
+				{
+					step->floorBlocked |= 1 << (x * (size+1) + y);
+				}
+				if (isBlocked(destinationTile, O_OBJECT, target))
+				{
+					return 255;
+				}
+			}
+			else if (isBlocked(destinationTile, O_FLOOR, target) || isBlocked(destinationTile, O_OBJECT, target))
 			{
 				return 255;
 			}
@@ -433,14 +527,9 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 				cost = (int)((double)cost * 1.5);
 			}
 			cost += wallcost;
-			if (_unit->getFaction() == FACTION_HOSTILE &&
-				destinationTile->getFire() > 0)
-				cost += 32; // try to find a better path, but don't exclude this path entirely.
-
-			// TFTD thing: tiles on fire are cost 2 TUs more for whatever reason.
-			if (_save->getDepth() > 0 && destinationTile->getFire() > 0)
+			if (!step)
 			{
-				cost += 2;
+				cost += getFireCost(destinationTile);
 			}
 
 			// Strafing costs +1 for forwards-ish or sidewards, propose +2 for backwards-ish directions
@@ -469,6 +558,13 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 			cost = 0;
 		}
 
+	if (step)
+	{
+		// the fire costs still have to be added before dividing between the parts
+		step->cost = totalCost;
+		step->endZ = endPosition->z - startPosition.z;
+	}
+
 	// for bigger sized units, check the path between parts in an X shape at the end position
 	if (size)
 	{
@@ -493,12 +589,191 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 			return 255;
 	}
 
+	if (step)
+	{
+		step->state = STEP_OPEN;
+	}
+
+	if (missile)
+		return 0;
+	else
+		return totalCost;
+}
+
+/**
+ * Gets the TU cost of a step for the searches. The terrain part of the
+ * cost is looked up from the step costs worked out before for units of
+ * the same size and movement, only the units and fire around are checked.
+ * @param startPosition The position to start from.
+ * @param direction The direction we are facing.
+ * @param endPosition The position we want to reach.
+ * @param unit The unit moving.
+ * @param target The target unit.
+ * @param missile Is this a guided missile?
+ * @return TU cost or 255 if movement is impossible.
+ */
+int Pathfinding::getCachedTUCost(const Position &startPosition, int direction, Position *endPosition, BattleUnit *unit, BattleUnit *target, bool missile)
+{
+	int size = unit->getArmor()->getSize() - 1;
+	if (size > 1 || (Options::strafe && _strafeMove) || _save->getTile(startPosition) == 0)
+	{
+		return getTUCost(startPosition, direction, endPosition, unit, target, missile);
+	}
+	const StepCost &step = getStepCost(startPosition, direction, unit, target);
+	if (step.state == STEP_BLOCKED)
+	{
+		return 255;
+	}
+
+	Position vector;
+	directionToVector(direction, &vector);
+	*endPosition = startPosition + vector;
+	endPosition->z = startPosition.z + step.endZ;
+	int totalCost = step.cost;
+	for (int x = 0; x <= size; ++x)
+		for (int y = 0; y <= size; ++y)
+		{
+			int part = x * (size+1) + y;
+			Position column = startPosition + vector + Position(x, y, 0);
+			if (step.flyZ[part] != StepCost::NO_CHECK)
+			{
+				Tile *belowDestination = _save->getTile(Position(column.x, column.y, startPosition.z + step.flyZ[part]));
+				BattleUnit *below = belowDestination->getUnit();
+				// 2 or more voxels poking into this tile = no go
+				if (below && below != unit && below->getHeight() + below->getFloatHeight() - belowDestination->getTerrainLevel() > 26)
+				{
+					return 255;
+				}
+			}
+			if (step.floorZ[part] != StepCost::NO_CHECK)
+			{
+				Tile *destinationTile = _save->getTile(Position(column.x, column.y, startPosition.z + step.floorZ[part]));
+				int blockage = unitBlockage(destinationTile, target);
+				if (blockage > 0 || (blockage == 0 && (step.floorBlocked & (1 << part))))
+				{
+					return 255;
+				}
+				if (step.state == STEP_OPEN)
+				{
+					totalCost += getFireCost(destinationTile);
+				}
+			}
+		}
+	if (step.state == STEP_ZERO)
+	{
+		return 0;
+	}
+	totalCost /= (size+1)*(size+1);
+
 	if (missile)
 		return 0;
 	else
 		return totalCost;
 }
 
+/**
+ * Gets the step cost entry for a step by a unit of the size and
+ * movement type of the given one, working it out if it isn't known.
+ * @param startPosition The position to start from, inside the map.
+ * @param direction The direction we are facing.
+ * @param unit The unit moving, no bigger than 2x2.
+ * @param target The target unit.
+ * @return Step cost entry.
+ */
+const Pathfinding::StepCost &Pathfinding::getStepCost(const Position &startPosition, int direction, BattleUnit *unit, BattleUnit *target)
+{
+	_unit = unit;
+	updateStepCosts();
+	int size = unit->getArmor()->getSize() - 1;
+	int context = ((size * 5 + _movementType) * 2 + (unit->getMovementType() == MT_FLY ? 1 : 0)) * 2 + (target ? 1 : 0);
+	if (context >= (int)_stepCosts.size())
+	{
+		_stepCosts.resize(context + 1);
+	}
+	std::vector<StepCost> &costs = _stepCosts[context];
+	if (costs.empty())
+	{
+		StepCost unknown;
+		unknown.state = STEP_UNKNOWN;
+		costs.assign(_size * 10, unknown);
+	}
+	StepCost &step = costs[_save->getTileIndex(startPosition) * 10 + direction];
+	if (step.state == STEP_UNKNOWN)
+	{
+		Position endPosition;
+		calculateTUCost(startPosition, direction, &endPosition, unit, target, false, &step);
+	}
+	return step;
+}
+
+/**
+ * Gets the TU cost of a step as far as the terrain is concerned,
+ * without looking at units or fire. Used by the clusters.
+ * @param startPosition The position to start from, inside the map.
+ * @param direction The direction we are facing.
+ * @param endPosition The position we want to reach.
+ * @param unit The unit moving, no bigger than 2x2.
+ * @return TU cost or 255 if the terrain doesn't allow the step.
+ */
+int Pathfinding::getTerrainTUCost(const Position &startPosition, int direction, Position *endPosition, BattleUnit *unit)
+{
+	const StepCost &step = getStepCost(startPosition, direction, unit, 0);
+	if (step.state == STEP_BLOCKED)
+	{
+		return 255;
+	}
+	directionToVector(direction, endPosition);
+	*endPosition += startPosition;
+	endPosition->z = startPosition.z + step.endZ;
+	if (step.state == STEP_ZERO)
+	{
+		return 0;
+	}
+	int size = unit->getArmor()->getSize();
+	return step.cost / (size * size);
+}
+
+/**
+ * Forgets the step costs around the tiles whose terrain
+ * changed since the costs were last brought up to date.
+ */
+void Pathfinding::updateStepCosts()
+{
+	if (_stepCostStamp == Tile::getTerrainChanges())
+	{
+		return;
+	}
+	bool cached = false;
+	for (std::vector<std::vector<StepCost> >::const_iterator i = _stepCosts.begin(); i != _stepCosts.end(); ++i)
+	{
+		cached = cached || !i->empty();
+	}
+	for (int i = 0; cached && i < _size; ++i)
+	{
+		Tile *tile = _save->getTiles()[i];
+		if (tile->getTerrainStamp() <= _stepCostStamp)
+		{
+			continue;
+		}
+		// a step looks at most two tiles away from where it starts
+		Position pos = tile->getPosition();
+		for (int z = std::max(0, pos.z - 2); z <= std::min(_save->getMapSizeZ() - 1, pos.z + 2); ++z)
+			for (int y = std::max(0, pos.y - 2); y <= std::min(_save->getMapSizeY() - 1, pos.y + 2); ++y)
+				for (int x = std::max(0, pos.x - 2); x <= std::min(_save->getMapSizeX() - 1, pos.x + 2); ++x)
+				{
+					int index = _save->getTileIndex(Position(x, y, z)) * 10;
+					for (std::vector<std::vector<StepCost> >::iterator costs = _stepCosts.begin(); costs != _stepCosts.end(); ++costs)
+					{
+						for (int dir = 0; dir < 10 && !costs->empty(); ++dir)
+						{
+							(*costs)[index + dir].state = STEP_UNKNOWN;
+						}
+					}
+				}
+	}
+	_stepCostStamp = Tile::getTerrainChanges();
+}
+
 /**
  * Converts direction to a vector. Direction starts north = 0 and goes clockwise.
  * @param direction Source direction.
@@ -573,7 +848,7 @@ void Pathfinding::abortPath()
  * @param missileTarget Target for a missile.
  * @return True if the movement is blocked.
  */
-bool Pathfinding::isBlocked(Tile *tile, const int part, BattleUnit *missileTarget, int bigWallExclusion)
+bool Pathfinding::isBlocked(Tile *tile, const int part, BattleUnit *missileTarget, int bigWallExclusion, bool checkUnits)
 {
 	if (tile == 0) return true; // probably outside the map here
 
@@ -613,45 +888,12 @@ bool Pathfinding::isBlocked(Tile *tile, const int part, BattleUnit *missileTarge
 			tileNorth->getMapData(O_OBJECT)->getBigWall() == BIGWALLEASTANDSOUTH))
 			return true; // blocking part
 	}
-	if (part == O_FLOOR)
+	if (part == O_FLOOR && checkUnits)
 	{
-		BattleUnit *unit = tile->getUnit();
-		if (unit != 0)
+		int blockage = unitBlockage(tile, missileTarget);
+		if (blockage != 0)
 		{
-			if (unit == _unit || unit == missileTarget || unit->isOut()) return false;
-			if (_unit && _unit->getFaction() == FACTION_PLAYER && unit->getVisible()) return true;		// player know all visible units
-			if (_unit && _unit->getFaction() == unit->getFaction()) return true;
-			if (_unit && _unit->getFaction() == FACTION_HOSTILE && 
-				std::find(_unit->getUnitsSpottedThisTurn().begin(), _unit->getUnitsSpottedThisTurn().end(), unit) != _unit->getUnitsSpottedThisTurn().end()) return true;
-		}
-		else if (tile->hasNoFloor(0) && _movementType != MT_FLY) // this whole section is devoted to making large units not take part in any kind of falling behaviour
-		{
-			Position pos = tile->getPosition();
-			while (pos.z >= 0)
-			{
-				Tile *t = _save->getTile(pos);
-				BattleUnit *unit = t->getUnit();
-
-				if (unit != 0 && unit != _unit)
-				{
-					// don't let large units fall on other units
-					if (_unit && _unit->getArmor()->getSize() > 1)
-					{
-						return true;
-					}
-					// don't let any units fall on large units
-					if (unit != _unit && unit != missileTarget && !unit->isOut() && unit->getArmor()->getSize() > 1)
-					{
-						return true;
-					}
-				}
-				// not gonna fall any further, so we can stop checking.
-				if (!t->hasNoFloor(0))
-				{
-					break;
-				}
-				pos.z--;
-			}
+			return blockage > 0;
 		}
 	}
 	// missiles can't pathfind through closed doors.
@@ -666,6 +908,77 @@ bool Pathfinding::isBlocked(Tile *tile, const int part, BattleUnit *missileTarge
 	return false;
 }
 
+/**
+ * Determines whether the units on a tile, or the ones a unit
+ * would fall onto from it, block movement.
+ * @param tile Specified tile.
+ * @param missileTarget Target for a missile.
+ * @return 1 if the movement is blocked, -1 if a unit there lets us
+ * through no matter what the floor is like, 0 if it's up to the floor.
+ */
+int Pathfinding::unitBlockage(Tile *tile, BattleUnit *missileTarget)
+{
+	BattleUnit *unit = tile->getUnit();
+	if (unit != 0)
+	{
+		if (unit == _unit || unit == missileTarget || unit->isOut()) return -1;
+		if (_unit && _unit->getFaction() == FACTION_PLAYER && unit->getVisible()) return 1;		// player know all visible units
+		if (_unit && _unit->getFaction() == unit->getFaction()) return 1;
+		if (_unit && _unit->getFaction() == FACTION_HOSTILE && 
+			std::find(_unit->getUnitsSpottedThisTurn().begin(), _unit->getUnitsSpottedThisTurn().end(), unit) != _unit->getUnitsSpottedThisTurn().end()) return 1;
+	}
+	else if (tile->hasNoFloor(0) && _movementType != MT_FLY) // this whole section is devoted to making large units not take part in any kind of falling behaviour
+	{
+		Position pos = tile->getPosition();
+		while (pos.z >= 0)
+		{
+			Tile *t = _save->getTile(pos);
+			BattleUnit *unit = t->getUnit();
+
+			if (unit != 0 && unit != _unit)
+			{
+				// don't let large units fall on other units
+				if (_unit && _unit->getArmor()->getSize() > 1)
+				{
+					return 1;
+				}
+				// don't let any units fall on large units
+				if (unit != _unit && unit != missileTarget && !unit->isOut() && unit->getArmor()->getSize() > 1)
+				{
+					return 1;
+				}
+			}
+			// not gonna fall any further, so we can stop checking.
+			if (!t->hasNoFloor(0))
+			{
+				break;
+			}
+			pos.z--;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Gets the extra TU cost of walking into a tile on fire.
+ * @param tile Destination tile.
+ * @return Extra TU cost.
+ */
+int Pathfinding::getFireCost(Tile *tile) const
+{
+	int cost = 0;
+	if (_unit->getFaction() == FACTION_HOSTILE &&
+		tile->getFire() > 0)
+		cost += 32; // try to find a better path, but don't exclude this path entirely.
+
+	// TFTD thing: tiles on fire are cost 2 TUs more for whatever reason.
+	if (_save->getDepth() > 0 && tile->getFire() > 0)
+	{
+		cost += 2;
+	}
+	return cost;
+}
+
 /**
  * Determines whether going from one tile to another blocks movement.
  * @param startTile The tile to start from.
@@ -1131,13 +1444,10 @@ std::vector<int> Pathfinding::findReachable(BattleUnit *unit, int tuMax)
 {
 	const Position &start = unit->getPosition();
 	int energyMax = unit->getEnergy();
-	for (std::vector<PathfindingNode>::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
-	{
-		it->reset();
-	}
+	newSearch();
 	PathfindingNode *startNode = getNode(start);
 	startNode->connect(0, 0, 0);
-	PathfindingOpenSet unvisited;
+	PathfindingOpenSet &unvisited = _openSet;
 	unvisited.push(startNode);
 	std::vector<PathfindingNode*> reachable;
 	while (!unvisited.empty())
@@ -1149,7 +1459,7 @@ std::vector<int> Pathfinding::findReachable(BattleUnit *unit, int tuMax)
 		for (int direction = 0; direction < 10; direction++)
 		{
 			Position nextPos;
-			int tuCost = getTUCost(currentPos, direction, &nextPos, unit, 0, false);
+			int tuCost = getCachedTUCost(currentPos, direction, &nextPos, unit, 0, false);
 			if (tuCost == 255) // Skip unreachable / blocked
 				continue;
 			if (currentNode->getTUCost(false) + tuCost > tuMax || 
@@ -20,14 +20,17 @@
 #define OPENXCOM_PATHFINDING_H
 
 #include <vector>
+#include <SDL_types.h>
 #include "Position.h"
 #include "PathfindingNode.h"
+#include "PathfindingOpenSet.h"
 #include "../Mod/MapData.h"
 
 namespace OpenXcom
 {
 
 class SavedBattleGame;
+class PathfindingClusters;
 class Tile;
 class BattleUnit;
 
@@ -37,8 +40,25 @@ class BattleUnit;
 class Pathfinding
 {
 private:
+	enum StepState { STEP_UNKNOWN, STEP_BLOCKED, STEP_OPEN, STEP_ZERO };
+	/// What the terrain says about a step, and which unit checks are left to do.
+	struct StepCost
+	{
+		static const Sint8 NO_CHECK = 127;
+		Sint16 cost;
+		Uint8 state;
+		Uint8 floorBlocked;
+		Sint8 endZ;
+		Sint8 floorZ[4], flyZ[4];
+	};
 	SavedBattleGame *_save;
 	std::vector<PathfindingNode> _nodes;
+	PathfindingOpenSet _openSet;
+	unsigned int _generation;
+	std::vector<std::vector<StepCost> > _stepCosts;
+	unsigned int _stepCostStamp;
+	PathfindingClusters *_clusters;
+	bool _bounded;
 	int _size;
 	BattleUnit *_unit;
 	bool _pathPreviewed;
@@ -46,10 +66,27 @@ private:
 	int _totalTUCost;
 	bool _modifierUsed;
 	MovementType _movementType;
+	/// Starts a new search over the nodes.
+	void newSearch();
 	/// Gets the node at certain position.
 	PathfindingNode *getNode(const Position& pos);
 	/// Determines whether a tile blocks a certain movementType.
-	bool isBlocked(Tile *tile, const int part, BattleUnit *missileTarget, int bigWallExclusion = -1);
+	bool isBlocked(Tile *tile, const int part, BattleUnit *missileTarget, int bigWallExclusion = -1, bool checkUnits = true);
+	/// Determines whether the units on a tile block movement.
+	int unitBlockage(Tile *tile, BattleUnit *missileTarget);
+	/// Gets the extra TU cost of walking into fire.
+	int getFireCost(Tile *tile) const;
+	/// Works out the TU cost of a step, optionally leaving the unit checks for later.
+	int calculateTUCost(const Position &startPosition, int direction, Position *endPosition, BattleUnit *unit, BattleUnit *target, bool missile, StepCost *step);
+	/// Gets the TU cost of a step from the step costs.
+	int getCachedTUCost(const Position &startPosition, int direction, Position *endPosition, BattleUnit *unit, BattleUnit *target, bool missile);
+	/// Gets the step cost entry of a step.
+	const StepCost &getStepCost(const Position &startPosition, int direction, BattleUnit *unit, BattleUnit *target);
+	/// Gets the TU cost of a step as far as the terrain goes.
+	int getTerrainTUCost(const Position &startPosition, int direction, Position *endPosition, BattleUnit *unit);
+	/// Forgets the step costs around changed terrain.
+	void updateStepCosts();
+	friend class PathfindingClusters;
 	/// Tries to find a straight line path between two positions.
 	bool bresenhamPath(const Position& origin, const Position& target, BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000);
 	/// Tries to find a path between two positions.
@@ -68,6 +105,8 @@ public:
 	static const int DIR_DOWN = 9;
 	enum bigWallTypes{ BLOCK = 1, BIGWALLNESW, BIGWALLNWSE, BIGWALLWEST, BIGWALLNORTH, BIGWALLEAST, BIGWALLSOUTH, BIGWALLEASTANDSOUTH, BIGWALLWESTANDNORTH};
 	static const int O_BIGWALL = -1;
+	/// Paths longer than this in tiles look for a route through the clusters first.
+	static const int LONG_PATH = 20;
 	static int red;
 	static int green;
 	static int yellow;
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "PathfindingClusters.h"
+#include <algorithm>
+#include "Pathfinding.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/Tile.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Mod/Armor.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates the clusters for a battle. The links for each
+ * kind of unit are worked out the first time they're needed.
+ * @param save Pointer to the battle.
+ * @param pathfinding Pointer to the pathfinding working out the steps.
+ */
+PathfindingClusters::PathfindingClusters(SavedBattleGame *save, Pathfinding *pathfinding) : _save(save), _pathfinding(pathfinding), _search(0)
+{
+	_width = (_save->getMapSizeX() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+	_length = (_save->getMapSizeY() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+	_height = _save->getMapSizeZ();
+	_visited.resize(_width * _length * _height, -1);
+	_corridor.resize(_width * _length * _height, 0);
+}
+
+/**
+ * Cleans up the clusters.
+ */
+PathfindingClusters::~PathfindingClusters()
+{
+}
+
+/**
+ * Gets the cluster a position on the map is in.
+ * @param pos Map position.
+ * @return Cluster index.
+ */
+int PathfindingClusters::getCluster(const Position &pos) const
+{
+	return (pos.z * _length + pos.y / CLUSTER_SIZE) * _width + pos.x / CLUSTER_SIZE;
+}
+
+/**
+ * Gets the bit that links a cluster to one of its neighbours.
+ * @param dx Offset of the neighbour in the X axis, -1 to 1.
+ * @param dy Offset of the neighbour in the Y axis, -1 to 1.
+ * @param dz Offset of the neighbour in the Z axis, -1 to 1.
+ * @return Link bit number.
+ */
+int PathfindingClusters::getLink(int dx, int dy, int dz)
+{
+	return ((dz + 1) * 3 + dy + 1) * 3 + dx + 1;
+}
+
+/**
+ * Tries every step from every tile of a cluster and links
+ * it to the clusters the terrain lets the unit step into.
+ * @param links Links of the kind of unit.
+ * @param cluster Cluster index.
+ * @param unit Unit to try the steps with.
+ */
+void PathfindingClusters::linkCluster(std::vector<Uint32> &links, int cluster, BattleUnit *unit)
+{
+	int cx = cluster % _width;
+	int cy = (cluster / _width) % _length;
+	int cz = cluster / (_width * _length);
+	Uint32 link = 0;
+	int maxX = std::min(_save->getMapSizeX(), (cx + 1) * CLUSTER_SIZE);
+	int maxY = std::min(_save->getMapSizeY(), (cy + 1) * CLUSTER_SIZE);
+	for (int y = cy * CLUSTER_SIZE; y < maxY; ++y)
+	{
+		for (int x = cx * CLUSTER_SIZE; x < maxX; ++x)
+		{
+			Position start(x, y, cz);
+			for (int dir = 0; dir < 10; ++dir)
+			{
+				Position end;
+				if (_pathfinding->getTerrainTUCost(start, dir, &end, unit) < 255 &&
+					end.x >= 0 && end.y >= 0 && end.z >= 0 && end.x < _save->getMapSizeX() && end.y < _save->getMapSizeY() && end.z < _save->getMapSizeZ())
+				{
+					int dx = end.x / CLUSTER_SIZE - cx;
+					int dy = end.y / CLUSTER_SIZE - cy;
+					int dz = std::max(-1, std::min(1, end.z - cz));
+					if (dx || dy || dz)
+					{
+						link |= 1 << getLink(dx, dy, dz);
+					}
+				}
+			}
+		}
+	}
+	links[cluster] = link;
+}
+
+/**
+ * Brings the links for a kind of unit up to date with the terrain,
+ * relinking the clusters where a step could have been changed.
+ * @param kind Kind of unit.
+ * @param unit Unit to try the steps with.
+ */
+void PathfindingClusters::update(int kind, BattleUnit *unit)
+{
+	std::vector<Uint32> &links = _links[kind];
+	unsigned int &stamp = _stamps[kind];
+	if (links.empty())
+	{
+		links.resize(_width * _length * _height, 0);
+		for (int i = 0; i < (int)links.size(); ++i)
+		{
+			linkCluster(links, i, unit);
+		}
+		stamp = Tile::getTerrainChanges();
+		return;
+	}
+	if (stamp == Tile::getTerrainChanges())
+	{
+		return;
+	}
+	std::vector<bool> changed(links.size(), false);
+	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
+	{
+		Tile *tile = _save->getTiles()[i];
+		if (tile->getTerrainStamp() <= stamp)
+		{
+			continue;
+		}
+		// a step looks at most two tiles away from where it starts
+		Position pos = tile->getPosition();
+		for (int z = std::max(0, pos.z - 2); z <= std::min(_save->getMapSizeZ() - 1, pos.z + 2); ++z)
+			for (int y = std::max(0, pos.y - 2); y <= std::min(_save->getMapSizeY() - 1, pos.y + 2); ++y)
+				for (int x = std::max(0, pos.x - 2); x <= std::min(_save->getMapSizeX() - 1, pos.x + 2); ++x)
+				{
+					changed[getCluster(Position(x, y, z))] = true;
+				}
+	}
+	for (int i = 0; i < (int)links.size(); ++i)
+	{
+		if (changed[i])
+		{
+			linkCluster(links, i, unit);
+		}
+	}
+	stamp = Tile::getTerrainChanges();
+}
+
+/**
+ * Finds the shortest route through the clusters from one position
+ * to another, and marks the clusters along it and next to it as
+ * the corridor the full search can stay in. Units are left out,
+ * so if there's no route there's no path either.
+ * @param unit Unit looking for a path.
+ * @param start Start position.
+ * @param end End position.
+ * @return True if a route exists.
+ */
+bool PathfindingClusters::findRoute(BattleUnit *unit, const Position &start, const Position &end)
+{
+	int kind = (unit->getArmor()->getSize() - 1) * 5 + unit->getMovementType();
+	update(kind, unit);
+	const std::vector<Uint32> &links = _links[kind];
+
+	int from = getCluster(start);
+	int to = getCluster(end);
+	std::fill(_visited.begin(), _visited.end(), -1);
+	std::vector<int> queue;
+	queue.push_back(from);
+	_visited[from] = from;
+	for (size_t next = 0; next < queue.size() && _visited[to] == -1; ++next)
+	{
+		int cluster = queue[next];
+		int cx = cluster % _width;
+		int cy = (cluster / _width) % _length;
+		int cz = cluster / (_width * _length);
+		for (int link = 0; link < 27; ++link)
+		{
+			if (!(links[cluster] & (1 << link)))
+			{
+				continue;
+			}
+			int x = cx + link % 3 - 1;
+			int y = cy + (link / 3) % 3 - 1;
+			int z = cz + link / 9 - 1;
+			if (x < 0 || x >= _width || y < 0 || y >= _length || z < 0 || z >= _height)
+			{
+				continue;
+			}
+			int neighbour = (z * _length + y) * _width + x;
+			if (_visited[neighbour] == -1)
+			{
+				_visited[neighbour] = cluster;
+				queue.push_back(neighbour);
+			}
+		}
+	}
+	if (_visited[to] == -1)
+	{
+		return false;
+	}
+
+	++_search;
+	for (int cluster = to; ; cluster = _visited[cluster])
+	{
+		int cx = cluster % _width;
+		int cy = (cluster / _width) % _length;
+		int cz = cluster / (_width * _length);
+		for (int z = std::max(0, cz - 1); z <= std::min(_height - 1, cz + 1); ++z)
+			for (int y = std::max(0, cy - 1); y <= std::min(_length - 1, cy + 1); ++y)
+				for (int x = std::max(0, cx - 1); x <= std::min(_width - 1, cx + 1); ++x)
+				{
+					_corridor[(z * _length + y) * _width + x] = _search;
+				}
+		if (cluster == from)
+		{
+			break;
+		}
+	}
+	return true;
+}
+
+/**
+ * Checks if a position is in the corridor around the last route found.
+ * @param pos Map position.
+ * @return True if it's in the corridor.
+ */
+bool PathfindingClusters::inCorridor(const Position &pos) const
+{
+	return _corridor[getCluster(pos)] == _search;
+}
+
+}
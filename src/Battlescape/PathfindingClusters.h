@@ -0,0 +1,76 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_PATHFINDINGCLUSTERS_H
+#define OPENXCOM_PATHFINDINGCLUSTERS_H
+
+#include <vector>
+#include <map>
+#include <SDL_types.h>
+#include "Position.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class Pathfinding;
+class BattleUnit;
+
+/**
+ * A coarse view of the battlescape for long paths. The map is split
+ * into map block sized clusters on each level, and for every kind of
+ * unit it keeps track of which neighbouring clusters the terrain lets
+ * it step into. A route through the clusters tells if a far away
+ * position can be reached at all, and which part of the map the
+ * full search has to look at to get there.
+ */
+class PathfindingClusters
+{
+private:
+	static const int CLUSTER_SIZE = 10;
+	SavedBattleGame *_save;
+	Pathfinding *_pathfinding;
+	int _width, _length, _height;
+	/// Per kind of unit: for each cluster, a bit per neighbouring cluster it leads to.
+	std::map<int, std::vector<Uint32> > _links;
+	std::map<int, unsigned int> _stamps;
+	std::vector<int> _visited;
+	std::vector<unsigned int> _corridor;
+	unsigned int _search;
+	/// Gets the cluster a position is in.
+	int getCluster(const Position &pos) const;
+	/// Gets the link bit from a cluster to a neighbouring one.
+	static int getLink(int dx, int dy, int dz);
+	/// Works out where the steps from a cluster lead to.
+	void linkCluster(std::vector<Uint32> &links, int cluster, BattleUnit *unit);
+	/// Relinks the clusters around changed terrain.
+	void update(int kind, BattleUnit *unit);
+public:
+	/// Creates the clusters for a battle.
+	PathfindingClusters(SavedBattleGame *save, Pathfinding *pathfinding);
+	/// Cleans up the clusters.
+	~PathfindingClusters();
+	/// Finds a route through the clusters and marks the corridor around it.
+	bool findRoute(BattleUnit *unit, const Position &start, const Position &end);
+	/// Checks if a position is in the corridor of the last route.
+	bool inCorridor(const Position &pos) const;
+};
+
+}
+
+#endif
@@ -25,7 +25,6 @@ namespace OpenXcom
 {
 
 class PathfindingOpenSet;
-struct OpenSetEntry;
 
 /**
  * A class that holds pathfinding info for a certain node on the map.
@@ -34,6 +33,7 @@ class PathfindingNode
 {
 private:
 	Position _pos;
+	unsigned int _generation;
 	bool _checked;
 	int _tuCost;
 	PathfindingNode* _prevNode;
@@ -41,7 +41,7 @@ private:
 	/// Approximate cost to reach goal position.
 	int _tuGuess;
 	// Invasive field needed by PathfindingOpenSet
-	OpenSetEntry *_openentry;
+	int _openIndex;
 	friend class PathfindingOpenSet;
 public:
 	/// Creates a new PathfindingNode class.
@@ -50,8 +50,20 @@ public:
 	~PathfindingNode();
 	/// Gets the node position.
 	const Position &getPosition() const;
-	/// Resets the node.
-	void reset();
+	/**
+	 * Resets the node if it was last used by an older search,
+	 * so clearing all the nodes doesn't have to go through them.
+	 * @param generation Number of the current search.
+	 */
+	void reset(unsigned int generation)
+	{
+		if (_generation != generation)
+		{
+			_generation = generation;
+			_checked = false;
+			_openIndex = -1;
+		}
+	}
 	/// Is checked?
 	bool isChecked() const;
 	/// Marks the node as checked.
@@ -63,7 +75,7 @@ public:
 	/// Gets the previous walking direction.
 	int getPrevDir() const;
 	/// Is this node already in a PathfindingOpenSet?
-	bool inOpenSet() const { return (_openentry != 0); }
+	bool inOpenSet() const { return (_openIndex >= 0); }
 	/// Gets the approximate cost to reach the target position.
 	int getTUGuess() const { return _tuGuess; }
 
@@ -24,29 +24,98 @@ namespace OpenXcom
 {
 
 /**
- * Cleans up all the entries still in set.
+ * Takes all the nodes still in the set out of it.
  */
 PathfindingOpenSet::~PathfindingOpenSet()
 {
-	while (!_queue.empty())
+	clear();
+}
+
+/**
+ * Takes all the nodes out of the set.
+ * The heap keeps its memory for the next search.
+ */
+void PathfindingOpenSet::clear()
+{
+	for (std::vector<PathfindingNode*>::iterator i = _heap.begin(); i != _heap.end(); ++i)
+	{
+		(*i)->_openIndex = -1;
+	}
+	_heap.clear();
+}
+
+/**
+ * Gets the estimated total cost of a node in the heap:
+ * the cost so far plus the guess of the cost to the goal.
+ * @param index Place in the heap.
+ * @return Estimated cost.
+ */
+int PathfindingOpenSet::getCost(int index) const
+{
+	return _heap[index]->getTUCost(false) + _heap[index]->getTUGuess();
+}
+
+/**
+ * Puts a node at a place in the heap and lets it know where it is.
+ * @param node Pointer to the node.
+ * @param index Place in the heap.
+ */
+void PathfindingOpenSet::place(PathfindingNode *node, int index)
+{
+	_heap[index] = node;
+	node->_openIndex = index;
+}
+
+/**
+ * Moves a node towards the top of the heap while
+ * it costs less than its parent.
+ * @param index Place of the node in the heap.
+ */
+void PathfindingOpenSet::siftUp(int index)
+{
+	PathfindingNode *node = _heap[index];
+	int cost = getCost(index);
+	while (index > 0)
 	{
-		OpenSetEntry *entry = _queue.top();
-		_queue.pop();
-		delete entry;
+		int parent = (index - 1) / 2;
+		if (getCost(parent) <= cost)
+		{
+			break;
+		}
+		place(_heap[parent], index);
+		index = parent;
 	}
+	place(node, index);
 }
 
 /**
- * Keeps removing all discarded entries that have come to the top of the queue.
+ * Moves a node towards the bottom of the heap while
+ * one of its children costs less than it.
+ * @param index Place of the node in the heap.
  */
-void PathfindingOpenSet::removeDiscarded()
+void PathfindingOpenSet::siftDown(int index)
 {
-	while (!_queue.empty() && !_queue.top()->_node)
+	PathfindingNode *node = _heap[index];
+	int cost = getCost(index);
+	for (;;)
 	{
-		OpenSetEntry *entry = _queue.top();
-		_queue.pop();
-		delete entry;
+		int child = index * 2 + 1;
+		if (child >= (int)_heap.size())
+		{
+			break;
+		}
+		if (child + 1 < (int)_heap.size() && getCost(child + 1) < getCost(child))
+		{
+			++child;
+		}
+		if (cost <= getCost(child))
+		{
+			break;
+		}
+		place(_heap[child], index);
+		index = child;
 	}
+	place(node, index);
 }
 
 /**
@@ -57,33 +126,32 @@ void PathfindingOpenSet::removeDiscarded()
 PathfindingNode *PathfindingOpenSet::pop()
 {
 	assert(!empty());
-	OpenSetEntry *entry = _queue.top();
-	PathfindingNode *nd = entry->_node;
-	_queue.pop();
-	delete entry;
-	nd->_openentry = 0;
-
-	// Discarded entries might be visible now.
-	removeDiscarded();
+	PathfindingNode *nd = _heap.front();
+	PathfindingNode *last = _heap.back();
+	_heap.pop_back();
+	if (!_heap.empty())
+	{
+		place(last, 0);
+		siftDown(0);
+	}
+	nd->_openIndex = -1;
 	return nd;
 }
 
 /**
  * Places the node in the set.
- * If the node was already in the set, the previous entry is discarded.
+ * If the node was already in the set, it is moved to its new place.
  * It is the caller's responsibility to never re-add a node with a worse cost.
  * @param node A pointer to the node to add.
  */
 void PathfindingOpenSet::push(PathfindingNode *node)
 {
-	OpenSetEntry *entry = new OpenSetEntry;
-	entry->_node = node;
-	entry->_cost = node->getTUCost(false) + node->getTUGuess();
-	if (node->_openentry)
-		node->_openentry->_node = 0;
-	node->_openentry = entry;
-	_queue.push(entry);
+	if (node->_openIndex < 0)
+	{
+		_heap.push_back(node);
+		node->_openIndex = (int)_heap.size() - 1;
+	}
+	siftUp(node->_openIndex);
 }
 
-
 }
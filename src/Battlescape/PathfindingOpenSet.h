@@ -19,57 +19,45 @@
 #ifndef OPENXCOM_PATHFINDINGOPENSET_H
 #define OPENXCOM_PATHFINDINGOPENSET_H
 
-#include <queue>
+#include <vector>
 
 namespace OpenXcom
 {
 
 class PathfindingNode;
 
-struct OpenSetEntry
-{
-	int _cost;
-	PathfindingNode *_node;
-};
-
-/**
- * Helper class to compare entries through pointers.
- */
-class EntryCompare
-{
-public:
-	/**
-	 * Compares entries @a *a and @a *b.
-	 * @param a Pointer to first entry.
-	 * @param b Pointer to second entry.
-	 * @return True if entry @a *b must come before @a *a.
-	 */
-	bool operator()(OpenSetEntry *a, OpenSetEntry *b) const
-	{
-		return b->_cost < a->_cost;
-	}
-};
-
 /**
- * A class that holds references to the nodes to be examined in pathfinding.
+ * The open set of the pathfinding searches: a binary heap of nodes
+ * ordered by their estimated total cost. Every node knows its place
+ * in the heap, so a node found through a cheaper path is moved up
+ * instead of being added again, and nothing is allocated once the
+ * heap has grown to the size the searches need.
  */
 class PathfindingOpenSet
 {
 public:
-	/// Cleans up the set and frees allocated memory.
+	/// Cleans up the set.
 	~PathfindingOpenSet();
 	/// Gets the next node to check.
 	PathfindingNode *pop();
 	/// Adds a node to the set.
 	void push(PathfindingNode *node);
+	/// Empties the set, keeping its memory.
+	void clear();
 	/// Is the set empty?
-	bool empty() const { return _queue.empty(); }
+	bool empty() const { return _heap.empty(); }
 
 private:
-	std::priority_queue<OpenSetEntry*, std::vector<OpenSetEntry*>, EntryCompare> _queue;
+	std::vector<PathfindingNode*> _heap;
 
-	/// Removes reachable discarded entries.
-	void removeDiscarded();
+	/// Gets the estimated total cost of the node at a place in the heap.
+	int getCost(int index) const;
+	/// Puts a node at a place in the heap.
+	void place(PathfindingNode *node, int index);
+	/// Moves a node up the heap to where it belongs.
+	void siftUp(int index);
+	/// Moves a node down the heap to where it belongs.
+	void siftDown(int index);
 };
 
 }
@@ -123,6 +123,7 @@ int Projectile::calculateTrajectory(double accuracy, Position originVoxel, bool
 	Tile *targetTile = _save->getTile(_action.target);
 	BattleUnit *bu = _action.actor;
 	
+	_save->getTileEngine()->updateVoxels();
 	int test;
 	if (excludeUnit)
 	{
@@ -218,6 +219,7 @@ int Projectile::calculateThrow(double accuracy)
 {
 	Tile *targetTile = _save->getTile(_action.target);
 		
+	_save->getTileEngine()->updateVoxels();
 	Position originVoxel = _save->getTileEngine()->getOriginVoxel(_action, 0);
 	Position targetVoxel = _action.target * Position(16,16,24) + Position(8,8, (2 + -targetTile->getTerrainLevel()));
 
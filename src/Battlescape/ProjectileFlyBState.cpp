@@ -216,6 +216,7 @@ void ProjectileFlyBState::init()
 		Tile *targetTile = _parent->getSave()->getTile(_action.target);
 		Position hitPos;
 		Position originVoxel = _parent->getTileEngine()->getOriginVoxel(_action, _parent->getSave()->getTile(_origin));
+		_parent->getTileEngine()->updateVoxels();
 		if (targetTile->getUnit() != 0)
 		{
 			if (_origin == _action.target || targetTile->getUnit() == _unit)
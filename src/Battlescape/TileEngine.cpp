@@ -20,8 +20,10 @@
 #include <assert.h>
 #include <cmath>
 #include <climits>
-#include <set>
+#include <algorithm>
 #include "TileEngine.h"
+#include "LightField.h"
+#include "VoxelGrid.h"
 #include <SDL.h>
 #include "AlienBAIState.h"
 #include "Map.h"
@@ -44,6 +46,7 @@
 #include "ProjectileFlyBState.h"
 #include "MeleeAttackBState.h"
 #include "../Engine/Logger.h"
+#include "../Engine/ThreadPool.h"
 #include "../fmath.h"
 
 namespace OpenXcom
@@ -51,13 +54,53 @@ namespace OpenXcom
 
 const int TileEngine::heightFromCenter[11] = {0,-2,+2,-4,+4,-6,+6,-8,+8,-12,+12};
 
+/**
+ * Line of sight of several units, worked out on the worker threads.
+ */
+struct TileEngine::FovJob
+{
+	TileEngine *engine;
+	std::vector<BattleUnit*> units;
+	std::vector<UnitView*> views;
+	std::vector<std::vector<BattleUnit*> > seen;
+};
+
+/**
+ * Units that might spot a target, checked on the worker threads.
+ */
+struct TileEngine::SpotJob
+{
+	TileEngine *engine;
+	BattleUnit *target;
+	std::vector<BattleUnit*> spotters;
+	std::vector<char> canSpot;
+};
+
 /**
  * Sets up a TileEngine.
  * @param save Pointer to SavedBattleGame object.
  * @param voxelData List of voxel data.
  */
-TileEngine::TileEngine(SavedBattleGame *save, std::vector<Uint16> *voxelData) : _save(save), _voxelData(voxelData), _personalLighting(true)
+TileEngine::TileEngine(SavedBattleGame *save, std::vector<Uint16> *voxelData) : _save(save), _voxelData(voxelData), _personalLighting(true), _explosionEpoch(0)
 {
+	_terrainLight = new LightField(1);
+	_unitLight = new LightField(2);
+	_voxels = new VoxelGrid(_save, _voxelData);
+	resetLighting();
+
+	// raytrace every 3 degrees makes sure we cover all tiles in a circle.
+	for (int fi = -90; fi <= 90; fi += 5)
+	{
+		for (int te = 0; te <= 360; te += 3)
+		{
+			ExplosionRay ray;
+			ray.cos_te = cos(te * M_PI / 180.0);
+			ray.sin_te = sin(te * M_PI / 180.0);
+			ray.sin_fi = sin(fi * M_PI / 180.0);
+			ray.cos_fi = cos(fi * M_PI / 180.0);
+			_explosionRays.push_back(ray);
+		}
+	}
 }
 
 /**
@@ -65,7 +108,9 @@ TileEngine::TileEngine(SavedBattleGame *save, std::vector<Uint16> *voxelData) :
  */
 TileEngine::~TileEngine()
 {
-
+	delete _terrainLight;
+	delete _unitLight;
+	delete _voxels;
 }
 
 /**
@@ -114,112 +159,101 @@ void TileEngine::calculateSunShading(Tile *tile)
 
 /**
   * Recalculates lighting for the terrain: objects,items,fire.
+  * Only the light sources that changed since the last time get
+  * added to or removed from the light field.
   */
 void TileEngine::calculateTerrainLighting()
 {
-	const int layer = 1; // Static lighting layer.
 	const int fireLightPower = 15; // amount of light a fire generates
 
-	// reset all light to 0 first
-	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
-	{
-		_save->getTiles()[i]->resetLight(layer);
-	}
+	std::vector<LightField::Source> sources;
 
 	// add lighting of terrain
 	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
 	{
+		Tile *tile = _save->getTiles()[i];
 		// only floors and objects can light up
-		if (_save->getTiles()[i]->getMapData(O_FLOOR)
-			&& _save->getTiles()[i]->getMapData(O_FLOOR)->getLightSource())
+		if (tile->getMapData(O_FLOOR)
+			&& tile->getMapData(O_FLOOR)->getLightSource())
 		{
-			addLight(_save->getTiles()[i]->getPosition(), _save->getTiles()[i]->getMapData(O_FLOOR)->getLightSource(), layer);
+			sources.push_back(_terrainLight->getSource(tile->getPosition(), tile->getMapData(O_FLOOR)->getLightSource()));
 		}
-		if (_save->getTiles()[i]->getMapData(O_OBJECT)
-			&& _save->getTiles()[i]->getMapData(O_OBJECT)->getLightSource())
+		if (tile->getMapData(O_OBJECT)
+			&& tile->getMapData(O_OBJECT)->getLightSource())
 		{
-			addLight(_save->getTiles()[i]->getPosition(), _save->getTiles()[i]->getMapData(O_OBJECT)->getLightSource(), layer);
+			sources.push_back(_terrainLight->getSource(tile->getPosition(), tile->getMapData(O_OBJECT)->getLightSource()));
 		}
 
 		// fires
-		if (_save->getTiles()[i]->getFire())
+		if (tile->getFire())
 		{
-			addLight(_save->getTiles()[i]->getPosition(), fireLightPower, layer);
+			sources.push_back(_terrainLight->getSource(tile->getPosition(), fireLightPower));
 		}
 
-		for (std::vector<BattleItem*>::iterator it = _save->getTiles()[i]->getInventory()->begin(); it != _save->getTiles()[i]->getInventory()->end(); ++it)
+		for (std::vector<BattleItem*>::iterator it = tile->getInventory()->begin(); it != tile->getInventory()->end(); ++it)
 		{
 			if ((*it)->getRules()->getBattleType() == BT_FLARE)
 			{
-				addLight(_save->getTiles()[i]->getPosition(), (*it)->getRules()->getPower(), layer);
+				sources.push_back(_terrainLight->getSource(tile->getPosition(), (*it)->getRules()->getPower()));
 			}
 		}
 
 	}
 
+	_terrainLight->setSources(sources);
 }
 
 /**
   * Recalculates lighting for the units.
+  * Only units that moved or changed their light get
+  * added to or removed from the light field.
   */
 void TileEngine::calculateUnitLighting()
 {
-	const int layer = 2; // Dynamic lighting layer.
 	const int personalLightPower = 15; // amount of light a unit generates
 	const int fireLightPower = 15; // amount of light a fire generates
 
-	// reset all light to 0 first
-	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
-	{
-		_save->getTiles()[i]->resetLight(layer);
-	}
+	std::vector<LightField::Source> sources;
 
 	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
 	{
+		// units outside the map (ie. in the craft) don't light anything
+		if (!_save->getTile((*i)->getPosition()))
+		{
+			continue;
+		}
 		// add lighting of soldiers
 		if (_personalLighting && (*i)->getFaction() == FACTION_PLAYER && !(*i)->isOut())
 		{
-			addLight((*i)->getPosition(), personalLightPower, layer);
+			sources.push_back(_unitLight->getSource((*i)->getPosition(), personalLightPower));
 		}
 		// add lighting of units on fire
 		if ((*i)->getFire())
 		{
-			addLight((*i)->getPosition(), fireLightPower, layer);
+			sources.push_back(_unitLight->getSource((*i)->getPosition(), fireLightPower));
 		}
 	}
+
+	_unitLight->setSources(sources);
 }
 
 /**
- * Adds circular light pattern starting from center and losing power with distance travelled.
- * @param center Center.
- * @param power Power.
- * @param layer Light is separated in 3 layers: Ambient, Static and Dynamic.
+ * Clears the terrain and unit lighting and sets up the
+ * light fields for the current map. Must be called when
+ * the map tiles are recreated.
  */
-void TileEngine::addLight(const Position &center, int power, int layer)
+void TileEngine::resetLighting()
 {
-	// only loop through the positive quadrant.
-	for (int x = 0; x <= power; ++x)
-	{
-		for (int y = 0; y <= power; ++y)
-		{
-			for (int z = 0; z < _save->getMapSizeZ(); z++)
-			{
-				int distance = (int)Round(sqrt(float(x*x + y*y)));
-
-				if (_save->getTile(Position(center.x + x,center.y + y, z)))
-					_save->getTile(Position(center.x + x,center.y + y, z))->addLight(power - distance, layer);
+	const int terrainLayer = 1; // Static lighting layer.
+	const int unitLayer = 2; // Dynamic lighting layer.
 
-				if (_save->getTile(Position(center.x - x,center.y - y, z)))
-					_save->getTile(Position(center.x - x,center.y - y, z))->addLight(power - distance, layer);
-
-				if (_save->getTile(Position(center.x - x,center.y + y, z)))
-					_save->getTile(Position(center.x - x,center.y + y, z))->addLight(power - distance, layer);
-
-				if (_save->getTile(Position(center.x + x,center.y - y, z)))
-					_save->getTile(Position(center.x + x,center.y - y, z))->addLight(power - distance, layer);
-			}
-		}
+	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
+	{
+		_save->getTiles()[i]->resetLight(terrainLayer);
+		_save->getTiles()[i]->resetLight(unitLayer);
 	}
+	_terrainLight->reset(_save->getTiles(), _save->getMapSizeX(), _save->getMapSizeY(), _save->getMapSizeZ());
+	_unitLight->reset(_save->getTiles(), _save->getMapSizeX(), _save->getMapSizeY(), _save->getMapSizeZ());
 }
 
 /**
@@ -229,7 +263,27 @@ void TileEngine::addLight(const Position &center, int power, int layer)
  */
 bool TileEngine::calculateFOV(BattleUnit *unit)
 {
-	size_t oldNumVisibleUnits = unit->getUnitsSpottedThisTurn().size();
+	std::vector<BattleUnit*> seen;
+	UnitView *view = 0;
+	if (unit->getFaction() == FACTION_PLAYER && !unit->isOut())
+	{
+		view = &_views[unit->getId()];
+	}
+	_voxels->update();
+	computeFOV(unit, view, seen);
+	return commitFOV(unit, view, seen);
+}
+
+/**
+ * Works out what a unit sees, without changing anything on
+ * the map or in the units, so it can be run for several
+ * units at once.
+ * @param unit Unit to check line of sight of.
+ * @param view Cached view of a player unit, which gets updated, or 0 for other units.
+ * @param seen Gets filled with the units in line of sight.
+ */
+void TileEngine::computeFOV(BattleUnit *unit, UnitView *view, std::vector<BattleUnit*> &seen)
+{
 	Position center = unit->getPosition();
 	Position test;
 	int direction;
@@ -247,11 +301,8 @@ bool TileEngine::calculateFOV(BattleUnit *unit)
 	int signY[8] = { -1, -1, -1, +1, +1, +1, -1, -1 };
 	int y1, y2;
 
-	unit->clearVisibleUnits();
-	unit->clearVisibleTiles();
-
 	if (unit->isOut())
-		return false;
+		return;
 	Position pos = unit->getPosition();
 
 	if ((unit->getHeight() + unit->getFloatHeight() + -_save->getTile(unit->getPosition())->getTerrainLevel()) >= 24 + 4)
@@ -262,6 +313,36 @@ bool TileEngine::calculateFOV(BattleUnit *unit)
 			++pos.z;
 		}
 	}
+
+	// rays to tiles closer than any terrain change since the last time are
+	// still the same, so only replay the tiles they discovered
+	int size = unit->getArmor()->getSize();
+	int reuseDistanceSqr = 0;
+	std::vector<int> oldTiles, oldRayEnds;
+	size_t ray = 0;
+	if (view)
+	{
+		if (view->origin == pos && view->direction == direction && view->size == size && !view->rayEnds.empty())
+		{
+			int margin = 2 * size + 1;
+			int changeDistanceSqr = terrainChangeDistanceSq(center, MAX_VIEW_DISTANCE + margin, view->terrainStamp);
+			if (changeDistanceSqr == INT_MAX)
+			{
+				reuseDistanceSqr = INT_MAX;
+			}
+			else
+			{
+				int reach = (int)floor(sqrt((double)changeDistanceSqr)) - margin;
+				reuseDistanceSqr = reach > 0 ? reach * reach : 0;
+			}
+		}
+		oldTiles.swap(view->tiles);
+		oldRayEnds.swap(view->rayEnds);
+		view->origin = pos;
+		view->direction = direction;
+		view->size = size;
+		view->terrainStamp = Tile::getTerrainChanges();
+	}
 	for (int x = 0; x <= MAX_VIEW_DISTANCE; ++x)
 	{
 		if (direction%2)
@@ -289,60 +370,95 @@ bool TileEngine::calculateFOV(BattleUnit *unit)
 						BattleUnit *visibleUnit = _save->getTile(test)->getUnit();
 						if (visibleUnit && !visibleUnit->isOut() && visible(unit, _save->getTile(test)))
 						{
-							if (unit->getFaction() == FACTION_PLAYER)
-							{
-								visibleUnit->getTile()->setVisible(+1);
-								visibleUnit->setVisible(true);
-							}
-							if ((visibleUnit->getFaction() == FACTION_HOSTILE && unit->getFaction() == FACTION_PLAYER)
-								|| (visibleUnit->getFaction() != FACTION_HOSTILE && unit->getFaction() == FACTION_HOSTILE))
-							{
-								unit->addToVisibleUnits(visibleUnit);
-								unit->addToVisibleTiles(visibleUnit->getTile());
-
-								if (unit->getFaction() == FACTION_HOSTILE && visibleUnit->getFaction() != FACTION_HOSTILE)
-								{
-									visibleUnit->setTurnsSinceSpotted(0);
-								}
-							}
+							seen.push_back(visibleUnit);
 						}
 
-						if (unit->getFaction() == FACTION_PLAYER)
+						if (view)
 						{
-							// this sets tiles to discovered if they are in LOS - tile visibility is not calculated in voxelspace but in tilespace
-							// large units have "4 pair of eyes"
-							int size = unit->getArmor()->getSize();
-							for (int xo = 0; xo < size; xo++)
+							if (distanceSqr < reuseDistanceSqr)
+							{
+								view->tiles.insert(view->tiles.end(), oldTiles.begin() + (ray == 0 ? 0 : oldRayEnds[ray - 1]), oldTiles.begin() + oldRayEnds[ray]);
+							}
+							else
 							{
-								for (int yo = 0; yo < size; yo++)
+								// this finds tiles in LOS - tile visibility is not calculated in voxelspace but in tilespace
+								// large units have "4 pair of eyes"
+								for (int xo = 0; xo < size; xo++)
 								{
-									Position poso = pos + Position(xo,yo,0);
-									_trajectory.clear();
-									int tst = calculateLine(poso, test, true, &_trajectory, unit, false);
-									size_t tsize = _trajectory.size();
-									if (tst>127) --tsize; //last tile is blocked thus must be cropped
-									for (size_t i = 0; i < tsize; i++)
+									for (int yo = 0; yo < size; yo++)
 									{
-										Position posi = _trajectory.at(i);
-										//mark every tile of line as visible (as in original)
-										//this is needed because of bresenham narrow stroke.
-										_save->getTile(posi)->setVisible(+1);
-										_save->getTile(posi)->setDiscovered(true, 2);
-										// walls to the east or south of a visible tile, we see that too
-										Tile* t = _save->getTile(Position(posi.x + 1, posi.y, posi.z));
-										if (t) t->setDiscovered(true, 0);
-										t = _save->getTile(Position(posi.x, posi.y + 1, posi.z));
-										if (t) t->setDiscovered(true, 1);
-									}
+										Position poso = pos + Position(xo,yo,0);
+										_trajectory.clear();
+										int tst = calculateLine(poso, test, true, &_trajectory, unit, false);
+										size_t tsize = _trajectory.size();
+										if (tst>127) --tsize; //last tile is blocked thus must be cropped
+										for (size_t i = 0; i < tsize; i++)
+										{
+											view->tiles.push_back(_save->getTileIndex(_trajectory.at(i)));
+										}
 
+									}
 								}
 							}
+							view->rayEnds.push_back(view->tiles.size());
+							++ray;
 						}
 					}
 				}
 			}
 		}
 	}
+}
+
+/**
+ * Applies what a unit sees to the map and the units:
+ * spotted units and discovered tiles.
+ * @param unit Unit to check line of sight of.
+ * @param view Cached view of a player unit, or 0 for other units.
+ * @param seen Units in line of sight.
+ * @return True when new aliens are spotted.
+ */
+bool TileEngine::commitFOV(BattleUnit *unit, UnitView *view, const std::vector<BattleUnit*> &seen)
+{
+	size_t oldNumVisibleUnits = unit->getUnitsSpottedThisTurn().size();
+
+	unit->clearVisibleUnits();
+	unit->clearVisibleTiles();
+
+	if (unit->isOut())
+		return false;
+
+	for (std::vector<BattleUnit*>::const_iterator i = seen.begin(); i != seen.end(); ++i)
+	{
+		BattleUnit *visibleUnit = *i;
+		if (unit->getFaction() == FACTION_PLAYER)
+		{
+			visibleUnit->getTile()->setVisible(+1);
+			visibleUnit->setVisible(true);
+		}
+		if ((visibleUnit->getFaction() == FACTION_HOSTILE && unit->getFaction() == FACTION_PLAYER)
+			|| (visibleUnit->getFaction() != FACTION_HOSTILE && unit->getFaction() == FACTION_HOSTILE))
+		{
+			unit->addToVisibleUnits(visibleUnit);
+			unit->addToVisibleTiles(visibleUnit->getTile());
+
+			if (unit->getFaction() == FACTION_HOSTILE && visibleUnit->getFaction() != FACTION_HOSTILE)
+			{
+				visibleUnit->setTurnsSinceSpotted(0);
+			}
+		}
+	}
+
+	if (view)
+	{
+		// this sets tiles to discovered if they are in LOS
+		for (std::vector<int>::const_iterator i = view->tiles.begin(); i != view->tiles.end(); ++i)
+		{
+			//mark every tile of line as visible (as in original)
+			//this is needed because of bresenham narrow stroke.
+			discoverTile(_save->getTiles()[*i]);
+		}
+	}
 
 	// we only react when there are at least the same amount of visible units as before AND the checksum is different
 	// this way we stop if there are the same amount of visible units, but a different unit is seen
@@ -356,6 +472,70 @@ bool TileEngine::calculateFOV(BattleUnit *unit)
 
 }
 
+/**
+ * Calculates line of sight of several units at once, working out
+ * what they see on the worker threads and then applying it in order,
+ * so the result is the same as calculating them one by one.
+ * @param units Units to check line of sight of.
+ */
+void TileEngine::calculateFOV(const std::vector<BattleUnit*> &units)
+{
+	FovJob job;
+	job.engine = this;
+	job.units = units;
+	job.views.resize(units.size(), 0);
+	job.seen.resize(units.size());
+	for (size_t i = 0; i < units.size(); ++i)
+	{
+		if (units[i]->getFaction() == FACTION_PLAYER && !units[i]->isOut())
+		{
+			job.views[i] = &_views[units[i]->getId()];
+		}
+	}
+	_voxels->update();
+	ThreadPool::getShared()->run(fovTask, &job, (int)units.size());
+	for (size_t i = 0; i < units.size(); ++i)
+	{
+		commitFOV(units[i], job.views[i], job.seen[i]);
+	}
+}
+
+/**
+ * Works out what one unit of a job sees.
+ * @param data The job.
+ * @param task Index of the unit.
+ */
+void TileEngine::fovTask(void *data, int task)
+{
+	FovJob *job = (FovJob*)data;
+	job->engine->computeFOV(job->units[task], job->views[task], job->seen[task]);
+}
+
+/**
+ * Brings the voxel grid up to date with the terrain. The line
+ * checks themselves don't, as they also run on the worker threads,
+ * so code on the main thread calling calculateLine(), canTargetUnit(),
+ * canTargetTile() or visible() directly does this first.
+ */
+void TileEngine::updateVoxels()
+{
+	_voxels->update();
+}
+
+/**
+ * Runs a batch of checks on the line of sight threads, after
+ * bringing the voxel grid up to date. The checks must only
+ * read the battle, like canTargetUnit() does.
+ * @param handler Function run for each check.
+ * @param data Data passed to the function.
+ * @param tasks Number of checks.
+ */
+void TileEngine::runChecks(void (*handler)(void *data, int task), void *data, int tasks)
+{
+	_voxels->update();
+	ThreadPool::getShared()->run(handler, data, tasks);
+}
+
 /**
  * Gets the origin voxel of a unit's eyesight (from just one eye or something? Why is it x+7??
  * @param currentUnit The watcher.
@@ -758,6 +938,58 @@ bool TileEngine::canTargetTile(Position *originVoxel, Tile *tile, int part, Posi
 	return false;
 }
 
+/**
+ * Marks a tile in the line of sight of a player unit as
+ * visible and discovered, along with the walls to the
+ * east and south of it.
+ * @param tile Tile in line of sight.
+ */
+void TileEngine::discoverTile(Tile *tile)
+{
+	Position pos = tile->getPosition();
+	tile->setVisible(+1);
+	tile->setDiscovered(true, 2);
+	// walls to the east or south of a visible tile, we see that too
+	Tile* t = _save->getTile(Position(pos.x + 1, pos.y, pos.z));
+	if (t) t->setDiscovered(true, 0);
+	t = _save->getTile(Position(pos.x, pos.y + 1, pos.z));
+	if (t) t->setDiscovered(true, 1);
+}
+
+/**
+ * Finds the closest tile around a position whose terrain
+ * changed since a certain point, on any level of the map.
+ * @param center Position to look around.
+ * @param range Distance to look at in each direction.
+ * @param terrainStamp Terrain changes to ignore.
+ * @return Horizontal distance squared to the closest change, or INT_MAX if there are none.
+ */
+int TileEngine::terrainChangeDistanceSq(const Position &center, int range, unsigned int terrainStamp) const
+{
+	int closest = INT_MAX;
+	if (Tile::getTerrainChanges() == terrainStamp)
+	{
+		return closest;
+	}
+	int minX = std::max(0, center.x - range), maxX = std::min(_save->getMapSizeX() - 1, center.x + range);
+	int minY = std::max(0, center.y - range), maxY = std::min(_save->getMapSizeY() - 1, center.y + range);
+	for (int z = 0; z < _save->getMapSizeZ(); ++z)
+	{
+		for (int y = minY; y <= maxY; ++y)
+		{
+			for (int x = minX; x <= maxX; ++x)
+			{
+				if (_save->getTile(Position(x, y, z))->getTerrainStamp() > terrainStamp)
+				{
+					int dx = x - center.x, dy = y - center.y;
+					closest = std::min(closest, dx * dx + dy * dy);
+				}
+			}
+		}
+	}
+	return closest;
+}
+
 /**
  * Calculates line of sight of a soldiers within range of the Position
  * (used when terrain has changed, which can reveal new parts of terrain or units).
@@ -765,13 +997,15 @@ bool TileEngine::canTargetTile(Position *originVoxel, Tile *tile, int part, Posi
  */
 void TileEngine::calculateFOV(const Position &position)
 {
+	std::vector<BattleUnit*> units;
 	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
 	{
 		if (distanceSq(position, (*i)->getPosition()) <= MAX_VIEW_DISTANCE_SQR)
 		{
-			calculateFOV(*i);
+			units.push_back(*i);
 		}
 	}
+	calculateFOV(units);
 }
 
 /**
@@ -832,7 +1066,9 @@ bool TileEngine::checkReactionFire(BattleUnit *unit)
 std::vector<std::pair<BattleUnit *, int> > TileEngine::getSpottingUnits(BattleUnit* unit)
 {
 	std::vector<std::pair<BattleUnit *, int> > spotters;
-	Tile *tile = unit->getTile();
+	SpotJob job;
+	job.engine = this;
+	job.target = unit;
 	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
 	{
 			// not dead/unconscious
@@ -846,31 +1082,37 @@ std::vector<std::pair<BattleUnit *, int> > TileEngine::getSpottingUnits(BattleUn
 			// closer than 20 tiles
 			distanceSq(unit->getPosition(), (*i)->getPosition()) <= MAX_VIEW_DISTANCE_SQR)
 		{
-			Position originVoxel = _save->getTileEngine()->getSightOriginVoxel(*i);
-			originVoxel.z -= 2;
-			Position targetVoxel;
-			AlienBAIState *aggro = dynamic_cast<AlienBAIState*>((*i)->getCurrentAIState());
-			bool gotHit = (aggro != 0 && aggro->getWasHitBy(unit->getId()));
-				// can actually see the target Tile, or we got hit
-			if (((*i)->checkViewSector(unit->getPosition()) || gotHit) &&
-				// can actually target the unit
-				canTargetUnit(&originVoxel, tile, &targetVoxel, *i) &&
-				// can actually see the unit
-				visible(*i, tile))
+			job.spotters.push_back(*i);
+		}
+	}
+	job.canSpot.resize(job.spotters.size(), false);
+	_voxels->update();
+	if (job.spotters.size() > 1)
+	{
+		ThreadPool::getShared()->run(spotTask, &job, (int)job.spotters.size());
+	}
+	else if (!job.spotters.empty())
+	{
+		spotTask(&job, 0);
+	}
+
+	for (size_t i = 0; i < job.spotters.size(); ++i)
+	{
+		if (job.canSpot[i])
+		{
+			BattleUnit *spotter = job.spotters[i];
+			if (spotter->getFaction() == FACTION_PLAYER)
 			{
-				if ((*i)->getFaction() == FACTION_PLAYER)
-				{
-					unit->setVisible(true);
-				}
-				(*i)->addToVisibleUnits(unit);
-				// no reaction on civilian turn.
-				if (_save->getSide() != FACTION_NEUTRAL)
+				unit->setVisible(true);
+			}
+			spotter->addToVisibleUnits(unit);
+			// no reaction on civilian turn.
+			if (_save->getSide() != FACTION_NEUTRAL)
+			{
+				int attackType = determineReactionType(spotter, unit);
+				if (attackType != BA_NONE)
 				{
-					int attackType = determineReactionType(*i, unit);
-					if (attackType != BA_NONE)
-					{
-						spotters.push_back(std::make_pair(*i, attackType));
-					}
+					spotters.push_back(std::make_pair(spotter, attackType));
 				}
 			}
 		}
@@ -878,6 +1120,41 @@ std::vector<std::pair<BattleUnit *, int> > TileEngine::getSpottingUnits(BattleUn
 	return spotters;
 }
 
+/**
+ * Checks if one of the units of a job can spot its target.
+ * @param data The job.
+ * @param task Index of the spotting unit.
+ */
+void TileEngine::spotTask(void *data, int task)
+{
+	SpotJob *job = (SpotJob*)data;
+	job->canSpot[task] = job->engine->canSpot(job->spotters[task], job->target);
+}
+
+/**
+ * Checks if a unit can see and target another one, without
+ * changing anything, so it can be checked for several
+ * spotters at once.
+ * @param spotter Unit doing the spotting.
+ * @param unit Unit to spot.
+ * @return True if the unit can be spotted.
+ */
+bool TileEngine::canSpot(BattleUnit *spotter, BattleUnit *unit)
+{
+	Tile *tile = unit->getTile();
+	Position originVoxel = getSightOriginVoxel(spotter);
+	originVoxel.z -= 2;
+	Position targetVoxel;
+	AlienBAIState *aggro = dynamic_cast<AlienBAIState*>(spotter->getCurrentAIState());
+	bool gotHit = (aggro != 0 && aggro->getWasHitBy(unit->getId()));
+		// can actually see the target Tile, or we got hit
+	return ((spotter->checkViewSector(unit->getPosition()) || gotHit) &&
+		// can actually target the unit
+		canTargetUnit(&originVoxel, tile, &targetVoxel, spotter) &&
+		// can actually see the unit
+		visible(spotter, tile));
+}
+
 /**
  * Gets the unit with the highest reaction score from the spotter vector.
  * @param spotters The vector of spotting units.
@@ -1041,6 +1318,7 @@ BattleUnit *TileEngine::hit(const Position &center, int power, ItemDamageType ty
 		return 0;
 	}
 
+	_voxels->update();
 	BattleUnit *bu = tile->getUnit();
 	int adjustedDamage = 0;
 	const int part = voxelCheck(center, unit);
@@ -1143,8 +1421,8 @@ void TileEngine::explode(const Position &center, int power, ItemDamageType type,
 	double centerX = center.x / 16 + 0.5;
 	double centerY = center.y / 16 + 0.5;
 	int power_;
-	std::set<Tile*> tilesAffected;
-	std::pair<std::set<Tile*>::iterator,bool> ret;
+	std::vector<int> tilesAffected;
+	newExplosion();
 
 	if (type == DT_IN)
 	{
@@ -1167,193 +1445,188 @@ void TileEngine::explode(const Position &center, int power, ItemDamageType type,
 		vertdec = 5;
 	}
 
-	for (int fi = -90; fi <= 90; fi += 5)
+	for (std::vector<ExplosionRay>::const_iterator ray = _explosionRays.begin(); ray != _explosionRays.end(); ++ray)
 	{
-		// raytrace every 3 degrees makes sure we cover all tiles in a circle.
-		for (int te = 0; te <= 360; te += 3)
+		Tile *origin = _save->getTile(Position(centerX, centerY, centerZ));
+		Tile *dest = origin;
+		double l = 0;
+		int tileX, tileY, tileZ;
+		power_ = power;
+		while (power_ > 0 && l <= maxRadius)
 		{
-			double cos_te = cos(te * M_PI / 180.0);
-			double sin_te = sin(te * M_PI / 180.0);
-			double sin_fi = sin(fi * M_PI / 180.0);
-			double cos_fi = cos(fi * M_PI / 180.0);
-
-			Tile *origin = _save->getTile(Position(centerX, centerY, centerZ));
-			Tile *dest = origin;
-			double l = 0;
-			int tileX, tileY, tileZ;
-			power_ = power;
-			while (power_ > 0 && l <= maxRadius)
+			if (power_ > 0)
 			{
-				if (power_ > 0)
+				if (type == DT_HE)
+				{
+					// explosives do 1/2 damage to terrain and 1/2 up to 3/2 random damage to units (the halving is handled elsewhere)
+					dest->setExplosive(power_, 0);
+				}
+
+				int index = _save->getTileIndex(dest->getPosition());
+				if (_explosionVisited[index] != _explosionEpoch) // check if we had this tile already
 				{
-					if (type == DT_HE)
+					_explosionVisited[index] = _explosionEpoch;
+					tilesAffected.push_back(index);
+					int min = power_ * (100 - dmgRng) / 100;
+					int max = power_ * (100 + dmgRng) / 100;
+					BattleUnit *bu = dest->getUnit();
+					int wounds = 0;
+					if (bu && unit)
 					{
-						// explosives do 1/2 damage to terrain and 1/2 up to 3/2 random damage to units (the halving is handled elsewhere)
-						dest->setExplosive(power_, 0);
+						wounds = bu->getFatalWounds();
 					}
-
-					ret = tilesAffected.insert(dest); // check if we had this tile already
-					if (ret.second)
+					switch (type)
 					{
-						int min = power_ * (100 - dmgRng) / 100;
-						int max = power_ * (100 + dmgRng) / 100;
-						BattleUnit *bu = dest->getUnit();
-						int wounds = 0;
-						if (bu && unit)
+					case DT_STUN:
+						// power 0 - 200%
+						if (bu)
+						{
+							if (distance(dest->getPosition(), Position(centerX, centerY, centerZ)) < 2)
+							{
+								bu->damage(Position(0, 0, 0), RNG::generate(min, max), type);
+							}
+							else
+							{
+								bu->damage(Position(centerX, centerY, centerZ) - dest->getPosition(), RNG::generate(min, max), type);
+							}
+						}
+						for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); ++it)
 						{
-							wounds = bu->getFatalWounds();
+							if ((*it)->getUnit())
+							{
+								(*it)->getUnit()->damage(Position(0, 0, 0), RNG::generate(min, max), type);
+							}
 						}
-						switch (type)
+						break;
+					case DT_HE:
 						{
-						case DT_STUN:
-							// power 0 - 200%
+							// power 50 - 150%
 							if (bu)
 							{
 								if (distance(dest->getPosition(), Position(centerX, centerY, centerZ)) < 2)
 								{
-									bu->damage(Position(0, 0, 0), RNG::generate(min, max), type);
+									// ground zero effect is in effect
+									bu->damage(Position(0, 0, 0), (int)(RNG::generate(min, max)), type);
 								}
 								else
 								{
-									bu->damage(Position(centerX, centerY, centerZ) - dest->getPosition(), RNG::generate(min, max), type);
+									// directional damage relative to explosion position.
+									// units above the explosion will be hit in the legs, units lateral to or below will be hit in the torso
+									bu->damage(Position(centerX, centerY, centerZ + 5) - dest->getPosition(), (int)(RNG::generate(min, max)), type);
 								}
 							}
-							for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); ++it)
+							bool done = false;
+							while (!done)
 							{
-								if ((*it)->getUnit())
+								done = dest->getInventory()->empty();
+								for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); )
 								{
-									(*it)->getUnit()->damage(Position(0, 0, 0), RNG::generate(min, max), type);
-								}
-							}
-							break;
-						case DT_HE:
-							{
-								// power 50 - 150%
-								if (bu)
-								{
-									if (distance(dest->getPosition(), Position(centerX, centerY, centerZ)) < 2)
+									if (power_ > (*it)->getRules()->getArmor())
 									{
-										// ground zero effect is in effect
-										bu->damage(Position(0, 0, 0), (int)(RNG::generate(min, max)), type);
+										if ((*it)->getUnit() && (*it)->getUnit()->getStatus() == STATUS_UNCONSCIOUS)
+											(*it)->getUnit()->instaKill();
+										_save->removeItem((*it));
+										break;
 									}
 									else
 									{
-										// directional damage relative to explosion position.
-										// units above the explosion will be hit in the legs, units lateral to or below will be hit in the torso
-										bu->damage(Position(centerX, centerY, centerZ + 5) - dest->getPosition(), (int)(RNG::generate(min, max)), type);
-									}
-								}
-								bool done = false;
-								while (!done)
-								{
-									done = dest->getInventory()->empty();
-									for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); )
-									{
-										if (power_ > (*it)->getRules()->getArmor())
-										{
-											if ((*it)->getUnit() && (*it)->getUnit()->getStatus() == STATUS_UNCONSCIOUS)
-												(*it)->getUnit()->instaKill();
-											_save->removeItem((*it));
-											break;
-										}
-										else
-										{
-											++it;
-											done = it == dest->getInventory()->end();
-										}
+										++it;
+										done = it == dest->getInventory()->end();
 									}
 								}
 							}
-							break;
+						}
+						break;
 
-						case DT_SMOKE:
-							// smoke from explosions always stay 6 to 14 turns - power of a smoke grenade is 60
-							if (dest->getSmoke() < 10 && dest->getTerrainLevel() > -24)
+					case DT_SMOKE:
+						// smoke from explosions always stay 6 to 14 turns - power of a smoke grenade is 60
+						if (dest->getSmoke() < 10 && dest->getTerrainLevel() > -24)
+						{
+							dest->setFire(0);
+							dest->setSmoke(RNG::generate(7, 15));
+						}
+						break;
+
+					case DT_IN:
+						if (!dest->isVoid())
+						{
+							if (dest->getFire() == 0 && (dest->getMapData(O_FLOOR) || dest->getMapData(O_OBJECT)))
 							{
-								dest->setFire(0);
-								dest->setSmoke(RNG::generate(7, 15));
+								dest->setFire(dest->getFuel() + 1);
+								dest->setSmoke(std::max(1, std::min(15 - (dest->getFlammability() / 10), 12)));
 							}
-							break;
-
-						case DT_IN:
-							if (!dest->isVoid())
+							if (bu)
 							{
-								if (dest->getFire() == 0 && (dest->getMapData(O_FLOOR) || dest->getMapData(O_OBJECT)))
-								{
-									dest->setFire(dest->getFuel() + 1);
-									dest->setSmoke(std::max(1, std::min(15 - (dest->getFlammability() / 10), 12)));
-								}
-								if (bu)
+								float resistance = bu->getArmor()->getDamageModifier(DT_IN);
+								if (resistance > 0.0)
 								{
-									float resistance = bu->getArmor()->getDamageModifier(DT_IN);
-									if (resistance > 0.0)
+									bu->damage(Position(0, 0, 12-dest->getTerrainLevel()), RNG::generate(Mod::FIRE_DAMAGE_RANGE[0], Mod::FIRE_DAMAGE_RANGE[1]), DT_IN, true);
+									int burnTime = RNG::generate(0, int(5.0f * resistance));
+									if (bu->getFire() < burnTime)
 									{
-										bu->damage(Position(0, 0, 12-dest->getTerrainLevel()), RNG::generate(Mod::FIRE_DAMAGE_RANGE[0], Mod::FIRE_DAMAGE_RANGE[1]), DT_IN, true);
-										int burnTime = RNG::generate(0, int(5.0f * resistance));
-										if (bu->getFire() < burnTime)
-										{
-											bu->setFire(burnTime); // catch fire and burn
-										}
+										bu->setFire(burnTime); // catch fire and burn
 									}
 								}
 							}
-							break;
-						default:
-							break;
 						}
+						break;
+					default:
+						break;
+					}
 
-						if (unit && bu && bu->getFaction() != unit->getFaction())
+					if (unit && bu && bu->getFaction() != unit->getFaction())
+					{
+						unit->addFiringExp();
+						// if it's going to bleed to death and it's not a player, give credit for the kill.
+						if (wounds < bu->getFatalWounds() && bu->getFaction() != FACTION_PLAYER)
 						{
-							unit->addFiringExp();
-							// if it's going to bleed to death and it's not a player, give credit for the kill.
-							if (wounds < bu->getFatalWounds() && bu->getFaction() != FACTION_PLAYER)
-							{
-								bu->killedBy(unit->getFaction());
-							}
+							bu->killedBy(unit->getFaction());
 						}
-
 					}
+
 				}
+			}
 
-				l += 1.0;
+			l += 1.0;
 
-				tileX = int(floor(centerX + l * sin_te * cos_fi));
-				tileY = int(floor(centerY + l * cos_te * cos_fi));
-				tileZ = int(floor(centerZ + l * sin_fi));
+			tileX = int(floor(centerX + l * ray->sin_te * ray->cos_fi));
+			tileY = int(floor(centerY + l * ray->cos_te * ray->cos_fi));
+			tileZ = int(floor(centerZ + l * ray->sin_fi));
 
-				origin = dest;
-				dest = _save->getTile(Position(tileX, tileY, tileZ));
+			origin = dest;
+			dest = _save->getTile(Position(tileX, tileY, tileZ));
 
-				if (!dest) break; // out of map!
+			if (!dest) break; // out of map!
 
-				// blockage by terrain is deducted from the explosion power
-				power_ -= 10; // explosive damage decreases by 10 per tile
-				if (origin->getPosition().z != tileZ)
-					power_ -= vertdec; //3d explosion factor
+			// blockage by terrain is deducted from the explosion power
+			power_ -= 10; // explosive damage decreases by 10 per tile
+			if (origin->getPosition().z != tileZ)
+				power_ -= vertdec; //3d explosion factor
 
-				if (type == DT_IN)
-				{
-					int dir;
-					Pathfinding::vectorToDirection(origin->getPosition() - dest->getPosition(), dir);
-					if (dir != -1 && dir %2) power_ -= 5; // diagonal movement costs an extra 50% for fire.
-				}
-				if (l>0.5) power_-= horizontalBlockage(origin, dest, type, l<1.5) * 2;
-				if (l>0.5) power_-= verticalBlockage(origin, dest, type, l<1.5) * 2;
+			if (type == DT_IN)
+			{
+				int dir;
+				Pathfinding::vectorToDirection(origin->getPosition() - dest->getPosition(), dir);
+				if (dir != -1 && dir %2) power_ -= 5; // diagonal movement costs an extra 50% for fire.
 			}
+			power_ -= explosionBlockage(origin, dest, type, l<1.5);
 		}
 	}
 	// now detonate the tiles affected with HE
 
 	if (type == DT_HE)
 	{
-		for (std::set<Tile*>::iterator i = tilesAffected.begin(); i != tilesAffected.end(); ++i)
+		// in map order, the tiles are stored in one block so that's the order they always went off in
+		std::sort(tilesAffected.begin(), tilesAffected.end());
+		for (std::vector<int>::iterator i = tilesAffected.begin(); i != tilesAffected.end(); ++i)
 		{
-			if (detonate(*i))
+			Tile *tile = _save->getTiles()[*i];
+			if (detonate(tile))
 			{
 				_save->addDestroyedObjective();
 			}
-			applyGravity(*i);
-			Tile *j = _save->getTile((*i)->getPosition() + Position(0,0,1));
+			applyGravity(tile);
+			Tile *j = _save->getTile(tile->getPosition() + Position(0,0,1));
 			if (j)
 				applyGravity(j);
 		}
@@ -1364,6 +1637,53 @@ void TileEngine::explode(const Position &center, int power, ItemDamageType type,
 	calculateFOV(center / Position(16,16,24));
 }
 
+/**
+ * Starts tracking the tiles hit by a new explosion. Tiles and
+ * blockages are marked with the number of the explosion, so
+ * nothing needs clearing between explosions.
+ */
+void TileEngine::newExplosion()
+{
+	int size = _save->getMapSizeXYZ();
+	++_explosionEpoch;
+	if (_explosionEpoch == 0 || (int)_explosionVisited.size() != size)
+	{
+		_explosionVisited.assign(size, 0);
+		_explosionBlockStamp.assign((size + 1) * 27, 0);
+		_explosionBlock.assign((size + 1) * 27, 0);
+		_explosionEpoch = 1;
+	}
+}
+
+/**
+ * Gets the power an explosion loses to terrain going from one tile
+ * to the next. The terrain doesn't change until the explosion is
+ * over, and most rays share their first few steps, so each step
+ * is only worked out once per explosion.
+ * @param origin Tile the explosion comes from.
+ * @param dest Tile the explosion goes to, next to the origin.
+ * @param type Damage type of the explosion.
+ * @param firstStep If this is the step out of the center tile.
+ * @return Power lost.
+ */
+int TileEngine::explosionBlockage(Tile *origin, Tile *dest, ItemDamageType type, bool firstStep)
+{
+	Position step = dest->getPosition() - origin->getPosition();
+	if (step.x < -1 || step.x > 1 || step.y < -1 || step.y > 1 || step.z < -1 || step.z > 1)
+	{
+		return horizontalBlockage(origin, dest, type, firstStep) * 2 + verticalBlockage(origin, dest, type, firstStep) * 2;
+	}
+	// the first step always leaves the center, so it gets its own slots after the map
+	int slot = firstStep ? _save->getMapSizeXYZ() : _save->getTileIndex(origin->getPosition());
+	slot = slot * 27 + (step.z + 1) * 9 + (step.y + 1) * 3 + step.x + 1;
+	if (_explosionBlockStamp[slot] != _explosionEpoch)
+	{
+		_explosionBlockStamp[slot] = _explosionEpoch;
+		_explosionBlock[slot] = horizontalBlockage(origin, dest, type, firstStep) * 2 + verticalBlockage(origin, dest, type, firstStep) * 2;
+	}
+	return _explosionBlock[slot];
+}
+
 /**
  * Applies the explosive power to the tile parts. This is where the actual destruction takes place.
  * Must affect 9 objects (6 box sides and the object inside plus 2 outer walls).
@@ -2327,6 +2647,7 @@ int TileEngine::castedShade(const Position& voxel)
 	Position tmpVoxel = voxel;
 	int z;
 
+	_voxels->update();
 	for (z = zstart; z>0; z--)
 	{
 		tmpVoxel.z = z;
@@ -2346,6 +2667,7 @@ bool TileEngine::isVoxelVisible(const Position& voxel)
 	int zstart = voxel.z+3; // slight Z adjust
 	if ((zstart/24)!=(voxel.z/24))
 		return true; // visible!
+	_voxels->update();
 	Position tmpVoxel = voxel;
 	int zend = (zstart/24)*24 +24;
 	for (int z = zstart; z<zend; z++)
@@ -2372,9 +2694,14 @@ bool TileEngine::isVoxelVisible(const Position& voxel)
  */
 int TileEngine::voxelCheck(const Position& voxel, BattleUnit *excludeUnit, bool excludeAllUnits, bool onlyVisible, BattleUnit *excludeAllBut)
 {
-	Tile *tile = _save->getTile(voxel / Position(16, 16, 24));
 	// check if we are not out of the map
-	if (tile == 0 || voxel.x < 0 || voxel.y < 0 || voxel.z < 0)
+	if (voxel.x < 0 || voxel.y < 0 || voxel.z < 0)
+	{
+		return V_OUTOFBOUNDS;
+	}
+	Position tilePos = voxel / Position(16, 16, 24);
+	Tile *tile = _save->getTile(tilePos);
+	if (tile == 0)
 	{
 		return V_OUTOFBOUNDS;
 	}
@@ -2391,19 +2718,24 @@ int TileEngine::voxelCheck(const Position& voxel, BattleUnit *excludeUnit, bool
 	}
 
 	// first we check terrain voxel data, not to allow 2x2 units stick through walls
-	for (int i=0; i< 4; ++i)
+	// the packed grid tells if there's anything there, the parts tell what it is
+	int index = _save->getTileIndex(tilePos);
+	if (_voxels->hasTerrain(index) && _voxels->isTerrain(index, voxel))
 	{
-		MapData *mp = tile->getMapData(i);
-		if (tile->isUfoDoorOpen(i))
-			continue;
-		if (mp != 0)
+		for (int i=0; i< 4; ++i)
 		{
-			int x = 15 - voxel.x%16;
-			int y = voxel.y%16;
-			int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
-			if (_voxelData->at(idx) & (1 << x))
+			MapData *mp = tile->getMapData(i);
+			if (tile->isUfoDoorOpen(i))
+				continue;
+			if (mp != 0)
 			{
-				return i;
+				int x = 15 - voxel.x%16;
+				int y = voxel.y%16;
+				int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
+				if (_voxelData->at(idx) & (1 << x))
+				{
+					return i;
+				}
 			}
 		}
 	}
@@ -2778,13 +3110,15 @@ bool TileEngine::validateThrow(BattleAction &action, Position originVoxel, Posit
  */
 void TileEngine::recalculateFOV()
 {
+	std::vector<BattleUnit*> units;
 	for (std::vector<BattleUnit*>::iterator bu = _save->getUnits()->begin(); bu != _save->getUnits()->end(); ++bu)
 	{
 		if ((*bu)->getTile() != 0)
 		{
-			calculateFOV(*bu);
+			units.push_back(*bu);
 		}
 	}
+	calculateFOV(units);
 }
 
 /**
@@ -2915,6 +3249,7 @@ void TileEngine::setDangerZone(Position pos, int radius, BattleUnit *unit)
 	{
 		return;
 	}
+	_voxels->update();
 	// set the epicenter as dangerous
 	tile->setDangerous();
 	Position originVoxel = (pos * Position(16,16,24)) + Position(8,8,12 + -tile->getTerrainLevel());
@@ -20,6 +20,7 @@
 #define OPENXCOM_TILEENGINE_H
 
 #include <vector>
+#include <map>
 #include "Position.h"
 #include "../Mod/RuleItem.h"
 #include <SDL.h>
@@ -28,6 +29,8 @@ namespace OpenXcom
 {
 
 class SavedBattleGame;
+class LightField;
+class VoxelGrid;
 class BattleUnit;
 class BattleItem;
 class Tile;
@@ -39,6 +42,26 @@ struct BattleAction;
 class TileEngine
 {
 private:
+	/**
+	 * The tiles a player unit discovered on its last field of view
+	 * calculation, so the rays that can't have changed don't need
+	 * to be traced again.
+	 */
+	struct UnitView
+	{
+		Position origin;
+		int direction, size;
+		unsigned int terrainStamp;
+		std::vector<int> tiles, rayEnds;
+		UnitView() : direction(-1), size(0), terrainStamp(0) {}
+	};
+	/// Direction of one of the rays traced by an explosion.
+	struct ExplosionRay
+	{
+		double sin_te, cos_te, sin_fi, cos_fi;
+	};
+	struct FovJob;
+	struct SpotJob;
 	static const int MAX_VIEW_DISTANCE = 20;
 	static const int MAX_VIEW_DISTANCE_SQR = MAX_VIEW_DISTANCE * MAX_VIEW_DISTANCE;
 	static const int MAX_VOXEL_VIEW_DISTANCE = MAX_VIEW_DISTANCE * 16;
@@ -46,14 +69,44 @@ private:
 	SavedBattleGame *_save;
 	std::vector<Uint16> *_voxelData;
 	static const int heightFromCenter[11];
-	void addLight(const Position &center, int power, int layer);
+	LightField *_terrainLight, *_unitLight;
+	VoxelGrid *_voxels;
+	std::map<int, UnitView> _views;
+	/// Marks a tile seen by a player unit as discovered.
+	void discoverTile(Tile *tile);
 	int blockage(Tile *tile, const int part, ItemDamageType type, int direction = -1, bool checkingFromOrigin = false);
 	bool _personalLighting;
+	/// Works out what a unit sees.
+	void computeFOV(BattleUnit *unit, UnitView *view, std::vector<BattleUnit*> &seen);
+	/// Applies what a unit sees.
+	bool commitFOV(BattleUnit *unit, UnitView *view, const std::vector<BattleUnit*> &seen);
+	/// Calculates the field of view of several units.
+	void calculateFOV(const std::vector<BattleUnit*> &units);
+	/// Works out what one unit of a job sees.
+	static void fovTask(void *data, int task);
+	/// Checks if a unit can spot another one.
+	bool canSpot(BattleUnit *spotter, BattleUnit *unit);
+	/// Checks if one unit of a job can spot its target.
+	static void spotTask(void *data, int task);
+	std::vector<ExplosionRay> _explosionRays;
+	std::vector<unsigned int> _explosionVisited, _explosionBlockStamp;
+	std::vector<int> _explosionBlock;
+	unsigned int _explosionEpoch;
+	/// Starts tracking the tiles hit by a new explosion.
+	void newExplosion();
+	/// Gets the power an explosion loses going from one tile to the next.
+	int explosionBlockage(Tile *origin, Tile *dest, ItemDamageType type, bool firstStep);
 public:
 	/// Creates a new TileEngine class.
 	TileEngine(SavedBattleGame *save, std::vector<Uint16> *voxelData);
 	/// Cleans up the TileEngine.
 	~TileEngine();
+	/// Brings the voxel grid up to date before line checks on the main thread.
+	void updateVoxels();
+	/// Runs read-only line of sight checks on the worker threads.
+	void runChecks(void (*handler)(void *data, int task), void *data, int tasks);
+	/// Gets the distance to the closest terrain change around a position.
+	int terrainChangeDistanceSq(const Position &center, int range, unsigned int terrainStamp) const;
 	/// Calculates sun shading of the whole map.
 	void calculateSunShading();
 	/// Calculates sun shading of a single tile.
@@ -68,6 +121,8 @@ public:
 	void calculateTerrainLighting();
 	/// Recalculates lighting of the battlescape for units.
 	void calculateUnitLighting();
+	/// Resets the lighting after the map was recreated.
+	void resetLighting();
 	/// Handles bullet/weapon hits.
 	BattleUnit *hit(const Position &center, int power, ItemDamageType type, BattleUnit *unit);
 	/// Handles explosions.
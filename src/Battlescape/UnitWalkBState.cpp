@@ -491,6 +491,7 @@ void UnitWalkBState::postPathProcedures()
 		if (_unit->getCharging() != 0)
 		{
 			dir = _parent->getTileEngine()->getDirectionTo(_unit->getPosition(), _unit->getCharging()->getPosition());
+			_parent->getTileEngine()->updateVoxels();
 			if (_parent->getTileEngine()->validMeleeRange(_unit, _action.actor->getCharging(), dir))
 			{
 				BattleAction action;
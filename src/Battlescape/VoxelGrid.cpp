@@ -0,0 +1,105 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "VoxelGrid.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Mod/MapData.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a voxel grid for a battle. The tiles get
+ * packed the first time the grid is updated.
+ * @param save Pointer to the battle.
+ * @param voxelData LOFTEMPS voxel data.
+ */
+VoxelGrid::VoxelGrid(SavedBattleGame *save, std::vector<Uint16> *voxelData) : _save(save), _voxelData(voxelData), _width(0), _length(0), _height(0), _terrainStamp(0)
+{
+}
+
+/**
+ * Cleans up the voxel grid.
+ */
+VoxelGrid::~VoxelGrid()
+{
+}
+
+/**
+ * Packs the voxels of all the closed parts of a tile.
+ * Open ufo doors don't take up any voxels.
+ * @param index Tile index.
+ * @param tile Pointer to the tile.
+ */
+void VoxelGrid::packTile(int index, Tile *tile)
+{
+	Uint16 *rows = &_rows[index * LAYERS * ROWS];
+	bool solid = false;
+	for (int i = 0; i < LAYERS * ROWS; ++i)
+	{
+		rows[i] = 0;
+	}
+	for (int part = 0; part < 4; ++part)
+	{
+		MapData *mp = tile->getMapData(part);
+		if (mp == 0 || tile->isUfoDoorOpen(part))
+		{
+			continue;
+		}
+		for (int layer = 0; layer < LAYERS; ++layer)
+		{
+			int loft = mp->getLoftID(layer) * ROWS;
+			for (int y = 0; y < ROWS; ++y)
+			{
+				Uint16 mask = _voxelData->at(loft + y);
+				rows[layer * ROWS + y] |= mask;
+				solid = solid || mask != 0;
+			}
+		}
+	}
+	_solid[index] = solid;
+}
+
+/**
+ * Repacks the tiles that changed since the grid was last updated,
+ * or the whole map if it was recreated with a different size.
+ */
+void VoxelGrid::refresh()
+{
+	unsigned int stamp = _terrainStamp;
+	if (_width != _save->getMapSizeX() || _length != _save->getMapSizeY() || _height != _save->getMapSizeZ())
+	{
+		_width = _save->getMapSizeX();
+		_length = _save->getMapSizeY();
+		_height = _save->getMapSizeZ();
+		_rows.assign(_width * _length * _height * LAYERS * ROWS, 0);
+		_solid.assign(_width * _length * _height, 0);
+		stamp = 0;
+	}
+	_terrainStamp = Tile::getTerrainChanges();
+	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
+	{
+		Tile *tile = _save->getTiles()[i];
+		if (stamp == 0 || tile->getTerrainStamp() > stamp)
+		{
+			packTile(i, tile);
+		}
+	}
+}
+
+}
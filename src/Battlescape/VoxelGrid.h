@@ -0,0 +1,95 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_VOXELGRID_H
+#define OPENXCOM_VOXELGRID_H
+
+#include <vector>
+#include <SDL_types.h>
+#include "Position.h"
+#include "../Savegame/Tile.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+
+/**
+ * Packed terrain voxel occupancy of the battlescape.
+ * Each tile gets the union of the LOFTEMPS of its closed parts,
+ * one 16-bit mask per voxel row, so checking if a voxel is solid
+ * doesn't go through the tile's MapData. Tiles are refreshed when
+ * their terrain changes.
+ */
+class VoxelGrid
+{
+private:
+	static const int LAYERS = 12;
+	static const int ROWS = 16;
+	SavedBattleGame *_save;
+	std::vector<Uint16> *_voxelData;
+	std::vector<Uint16> _rows;
+	std::vector<Uint8> _solid;
+	int _width, _length, _height;
+	unsigned int _terrainStamp;
+	/// Packs the voxels of a tile.
+	void packTile(int index, Tile *tile);
+	/// Repacks the tiles whose terrain changed.
+	void refresh();
+public:
+	/// Creates a voxel grid for a battle.
+	VoxelGrid(SavedBattleGame *save, std::vector<Uint16> *voxelData);
+	/// Cleans up the voxel grid.
+	~VoxelGrid();
+	/**
+	 * Brings the grid up to date with the terrain. Only called on
+	 * the main thread, before voxel checks are made there and before
+	 * work is handed to other threads; the line checks themselves
+	 * never call it, so the threads only read the grid.
+	 */
+	void update()
+	{
+		if (_terrainStamp != Tile::getTerrainChanges())
+		{
+			refresh();
+		}
+	}
+	/**
+	 * Checks if a tile has any solid terrain voxels.
+	 * @param index Tile index.
+	 * @return True if there's terrain.
+	 */
+	bool hasTerrain(int index) const
+	{
+		return _solid[index] != 0;
+	}
+	/**
+	 * Checks if a voxel is taken up by terrain.
+	 * @param index Index of the tile holding the voxel.
+	 * @param voxel Voxel position, inside the map.
+	 * @return True if the voxel is solid.
+	 */
+	bool isTerrain(int index, const Position &voxel) const
+	{
+		return (_rows[(index * LAYERS + (voxel.z % 24) / 2) * ROWS + voxel.y % 16] & (1 << (15 - voxel.x % 16))) != 0;
+	}
+};
+
+}
+
+#endif
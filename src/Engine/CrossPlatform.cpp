@@ -56,6 +56,8 @@
 #include <sys/param.h>
 #include <sys/types.h>
 #include <pwd.h>
+#include <time.h>
+#include <sys/time.h>
 #endif
 #include <SDL.h>
 #include <SDL_syswm.h>
@@ -836,5 +838,46 @@ void setWindowIcon(int winResource, const std::string &unixPath)
 #endif
 }
 
+/**
+ * Gets the number of logical CPU cores available to the
+ * game, used for sizing worker threads.
+ * @return Number of cores, at least 1.
+ */
+int getNumberOfCores()
+{
+	int cores = 1;
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	cores = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return (cores > 0) ? cores : 1;
+}
+
+/**
+ * Gets a timestamp with much finer resolution than
+ * SDL_GetTicks(), for measuring short stretches of code.
+ * @return Time in seconds, from an arbitrary starting point.
+ */
+double getPerformanceTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER count, frequency;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return (double)count.QuadPart / (double)frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1000000000.0;
+#else
+	struct timeval now;
+	gettimeofday(&now, 0);
+	return now.tv_sec + now.tv_usec / 1000000.0;
+#endif
+}
+
 }
 }
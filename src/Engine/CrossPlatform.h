@@ -85,6 +85,10 @@ namespace CrossPlatform
 	std::string getDosPath();
 	/// Sets the window icon.
 	void setWindowIcon(int winResource, const std::string &unixPath);
+	/// Gets the number of logical CPU cores.
+	int getNumberOfCores();
+	/// Gets a high resolution timestamp.
+	double getPerformanceTime();
 }
 
 }
@@ -181,10 +181,7 @@ Surface *Font::getChar(wchar_t c)
 	{
 		return 0;
 	}
-	_surface->getCrop()->x = _chars[c].x;
-	_surface->getCrop()->y = _chars[c].y;
-	_surface->getCrop()->w = _chars[c].w;
-	_surface->getCrop()->h = _chars[c].h;
+	_surface->setCrop(_chars[c]);
 	return _surface;
 }
 
@@ -267,11 +264,7 @@ void Font::fix(const std::string &file, int width)
 	int y = 0;
 	for (size_t i = 0; i < _index.length(); ++i)
 	{
-		SDL_Rect rect = _chars[_index[i]];
-		_surface->getCrop()->x = rect.x;
-		_surface->getCrop()->y = rect.y;
-		_surface->getCrop()->w = rect.w;
-		_surface->getCrop()->h = rect.h;
+		_surface->setCrop(_chars[_index[i]]);
 		_surface->setX(x);
 		_surface->setY(y);
 		_surface->blit(s);
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace OpenXcom
+{
+
+/// Length of a logic tick, in milliseconds.
+const int FrameScheduler::THINK_INTERVAL = 5;
+/// Most logic ticks run back-to-back before the rest is dropped.
+const int FrameScheduler::MAX_THINK_TICKS = 4;
+/// How often to check for events during long sleeps, in milliseconds.
+const int FrameScheduler::EVENT_POLL_INTERVAL = 10;
+
+/**
+ * Initializes the scheduler with a logic tick due right away.
+ */
+FrameScheduler::FrameScheduler() : _lastTick(SDL_GetTicks()), _thinkTime(THINK_INTERVAL), _thinkTicks(0), _nextFrame(0.0), _frameLimit(false)
+{
+	_nextFrame = _lastTick;
+}
+
+/**
+ *
+ */
+FrameScheduler::~FrameScheduler()
+{
+}
+
+/**
+ * Adds the time passed since the last call to the logic clock,
+ * turning it into logic ticks. If the game was stalled for a
+ * long time (loading, dragging the window, etc.) the backlog
+ * is dropped, since the timers catch up on their own.
+ */
+void FrameScheduler::advance()
+{
+	Uint32 now = SDL_GetTicks();
+	_thinkTime += now - _lastTick;
+	_lastTick = now;
+	_thinkTicks = _thinkTime / THINK_INTERVAL;
+	_thinkTime %= THINK_INTERVAL;
+	if (_thinkTicks > MAX_THINK_TICKS)
+	{
+		_thinkTicks = MAX_THINK_TICKS;
+	}
+}
+
+/**
+ * Consumes one of the logic ticks made available by advance().
+ * @return True if the game logic should run now.
+ */
+bool FrameScheduler::think()
+{
+	if (_thinkTicks > 0)
+	{
+		_thinkTicks--;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Checks if it's time to draw another frame. The deadlines
+ * are kept in fractional milliseconds so frame rates that
+ * don't divide a second evenly still average out right.
+ * @param interval Time between frames in milliseconds, 0 for no limit.
+ * @return True if a frame should be drawn now.
+ */
+bool FrameScheduler::frame(double interval)
+{
+	double now = SDL_GetTicks();
+	_frameLimit = (interval > 0.0);
+	if (!_frameLimit)
+	{
+		_nextFrame = now;
+		return true;
+	}
+	if (now < _nextFrame)
+	{
+		return false;
+	}
+	_nextFrame += interval;
+	if (_nextFrame < now)
+	{
+		// we fell behind, don't try to draw the missed frames
+		_nextFrame = now + interval;
+	}
+	return true;
+}
+
+/**
+ * Sleeps until the next logic tick or frame is due, whichever
+ * comes first. Long sleeps are cut short as soon as an SDL
+ * event is waiting, so input is never held up. Without a frame
+ * limit (or with vsync) there's no frame deadline to sleep
+ * until, so it just gives the CPU a break of a millisecond.
+ * @param minDelay Sleep at least this long (in milliseconds) unless an event arrives, for inactive windows.
+ */
+void FrameScheduler::wait(Uint32 minDelay)
+{
+	if (_thinkTicks > 0)
+	{
+		return;
+	}
+	Uint32 now = SDL_GetTicks();
+	double nextThink = _lastTick + THINK_INTERVAL - _thinkTime;
+	double next = std::min(nextThink, _nextFrame);
+	Uint32 delay = 0;
+	if (!_frameLimit)
+	{
+		delay = 1;
+	}
+	else if (next > now)
+	{
+		delay = (Uint32)ceil(next - now);
+	}
+	delay = std::max(delay, minDelay);
+
+	Uint32 end = now + delay;
+	while (now < end)
+	{
+		SDL_Event event;
+		SDL_PumpEvents();
+		if (SDL_PeepEvents(&event, 1, SDL_PEEKEVENT, SDL_ALLEVENTS) > 0)
+		{
+			break;
+		}
+		SDL_Delay(std::min(end - now, (Uint32)EVENT_POLL_INTERVAL));
+		now = SDL_GetTicks();
+	}
+}
+
+}
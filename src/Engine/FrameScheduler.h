@@ -0,0 +1,62 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_FRAMESCHEDULER_H
+#define OPENXCOM_FRAMESCHEDULER_H
+
+#include <SDL.h>
+
+namespace OpenXcom
+{
+
+/**
+ * Paces the main loop of the game.
+ * Game logic is run in ticks of a fixed length, independent
+ * of the frame rate, and frames are drawn at their own fixed
+ * interval. In between, the scheduler sleeps until the next
+ * tick or frame is due, or until an SDL event arrives,
+ * instead of polling the CPU every millisecond.
+ */
+class FrameScheduler
+{
+private:
+	static const int THINK_INTERVAL;
+	static const int MAX_THINK_TICKS;
+	static const int EVENT_POLL_INTERVAL;
+	Uint32 _lastTick;
+	int _thinkTime, _thinkTicks;
+	double _nextFrame;
+	bool _frameLimit;
+public:
+	/// Creates a new frame scheduler.
+	FrameScheduler();
+	/// Cleans up the frame scheduler.
+	~FrameScheduler();
+	/// Adds the time passed since the last call to the logic clock.
+	void advance();
+	/// Checks if a logic tick is due, and consumes it.
+	bool think();
+	/// Checks if a frame is due, and schedules the next one.
+	bool frame(double interval);
+	/// Sleeps until the next tick or frame, or an event.
+	void wait(Uint32 minDelay = 0);
+};
+
+}
+
+#endif
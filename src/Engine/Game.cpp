@@ -36,6 +36,8 @@
 #include "Options.h"
 #include "CrossPlatform.h"
 #include "FileMap.h"
+#include "FrameScheduler.h"
+#include "ThreadPool.h"
 #include "../Menu/TestState.h"
 
 namespace OpenXcom
@@ -48,7 +50,7 @@ const double Game::VOLUME_GRADIENT = 10.0;
  * creates the display screen and sets up the cursor.
  * @param title Title of the game window.
  */
-Game::Game(const std::string &title) : _screen(0), _cursor(0), _lang(0), _save(0), _mod(0), _quit(false), _init(false), _mouseActive(true), _timeUntilNextFrame(0)
+Game::Game(const std::string &title) : _screen(0), _cursor(0), _lang(0), _save(0), _mod(0), _quit(false), _init(false), _mouseActive(true), _scheduler(0)
 {
 	Options::reload = false;
 	Options::mute = false;
@@ -100,7 +102,10 @@ Game::Game(const std::string &title) : _screen(0), _cursor(0), _lang(0), _save(0
 	// Create blank language
 	_lang = new Language();
 
-	_timeOfLastFrame = 0;
+	_scheduler = new FrameScheduler();
+
+	// Create worker threads
+	ThreadPool::updateShared();
 }
 
 /**
@@ -124,6 +129,8 @@ Game::~Game()
 	delete _mod;
 	delete _screen;
 	delete _fpsCounter;
+	delete _scheduler;
+	ThreadPool::destroyShared();
 
 	Mix_CloseAudio();
 
@@ -155,6 +162,7 @@ void Game::run()
 		if (!_init)
 		{
 			_init = true;
+			_screen->setComposited(false);
 			_states.back()->init();
 
 			// Unpress buttons
@@ -260,52 +268,79 @@ void Game::run()
 		// Process rendering
 		if (runningState != PAUSED)
 		{
-			// Process logic
-			_states.back()->think();
-			_fpsCounter->think();
-			if (Options::FPS > 0 && !(Options::useOpenGL && Options::vSyncForOpenGL))
+			// Process logic in fixed ticks, stop if the state changes so it gets initialized first
+			_scheduler->advance();
+			while (_init && !_quit && _scheduler->think())
 			{
-				// Update our FPS delay time based on the time of the last draw.
-				int fps = SDL_GetAppState() & SDL_APPINPUTFOCUS ? Options::FPS : Options::FPSInactive;
-
-				_timeUntilNextFrame = (1000.0f / fps) - (SDL_GetTicks() - _timeOfLastFrame);
+				_states.back()->think();
+				_fpsCounter->think();
 			}
-			else
+
+			double frameInterval = 0.0;
+			if (Options::FPS > 0 && !(Options::useOpenGL && Options::vSyncForOpenGL))
 			{
-				_timeUntilNextFrame = 0;
+				int fps = SDL_GetAppState() & SDL_APPINPUTFOCUS ? Options::FPS : Options::FPSInactive;
+				frameInterval = 1000.0 / fps;
 			}
 
-			if (_init && _timeUntilNextFrame <= 0)
+			if (_init && _scheduler->frame(frameInterval))
 			{
-				// make a note of when this frame update occurred.
-				_timeOfLastFrame = SDL_GetTicks();
 				_fpsCounter->addFrame();
-				_screen->clear();
-				std::list<State*>::iterator i = _states.end();
+				std::list<State*>::iterator first = _states.end();
 				do
 				{
-					--i;
+					--first;
 				}
-				while (i != _states.begin() && !(*i)->isScreen());
+				while (first != _states.begin() && !(*first)->isScreen());
 
-				for (; i != _states.end(); ++i)
+				if (!_screen->isComposited())
+				{
+					_screen->clear();
+					for (std::list<State*>::iterator i = first; i != _states.end(); ++i)
+					{
+						(*i)->blit();
+					}
+					_fpsCounter->blit(_screen->getSurface());
+					_cursor->blit(_screen->getSurface());
+					_screen->setComposited(true);
+				}
+				else
 				{
-					(*i)->blit();
+					// only recomposite the area that changed since the last frame
+					SDL_Rect damage = {0, 0, 0, 0};
+					bool damaged = false;
+					for (std::list<State*>::iterator i = first; i != _states.end(); ++i)
+					{
+						damaged = (*i)->getDamage(damage) || damaged;
+					}
+					damaged = _fpsCounter->getDamage(damage) || damaged;
+					damaged = _cursor->getDamage(damage) || damaged;
+					if (damaged)
+					{
+						SDL_Surface *buffer = _screen->getSurface()->getSurface();
+						SDL_SetClipRect(buffer, &damage);
+						SDL_FillRect(buffer, &buffer->clip_rect, 0);
+						for (std::list<State*>::iterator i = first; i != _states.end(); ++i)
+						{
+							(*i)->blit();
+						}
+						_fpsCounter->blit(_screen->getSurface());
+						_cursor->blit(_screen->getSurface());
+						SDL_SetClipRect(buffer, 0);
+					}
 				}
-				_fpsCounter->blit(_screen->getSurface());
-				_cursor->blit(_screen->getSurface());
 				_screen->flip();
 			}
 		}
 
-		// Save on CPU
+		// Save on CPU, sleep until there's something to do
 		switch (runningState)
 		{
 			case RUNNING: 
-				SDL_Delay(1); //Save CPU from going 100%
+				_scheduler->wait();
 				break;
 			case SLOWED: case PAUSED:
-				SDL_Delay(100); break; //More slowing down.
+				_scheduler->wait(100); break; //More slowing down.
 		}
 	}
 
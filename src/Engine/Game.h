@@ -33,6 +33,7 @@ class Language;
 class SavedGame;
 class Mod;
 class FpsCounter;
+class FrameScheduler;
 
 /**
  * The core of the game engine, manages the game's entire contents and structure.
@@ -53,8 +54,7 @@ private:
 	bool _quit, _init;
 	FpsCounter *_fpsCounter;
 	bool _mouseActive;
-	unsigned int _timeOfLastFrame;
-	int _timeUntilNextFrame;
+	FrameScheduler *_scheduler;
 	static const double VOLUME_GRADIENT;
 
 public:
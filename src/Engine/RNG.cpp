@@ -43,6 +43,10 @@ See <http://creativecommons.org/publicdomain/zero/1.0/>. */
 
 uint64_t x = time(0); /* The state must be seeded with a nonzero value. */
 
+/**
+ * Generates the next raw number from the generator.
+ * @return Random 64-bit number.
+ */
 uint64_t next()
 {
 	x ^= x >> 12; // a
@@ -163,5 +167,98 @@ int generateEx(int max)
 	return (int)(num % max);
 }
 
+/**
+ * Mixes the bits of a number so that close numbers
+ * give unrelated results (splitmix64 finalizer).
+ * @param z Number to mix.
+ * @return Mixed number.
+ */
+static uint64_t mix(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * Seeds a stream from a seed and a stream number, so
+ * each number gets its own unrelated stream.
+ * @param seed Seed shared by the streams.
+ * @param stream Number of this stream.
+ */
+RandomState::RandomState(uint64_t seed, uint64_t stream)
+{
+	_x = mix(seed + mix(stream + 0x9e3779b97f4a7c15ULL));
+	if (_x == 0)
+	{
+		_x = 0x9e3779b97f4a7c15ULL; // the state must be nonzero
+	}
+}
+
+/**
+ * Returns the current state of the stream.
+ * @return Current state.
+ */
+uint64_t RandomState::getSeed() const
+{
+	return _x;
+}
+
+/**
+ * Changes the current state of the stream.
+ * @param n New state.
+ */
+void RandomState::setSeed(uint64_t n)
+{
+	_x = n;
+}
+
+/**
+ * Generates the next raw number from the stream,
+ * the same way as the global generator.
+ * @return Random 64-bit number.
+ */
+uint64_t RandomState::next()
+{
+	_x ^= _x >> 12; // a
+	_x ^= _x << 25; // b
+	_x ^= _x >> 27; // c
+	return _x * 2685821657736338717ULL;
+}
+
+/**
+ * Generates a random integer number within a certain range.
+ * @param min Minimum number, inclusive.
+ * @param max Maximum number, inclusive.
+ * @return Generated number.
+ */
+int RandomState::generate(int min, int max)
+{
+	uint64_t num = next();
+	return (int)(num % (max - min + 1) + min);
+}
+
+/**
+ * Generates a random percent chance of an event occurring,
+ * and returns the result
+ * @param value Value percentage (0-100%)
+ * @return True if the chance succeeded.
+ */
+bool RandomState::percent(int value)
+{
+	return (generate(0, 99) < value);
+}
+
+/**
+ * Generates a random positive integer up to a number.
+ * @param max Maximum number, exclusive.
+ * @return Generated number.
+ */
+int RandomState::generateEx(int max)
+{
+	uint64_t num = next();
+	return (int)(num % max);
+}
+
 }
 }
@@ -37,6 +37,8 @@ namespace RNG
 	uint64_t getSeed();
 	/// Sets the seed in use.
 	void setSeed(uint64_t n);
+	/// Generates the next raw number.
+	uint64_t next();
 	/// Generates a random integer number, inclusive.
 	int generate(int min, int max);
 	/// Generates a random floating-point number.
@@ -59,6 +61,41 @@ namespace RNG
 	{
 		std::random_shuffle(list.begin(), list.end(), generateEx);
 	}
+
+	/**
+	 * A stream of random numbers with its own state, separate
+	 * from the one used throughout the game. Streams seeded
+	 * the same give the same numbers no matter what else
+	 * happens, and can be used off the main thread.
+	 */
+	class RandomState
+	{
+	private:
+		uint64_t _x;
+	public:
+		/// Creates a stream from a seed and a stream number.
+		RandomState(uint64_t seed, uint64_t stream);
+		/// Gets the state of the stream.
+		uint64_t getSeed() const;
+		/// Sets the state of the stream.
+		void setSeed(uint64_t n);
+		/// Generates the next raw number.
+		uint64_t next();
+		/// Generates a random integer number, inclusive.
+		int generate(int min, int max);
+		/// Generates a percentage chance.
+		bool percent(int value);
+		/// Generates a random integer number, exclusive.
+		int generateEx(int max);
+		/// Generates a random integer number, exclusive.
+		int operator()(int max) { return generateEx(max); }
+		/// Shuffles a list randomly.
+		template <typename T>
+		void shuffle(T &list)
+		{
+			std::random_shuffle(list.begin(), list.end(), *this);
+		}
+	};
 }
 
 }
@@ -108,8 +108,9 @@ void Screen::makeVideoFlags()
  * Initializes a new display screen for the game to render contents to.
  * The screen is set up based on the current options.
  */
-Screen::Screen() : _baseWidth(ORIGINAL_WIDTH), _baseHeight(ORIGINAL_HEIGHT), _scaleX(1.0), _scaleY(1.0), _flags(0), _numColors(0), _firstColor(0), _pushPalette(false), _surface(0)
+Screen::Screen() : _baseWidth(ORIGINAL_WIDTH), _baseHeight(ORIGINAL_HEIGHT), _scaleX(1.0), _scaleY(1.0), _flags(0), _numColors(0), _firstColor(0), _pushPalette(false), _surface(0), _zoomBuffer(0), _redrawAll(true), _composited(false)
 {
+	resetFlipTimes();
 	resetDisplay();	
 	memset(deferredPalette, 0, 256*sizeof(SDL_Color));
 }
@@ -121,6 +122,10 @@ Screen::Screen() : _baseWidth(ORIGINAL_WIDTH), _baseHeight(ORIGINAL_HEIGHT), _sc
 Screen::~Screen()
 {
 	delete _surface;
+	if (_zoomBuffer)
+	{
+		SDL_FreeSurface(_zoomBuffer);
+	}
 }
 
 /**
@@ -181,20 +186,31 @@ void Screen::handle(Action *action)
  * If the scaling factor is bigger than 1, the entire contents
  * of the buffer are resized by that factor (eg. 2 = doubled)
  * before being put on screen.
+ * When the display allows it, only the rows that changed
+ * since the last frame are pushed.
  */
 void Screen::flip()
 {
+	bool pushPalette = _pushPalette && _numColors && _screen->format->BitsPerPixel == 8;
+	if (canFlipDirty() && !_redrawAll && !pushPalette)
+	{
+		flipDirty();
+		return;
+	}
+
+	double time = CrossPlatform::getPerformanceTime();
 	if (getWidth() != _baseWidth || getHeight() != _baseHeight || isOpenGLEnabled())
 	{
-		Zoom::flipWithZoom(_surface->getSurface(), _screen, _topBlackBand, _bottomBlackBand, _leftBlackBand, _rightBlackBand, &glOutput);
+		Zoom::flipWithZoom(_surface->getSurface(), _screen, _topBlackBand, _bottomBlackBand, _leftBlackBand, _rightBlackBand, &glOutput, _zoomBuffer);
 	}
 	else
 	{
 		SDL_BlitSurface(_surface->getSurface(), 0, _screen, 0);
 	}
+	time = addFlipTime(FLIP_ZOOM, time);
 
 	// perform any requested palette update
-	if (_pushPalette && _numColors && _screen->format->BitsPerPixel == 8)
+	if (pushPalette)
 	{
 		if (_screen->format->BitsPerPixel == 8 && SDL_SetColors(_screen, &(deferredPalette[_firstColor]), _firstColor, _numColors) == 0)
 		{
@@ -203,13 +219,168 @@ void Screen::flip()
 		_numColors = 0;
 		_pushPalette = false;
 	}
-
-
+	time = addFlipTime(FLIP_PALETTE, time);
 	
 	if (SDL_Flip(_screen) == -1)
 	{
 		throw Exception(SDL_GetError());
 	}
+	addFlipTime(FLIP_PRESENT, time);
+
+	if (canFlipDirty())
+	{
+		saveFrame();
+	}
+	_redrawAll = false;
+}
+
+/**
+ * Only software surfaces that aren't page flipped keep
+ * their contents between frames, so they're the only
+ * ones that can be updated piece by piece.
+ * @return True if dirty rectangles can be used.
+ */
+bool Screen::canFlipDirty() const
+{
+	return !isOpenGLEnabled() && !(_screen->flags & SDL_DOUBLEBUF);
+}
+
+/**
+ * Compares the buffer against the last frame pushed and
+ * rezooms only the bands of rows that changed, then
+ * updates just those parts of the display.
+ */
+void Screen::flipDirty()
+{
+	// rows this close together are pushed as one band
+	const int MERGE_GAP = 8;
+
+	SDL_Surface *src = _surface->getSurface();
+	size_t rowSize = src->w * src->format->BytesPerPixel;
+	Uint8 *pixels = (Uint8*)src->pixels;
+	Uint8 *last = &_lastFrame[0];
+	_dirtyRects.clear();
+	double time = CrossPlatform::getPerformanceTime();
+
+	int y = 0;
+	while (y < src->h)
+	{
+		if (memcmp(pixels + y * src->pitch, last + y * src->pitch, rowSize) == 0)
+		{
+			y++;
+			continue;
+		}
+		int yFirst = y, yLast = y + 1;
+		for (y = yLast; y < src->h && y < yLast + MERGE_GAP; ++y)
+		{
+			if (memcmp(pixels + y * src->pitch, last + y * src->pitch, rowSize) != 0)
+			{
+				yLast = y + 1;
+			}
+		}
+		y = yLast;
+		memcpy(last + yFirst * src->pitch, pixels + yFirst * src->pitch, (yLast - yFirst) * src->pitch);
+
+		bool partial = Zoom::flipRowsWithZoom(src, _screen, _topBlackBand, _bottomBlackBand, _leftBlackBand, _rightBlackBand, _zoomBuffer, yFirst, yLast);
+		SDL_Rect rect;
+		rect.x = _leftBlackBand;
+		rect.y = yFirst;
+		rect.w = getWidth() - _leftBlackBand - _rightBlackBand;
+		rect.h = yLast - yFirst;
+		if (!partial)
+		{
+			// the whole buffer got pushed, nothing else to do
+			_dirtyRects.clear();
+			_dirtyRects.push_back(rect);
+			saveFrame();
+			break;
+		}
+		_dirtyRects.push_back(rect);
+	}
+
+	time = addFlipTime(FLIP_ZOOM, time);
+
+	if (!_dirtyRects.empty())
+	{
+		SDL_UpdateRects(_screen, _dirtyRects.size(), &_dirtyRects[0]);
+	}
+	addFlipTime(FLIP_PRESENT, time);
+}
+
+/**
+ * Adds the time since the start of a stage to its total.
+ * @param stage Stage that just finished.
+ * @param start Time the stage started at.
+ * @return Current time, for the start of the next stage.
+ */
+double Screen::addFlipTime(FlipStage stage, double start)
+{
+	double now = CrossPlatform::getPerformanceTime();
+	_flipTimes[stage] += now - start;
+	return now;
+}
+
+/**
+ * Returns the total time spent on a stage of flip()
+ * since the timings were last reset.
+ * @param stage Stage of flipping.
+ * @return Time in seconds.
+ */
+double Screen::getFlipTime(FlipStage stage) const
+{
+	return _flipTimes[stage];
+}
+
+/**
+ * Resets the timings of every stage of flip() to zero.
+ */
+void Screen::resetFlipTimes()
+{
+	for (int i = 0; i < FLIP_STAGES; ++i)
+	{
+		_flipTimes[i] = 0.0;
+	}
+}
+
+/**
+ * Makes the next flip() redraw the whole display
+ * instead of only the parts that changed.
+ */
+void Screen::invalidate()
+{
+	_redrawAll = true;
+}
+
+/**
+ * Checks if the buffer holds a full composition of the
+ * states being shown, so only their changes need to be
+ * blitted over it.
+ * @return True if the buffer is composited.
+ */
+bool Screen::isComposited() const
+{
+	return _composited;
+}
+
+/**
+ * Marks whether the buffer holds a full composition of
+ * the states being shown.
+ * @param composited True if the buffer is composited.
+ */
+void Screen::setComposited(bool composited)
+{
+	_composited = composited;
+}
+
+/**
+ * Copies the buffer's contents so the next frame
+ * can be checked for changes.
+ */
+void Screen::saveFrame()
+{
+	SDL_Surface *src = _surface->getSurface();
+	_lastFrame.resize(src->pitch * src->h);
+	memcpy(&_lastFrame[0], src->pixels, _lastFrame.size());
 }
 
 /**
@@ -218,6 +389,12 @@ void Screen::flip()
 void Screen::clear()
 {
 	_surface->clear();
+	_composited = false;
+	if (canFlipDirty() && !_redrawAll)
+	{
+		// the display keeps its contents, only the changes get pushed
+		return;
+	}
 	if (_screen->flags & SDL_SWSURFACE) memset(_screen->pixels, 0, _screen->h*_screen->pitch);
 	else SDL_FillRect(_screen, &_clear, 0);
 }
@@ -246,6 +423,7 @@ void Screen::setPalette(SDL_Color* colors, int firstcolor, int ncolors, bool imm
 	}
 
 	_surface->setPalette(colors, firstcolor, ncolors);
+	_redrawAll = true;
 
 	// defer actual update of screen until SDL_Flip()
 	if (immediately && _screen->format->BitsPerPixel == 8 && SDL_SetColors(_screen, colors, firstcolor, ncolors) == 0)
@@ -322,6 +500,8 @@ void Screen::resetDisplay(bool resetVideo)
 		if (_surface->getSurface()->format->BitsPerPixel == 8) _surface->setPalette(deferredPalette);
 	}
 	SDL_SetColorKey(_surface->getSurface(), 0, 0); // turn off color key! 
+	_redrawAll = true;
+	_composited = false;
 
 	if (resetVideo || _screen->format->BitsPerPixel != _bpp)
 	{
@@ -445,6 +625,29 @@ void Screen::resetDisplay(bool resetVideo)
 		_topBlackBand = _bottomBlackBand = _leftBlackBand = _rightBlackBand = _cursorTopBlackBand = _cursorLeftBlackBand = 0;
 	}
 
+	// intermediate surface for zooming between the black bands, kept between frames
+	int zoomWidth = getWidth() - _leftBlackBand - _rightBlackBand;
+	int zoomHeight = getHeight() - _topBlackBand - _bottomBlackBand;
+	bool needBuffer = !isOpenGLEnabled() &&
+		(_topBlackBand > 0 || _bottomBlackBand > 0 || _leftBlackBand > 0 || _rightBlackBand > 0) &&
+		(zoomWidth != _baseWidth || zoomHeight != _baseHeight);
+	if (_zoomBuffer && (!needBuffer ||
+		_zoomBuffer->w != zoomWidth ||
+		_zoomBuffer->h != zoomHeight ||
+		_zoomBuffer->format->BitsPerPixel != _screen->format->BitsPerPixel))
+	{
+		SDL_FreeSurface(_zoomBuffer);
+		_zoomBuffer = 0;
+	}
+	if (needBuffer && !_zoomBuffer)
+	{
+		_zoomBuffer = SDL_CreateRGBSurface(_screen->flags, zoomWidth, zoomHeight, _screen->format->BitsPerPixel, 0, 0, 0, 0);
+		if (_zoomBuffer == 0)
+		{
+			throw Exception(SDL_GetError());
+		}
+	}
+
 	if (isOpenGLEnabled()) 
 	{
 #ifndef __NO_OPENGL
@@ -21,6 +21,7 @@
 
 #include <SDL.h>
 #include <string>
+#include <vector>
 #include "OpenGL.h"
 
 namespace OpenXcom
@@ -39,6 +40,9 @@ class Action;
  */
 class Screen
 {
+public:
+	/// Stages of flip() that get timed.
+	enum FlipStage { FLIP_ZOOM, FLIP_PALETTE, FLIP_PRESENT, FLIP_STAGES };
 private:
 	SDL_Surface *_screen;
 	int _bpp;
@@ -52,8 +56,21 @@ private:
 	OpenGL glOutput;
 	Surface *_surface;
 	SDL_Rect _clear;
+	SDL_Surface *_zoomBuffer;
+	std::vector<Uint8> _lastFrame;
+	std::vector<SDL_Rect> _dirtyRects;
+	bool _redrawAll, _composited;
+	double _flipTimes[FLIP_STAGES];
 	/// Sets the _flags and _bpp variables based on game options; needed in more than one place now
 	void makeVideoFlags();
+	/// Checks if the display can be updated by dirty rectangles.
+	bool canFlipDirty() const;
+	/// Pushes only the rows of the buffer that changed since the last frame.
+	void flipDirty();
+	/// Keeps a copy of the buffer to compare the next frame against.
+	void saveFrame();
+	/// Adds the time spent on a stage of flipping.
+	double addFlipTime(FlipStage stage, double start);
 public:
 	static const int ORIGINAL_WIDTH;
 	static const int ORIGINAL_HEIGHT;
@@ -74,6 +91,16 @@ public:
 	void flip();
 	/// Clears the screen.
 	void clear();
+	/// Makes the next flip redraw everything.
+	void invalidate();
+	/// Checks if the buffer holds the current states.
+	bool isComposited() const;
+	/// Marks the buffer as holding the current states.
+	void setComposited(bool composited);
+	/// Gets the time spent on a stage of flipping.
+	double getFlipTime(FlipStage stage) const;
+	/// Resets the flip timings.
+	void resetFlipTimes();
 	/// Sets the screen's 8bpp palette.
 	void setPalette(SDL_Color *colors, int firstcolor = 0, int ncolors = 256, bool immediately = false);
 	/// Gets the screen's 8bpp palette.
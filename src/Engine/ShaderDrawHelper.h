@@ -259,7 +259,7 @@ public:
 		_range_domain(s->getWidth(), s->getHeight()),
 		_pitch(s->getSurface()->pitch)		
 	{
-			
+		s->setDirty();
 	}
 	
 	/**
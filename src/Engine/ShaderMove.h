@@ -142,7 +142,7 @@ inline ShaderMove<Uint8> ShaderSurface(Surface* s, int x, int y)
 inline ShaderMove<Uint8> ShaderCrop(Surface* s, int x, int y)
 {
 	ShaderMove<Uint8> ret(s, x, y);
-	SDL_Rect* s_crop = s->getCrop();
+	const SDL_Rect* s_crop = s->getCrop();
 	if (s_crop->w && s_crop->h)
 	{
 		GraphSubset crop(std::make_pair(s_crop->x, s_crop->x + s_crop->w), std::make_pair(s_crop->y, s_crop->y + s_crop->h));
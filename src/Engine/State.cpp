@@ -300,6 +300,20 @@ void State::blit()
 		(*i)->blit(_game->getScreen()->getSurface());
 }
 
+/**
+ * Gets the area of the screen covered by elements of
+ * the state that changed since they were last blitted.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool State::getDamage(SDL_Rect &rect)
+{
+	bool damaged = false;
+	for (std::vector<Surface*>::iterator i = _surfaces.begin(); i != _surfaces.end(); ++i)
+		damaged = (*i)->getDamage(rect) || damaged;
+	return damaged;
+}
+
 /**
  * Hides all the Surface child elements on display.
  */
@@ -80,6 +80,8 @@ public:
 	virtual void think();
 	/// Blits the state to the screen.
 	virtual void blit();
+	/// Gets the changed area of the state.
+	virtual bool getDamage(SDL_Rect &rect);
 	/// Hides all the state surfaces.
 	void hideAll();
 	/// Shws all the state surfaces.
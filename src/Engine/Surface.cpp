@@ -19,6 +19,7 @@
 #include "Surface.h"
 #include "ShaderDraw.h"
 #include <vector>
+#include <algorithm>
 #include <fstream>
 #include <SDL_gfxPrimitives.h>
 #include <SDL_image.h>
@@ -27,6 +28,7 @@
 #include "Exception.h"
 #include "Logger.h"
 #include "ShaderMove.h"
+#include "Zoom.h"
 #include <stdlib.h>
 #ifdef _WIN32
 #include <malloc.h>
@@ -134,7 +136,7 @@ inline void DeleteAligned(void* buffer)
  * @param y Y position in pixels.
  * @param bpp Bits-per-pixel depth.
  */
-Surface::Surface(int width, int height, int x, int y, int bpp) : _x(x), _y(y), _visible(true), _hidden(false), _redraw(false), _tftdMode(false), _alignedBuffer(0)
+Surface::Surface(int width, int height, int x, int y, int bpp) : _x(x), _y(y), _visible(true), _hidden(false), _redraw(false), _tftdMode(false), _dirty(true), _alignedBuffer(0)
 {
 	_alignedBuffer = NewAligned(bpp, width, height);
 	_surface = SDL_CreateRGBSurfaceFrom(_alignedBuffer, width, height, bpp, GetPitch(bpp, width), 0, 0, 0, 0);
@@ -154,6 +156,10 @@ Surface::Surface(int width, int height, int x, int y, int bpp) : _x(x), _y(y), _
 	_clear.y = 0;
 	_clear.w = getWidth();
 	_clear.h = getHeight();
+	_damage.x = 0;
+	_damage.y = 0;
+	_damage.w = 0;
+	_damage.h = 0;
 }
 
 /**
@@ -199,6 +205,12 @@ Surface::Surface(const Surface& other)
 	_visible = other._visible;
 	_hidden = other._hidden;
 	_redraw = other._redraw;
+	_tftdMode = other._tftdMode;
+	_dirty = true;
+	_damage.x = 0;
+	_damage.y = 0;
+	_damage.w = 0;
+	_damage.h = 0;
 }
 
 /**
@@ -261,6 +273,7 @@ void Surface::loadImage(const std::string &filename)
 
 	// Load file
 	Log(LOG_VERBOSE) << "Loading image: " << utf8;
+	_dirty = true;
 	_surface = IMG_Load(utf8.c_str());
 
 	if (!_surface)
@@ -390,6 +403,7 @@ void Surface::loadBdy(const std::string &filename)
  */
 void Surface::clear(Uint32 color)
 {
+	_dirty = true;
 	if (_surface->flags & SDL_SWSURFACE) memset(_surface->pixels, color, _surface->h*_surface->pitch);
 	else SDL_FillRect(_surface, &_clear, color);
 }
@@ -520,8 +534,12 @@ void Surface::blit(Surface *surface)
 		}
 		target.x = getX();
 		target.y = getY();
-		SDL_BlitSurface(_surface, cropper, surface->getSurface(), &target);
+		Zoom::blitPalette(_surface, cropper, surface->getSurface(), &target);
+		surface->setDirty();
 	}
+	_dirty = false;
+	_damage.w = 0;
+	_damage.h = 0;
 }
 
 /**
@@ -567,6 +585,7 @@ void Surface::copy(Surface *surface)
  */
 void Surface::drawRect(SDL_Rect *rect, Uint8 color)
 {
+	_dirty = true;
 	SDL_FillRect(_surface, rect, color);
 }
 
@@ -580,6 +599,7 @@ void Surface::drawRect(SDL_Rect *rect, Uint8 color)
  */
 void Surface::drawRect(Sint16 x, Sint16 y, Sint16 w, Sint16 h, Uint8 color)
 {
+	_dirty = true;
 	SDL_Rect rect;
 	rect.w = w;
 	rect.h = h;
@@ -598,6 +618,7 @@ void Surface::drawRect(Sint16 x, Sint16 y, Sint16 w, Sint16 h, Uint8 color)
  */
 void Surface::drawLine(Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 color)
 {
+	_dirty = true;
 	lineColor(_surface, x1, y1, x2, y2, Palette::getRGBA(getPalette(), color));
 }
 
@@ -610,6 +631,7 @@ void Surface::drawLine(Sint16 x1, Sint16 y1, Sint16 x2, Sint16 y2, Uint8 color)
  */
 void Surface::drawCircle(Sint16 x, Sint16 y, Sint16 r, Uint8 color)
 {
+	_dirty = true;
 	filledCircleColor(_surface, x, y, r, Palette::getRGBA(getPalette(), color));
 }
 
@@ -622,6 +644,7 @@ void Surface::drawCircle(Sint16 x, Sint16 y, Sint16 r, Uint8 color)
  */
 void Surface::drawPolygon(Sint16 *x, Sint16 *y, int n, Uint8 color)
 {
+	_dirty = true;
 	filledPolygonColor(_surface, x, y, n, Palette::getRGBA(getPalette(), color));
 }
 
@@ -636,6 +659,7 @@ void Surface::drawPolygon(Sint16 *x, Sint16 *y, int n, Uint8 color)
  */
 void Surface::drawTexturedPolygon(Sint16 *x, Sint16 *y, int n, Surface *texture, int dx, int dy)
 {
+	_dirty = true;
 	texturedPolygon(_surface, x, y, n, texture->getSurface(), dx, dy);
 }
 
@@ -648,6 +672,7 @@ void Surface::drawTexturedPolygon(Sint16 *x, Sint16 *y, int n, Surface *texture,
  */
 void Surface::drawString(Sint16 x, Sint16 y, const char *s, Uint8 color)
 {
+	_dirty = true;
 	stringColor(_surface, x, y, s, Palette::getRGBA(getPalette(), color));
 }
 
@@ -657,7 +682,12 @@ void Surface::drawString(Sint16 x, Sint16 y, const char *s, Uint8 color)
  */
 void Surface::setX(int x)
 {
-	_x = x;
+	if (_x != x)
+	{
+		addArea(_damage);
+		_x = x;
+		_dirty = true;
+	}
 }
 
 /**
@@ -666,7 +696,12 @@ void Surface::setX(int x)
  */
 void Surface::setY(int y)
 {
-	_y = y;
+	if (_y != y)
+	{
+		addArea(_damage);
+		_y = y;
+		_dirty = true;
+	}
 }
 
 /**
@@ -676,7 +711,12 @@ void Surface::setY(int y)
  */
 void Surface::setVisible(bool visible)
 {
-	_visible = visible;
+	if (_visible != visible)
+	{
+		addArea(_damage);
+		_visible = visible;
+		_dirty = true;
+	}
 }
 
 /**
@@ -694,6 +734,8 @@ bool Surface::getVisible() const
  */
 void Surface::resetCrop()
 {
+	addArea(_damage);
+	_dirty = true;
 	_crop.w = 0;
 	_crop.h = 0;
 	_crop.x = 0;
@@ -704,11 +746,23 @@ void Surface::resetCrop()
  * Returns the cropping rectangle for this surface.
  * @return Pointer to the cropping rectangle.
  */
-SDL_Rect *Surface::getCrop()
+const SDL_Rect *Surface::getCrop() const
 {
 	return &_crop;
 }
 
+/**
+ * Changes the cropping rectangle for this surface,
+ * so only that part of it is blitted.
+ * @param crop New cropping rectangle.
+ */
+void Surface::setCrop(const SDL_Rect &crop)
+{
+	addArea(_damage);
+	_dirty = true;
+	_crop = crop;
+}
+
 /**
  * Replaces a certain amount of colors in the surface's palette.
  * @param colors Pointer to the set of colors.
@@ -717,6 +771,7 @@ SDL_Rect *Surface::getCrop()
  */
 void Surface::setPalette(SDL_Color *colors, int firstcolor, int ncolors)
 {
+	_dirty = true;
 	if (_surface->format->BitsPerPixel == 8)
 		SDL_SetColors(_surface, colors, firstcolor, ncolors);
 }
@@ -730,7 +785,12 @@ void Surface::setPalette(SDL_Color *colors, int firstcolor, int ncolors)
  */
 void Surface::setHidden(bool hidden)
 {
-	_hidden = hidden;
+	if (_hidden != hidden)
+	{
+		addArea(_damage);
+		_hidden = hidden;
+		_dirty = true;
+	}
 }
 
 /**
@@ -741,6 +801,7 @@ void Surface::setHidden(bool hidden)
  */
 void Surface::lock()
 {
+	_dirty = true;
 	SDL_LockSurface(_surface);
 }
 
@@ -826,6 +887,7 @@ struct StandardShade
  */
 void Surface::blitNShade(Surface *surface, int x, int y, int off, bool half, int newBaseColor)
 {
+	surface->setDirty();
 	ShaderMove<Uint8> src(this, x, y);
 	if (half)
 	{
@@ -853,6 +915,76 @@ void Surface::invalidate(bool valid)
 	_redraw = valid;
 }
 
+/**
+ * Grows a rectangle to also cover another one.
+ * Rectangles with no width or height are empty.
+ * @param rect Rectangle to grow.
+ * @param other Rectangle to cover.
+ */
+static void uniteRect(SDL_Rect &rect, const SDL_Rect &other)
+{
+	if (other.w == 0 || other.h == 0)
+	{
+		return;
+	}
+	if (rect.w == 0 || rect.h == 0)
+	{
+		rect = other;
+		return;
+	}
+	int left = std::min(rect.x, other.x);
+	int top = std::min(rect.y, other.y);
+	int right = std::max(rect.x + rect.w, other.x + other.w);
+	int bottom = std::max(rect.y + rect.h, other.y + other.h);
+	rect.x = left;
+	rect.y = top;
+	rect.w = right - left;
+	rect.h = bottom - top;
+}
+
+/**
+ * Adds the area the surface covers when it's blitted
+ * to a bounding rectangle.
+ * @param rect Rectangle to grow.
+ */
+void Surface::addArea(SDL_Rect &rect) const
+{
+	SDL_Rect area;
+	area.x = getX();
+	area.y = getY();
+	if (_crop.w == 0 && _crop.h == 0)
+	{
+		area.w = getWidth();
+		area.h = getHeight();
+	}
+	else
+	{
+		area.w = _crop.w;
+		area.h = _crop.h;
+	}
+	uniteRect(rect, area);
+}
+
+/**
+ * Checks if the surface looks any different since it was
+ * last blitted, because it was drawn on, moved, shown or
+ * hidden, and adds the area that needs to be recomposited
+ * to a bounding rectangle.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool Surface::getDamage(SDL_Rect &rect)
+{
+	bool damaged = (_damage.w != 0 && _damage.h != 0);
+	uniteRect(rect, _damage);
+	if ((_dirty || _redraw) && _visible && !_hidden)
+	{
+		addArea(rect);
+		damaged = true;
+	}
+	return damaged;
+}
+
 /**
  * Returns the help description of this surface,
  * for example for showing in tooltips.
@@ -882,6 +1014,9 @@ void Surface::setTooltip(const std::string &tooltip)
  */
 void Surface::resize(int width, int height)
 {
+	addArea(_damage);
+	_dirty = true;
+
 	// Set up new surface
 	Uint8 bpp = _surface->format->BitsPerPixel;
 	int pitch = GetPitch(bpp, width);
@@ -41,11 +41,14 @@ protected:
 	SDL_Surface *_surface;
 	int _x, _y;
 	SDL_Rect _crop, _clear;
-	bool _visible, _hidden, _redraw, _tftdMode;
+	bool _visible, _hidden, _redraw, _tftdMode, _dirty;
+	SDL_Rect _damage;
 	void *_alignedBuffer;
 	std::string _tooltip;
 
 	void resize(int width, int height);
+	/// Adds the surface's blitted area to a rectangle.
+	void addArea(SDL_Rect &rect) const;
 public:
 	/// Creates a new surface with the specified size and position.
 	Surface(int width, int height, int x = 0, int y = 0, int bpp = 8);
@@ -128,7 +131,9 @@ public:
 	/// Resets the cropping rectangle for the surface.
 	void resetCrop();
 	/// Gets the cropping rectangle for the surface.
-	SDL_Rect *getCrop();
+	const SDL_Rect *getCrop() const;
+	/// Sets the cropping rectangle for the surface.
+	void setCrop(const SDL_Rect &crop);
 	/**
 	 * Changes the color of a pixel in the surface, relative to
 	 * the top-left corner of the surface.
@@ -142,6 +147,7 @@ public:
 		{
 			return;
 		}
+		_dirty = true;
 		((Uint8 *)_surface->pixels)[y * _surface->pitch + x * _surface->format->BytesPerPixel] = pixel;
 	}
 	/**
@@ -214,6 +220,10 @@ public:
 	void blitNShade(Surface *surface, int x, int y, int off, bool half = false, int newBaseColor = 0);
 	/// Invalidate the surface: force it to be redrawn
 	void invalidate(bool valid = true);
+	/// Marks the surface contents as changed.
+	void setDirty() { _dirty = true; }
+	/// Gets the area that changed since the surface was last blitted.
+	virtual bool getDamage(SDL_Rect &rect);
 	/// Gets the tooltip of the surface.
 	std::string getTooltip() const;
 	/// Sets the tooltip of the surface.
@@ -0,0 +1,307 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ThreadPool.h"
+#include <algorithm>
+#include "CrossPlatform.h"
+#include "Logger.h"
+#include "Options.h"
+
+namespace OpenXcom
+{
+
+ThreadPool *ThreadPool::_shared = 0;
+
+/**
+ * Initializes the pool and spawns the worker threads.
+ * The calling thread counts as one of them, so
+ * only threads - 1 extra threads are created.
+ * @param threads Number of threads to run tasks on.
+ */
+ThreadPool::ThreadPool(int threads) : _handler(0), _data(0), _tasks(0), _next(0), _pending(0), _quit(false), _busy(false)
+{
+	_mutex = SDL_CreateMutex();
+	_wake = SDL_CreateCond();
+	_done = SDL_CreateCond();
+	if (_mutex == 0 || _wake == 0 || _done == 0)
+	{
+		Log(LOG_WARNING) << "Couldn't create worker thread sync objects, running single-threaded: " << SDL_GetError();
+		return;
+	}
+	start(threads);
+}
+
+/**
+ * Wakes up all the workers so they can quit
+ * and waits for them to finish.
+ */
+ThreadPool::~ThreadPool()
+{
+	if (_mutex != 0)
+	{
+		stop();
+	}
+	if (_done != 0)
+		SDL_DestroyCond(_done);
+	if (_wake != 0)
+		SDL_DestroyCond(_wake);
+	if (_mutex != 0)
+		SDL_DestroyMutex(_mutex);
+}
+
+/**
+ * Spawns the extra worker threads. Must be called
+ * while no job is running.
+ * @param threads Number of threads to run tasks on.
+ */
+void ThreadPool::start(int threads)
+{
+	SDL_mutexP(_mutex);
+	_quit = false;
+	_tasks = _next = _pending = 0;
+	for (int i = 1; i < threads; ++i)
+	{
+		SDL_Thread *thread = SDL_CreateThread(work, (void*)this);
+		if (thread == 0)
+		{
+			Log(LOG_WARNING) << "Couldn't create worker thread: " << SDL_GetError();
+			break;
+		}
+		_workers.push_back(thread);
+	}
+	SDL_mutexV(_mutex);
+}
+
+/**
+ * Wakes up all the workers so they can quit
+ * and waits for them to finish. Must be called
+ * while no job is running.
+ */
+void ThreadPool::stop()
+{
+	SDL_mutexP(_mutex);
+	_quit = true;
+	SDL_CondBroadcast(_wake);
+	SDL_mutexV(_mutex);
+	for (std::vector<SDL_Thread*>::iterator i = _workers.begin(); i != _workers.end(); ++i)
+	{
+		SDL_WaitThread(*i, 0);
+	}
+	SDL_mutexP(_mutex);
+	_workers.clear();
+	SDL_mutexV(_mutex);
+}
+
+/**
+ * Gets the number of threads that take part in a job,
+ * including the calling thread.
+ * @return Number of threads.
+ */
+int ThreadPool::getThreadCount() const
+{
+	if (_mutex == 0)
+		return 1;
+	SDL_mutexP(_mutex);
+	int threads = (int)_workers.size() + 1;
+	SDL_mutexV(_mutex);
+	return threads;
+}
+
+/**
+ * Stops the current workers and spawns a new set, after
+ * waiting for any running job to finish. Jobs started
+ * while the pool is being resized run on their caller.
+ * @param threads Number of threads to run tasks on.
+ */
+void ThreadPool::resize(int threads)
+{
+	if (_mutex == 0 || threads == getThreadCount())
+		return;
+	SDL_mutexP(_mutex);
+	while (_busy)
+	{
+		SDL_CondWait(_done, _mutex);
+	}
+	_busy = true;
+	SDL_mutexV(_mutex);
+
+	stop();
+	start(threads);
+	Log(LOG_INFO) << "Running tasks on " << getThreadCount() << " thread(s).";
+
+	SDL_mutexP(_mutex);
+	_busy = false;
+	SDL_CondBroadcast(_done);
+	SDL_mutexV(_mutex);
+}
+
+/**
+ * Runs a handler once for every task index in [0, tasks),
+ * spreading them over the workers and the calling thread.
+ * Returns once every task has finished. Tasks must not
+ * write to any data shared with other tasks.
+ * The pool runs one job at a time, so a job started while
+ * another is running (from another thread, or from inside
+ * a task) just runs on its caller.
+ * @param handler Function to run for each task.
+ * @param data Job data passed to the handler.
+ * @param tasks Number of tasks.
+ */
+void ThreadPool::run(TaskHandler handler, void *data, int tasks)
+{
+	bool spread = (_mutex != 0 && tasks > 1);
+	if (spread)
+	{
+		SDL_mutexP(_mutex);
+		spread = (!_busy && !_workers.empty());
+		if (spread)
+		{
+			_busy = true;
+		}
+		else
+		{
+			SDL_mutexV(_mutex);
+		}
+	}
+	if (!spread)
+	{
+		for (int i = 0; i < tasks; ++i)
+		{
+			handler(data, i);
+		}
+		return;
+	}
+
+	_handler = handler;
+	_data = data;
+	_tasks = tasks;
+	_next = 0;
+	_pending = tasks;
+	SDL_CondBroadcast(_wake);
+	while (_next < _tasks)
+	{
+		int task = _next++;
+		SDL_mutexV(_mutex);
+		handler(data, task);
+		SDL_mutexP(_mutex);
+		_pending--;
+	}
+	while (_pending > 0)
+	{
+		SDL_CondWait(_done, _mutex);
+	}
+	_handler = 0;
+	_data = 0;
+	_busy = false;
+	SDL_CondBroadcast(_done);
+	SDL_mutexV(_mutex);
+}
+
+/**
+ * Worker loop, picks up tasks from the current job
+ * until the pool is stopped.
+ * @param pool Pointer to the owning pool.
+ * @return Thread status, 0 = ok
+ */
+int ThreadPool::work(void *pool)
+{
+	ThreadPool *self = (ThreadPool*)pool;
+	SDL_mutexP(self->_mutex);
+	while (true)
+	{
+		while (!self->_quit && self->_next >= self->_tasks)
+		{
+			SDL_CondWait(self->_wake, self->_mutex);
+		}
+		if (self->_quit)
+			break;
+		int task = self->_next++;
+		TaskHandler handler = self->_handler;
+		void *data = self->_data;
+		SDL_mutexV(self->_mutex);
+		handler(data, task);
+		SDL_mutexP(self->_mutex);
+		if (--self->_pending == 0)
+		{
+			SDL_CondBroadcast(self->_done);
+		}
+	}
+	SDL_mutexV(self->_mutex);
+	return 0;
+}
+
+/**
+ * Gets how many threads a pool should use, based on
+ * the workerThreads option (0 picks one per CPU core).
+ * @return Number of threads, at least 1.
+ */
+int ThreadPool::getDefaultThreadCount()
+{
+	int threads = Options::workerThreads;
+	if (threads <= 0)
+	{
+		threads = CrossPlatform::getNumberOfCores();
+	}
+	return std::max(1, std::min(threads, 16));
+}
+
+/**
+ * Gets the pool shared by the scalers, the battlescape,
+ * the globe and anything else that splits up its work.
+ * The Game creates it on startup, it's only created
+ * here for tools running without one.
+ * @return Thread pool.
+ */
+ThreadPool *ThreadPool::getShared()
+{
+	if (_shared == 0)
+	{
+		_shared = new ThreadPool(getDefaultThreadCount());
+	}
+	return _shared;
+}
+
+/**
+ * Creates the shared pool, or resizes it if the
+ * workerThreads option changed since. Only call this
+ * from the main thread.
+ */
+void ThreadPool::updateShared()
+{
+	if (_shared == 0)
+	{
+		_shared = new ThreadPool(getDefaultThreadCount());
+		Log(LOG_INFO) << "Running tasks on " << _shared->getThreadCount() << " thread(s).";
+	}
+	else
+	{
+		_shared->resize(getDefaultThreadCount());
+	}
+}
+
+/**
+ * Stops the shared pool's workers and deletes it,
+ * once nothing else is using it.
+ */
+void ThreadPool::destroyShared()
+{
+	delete _shared;
+	_shared = 0;
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_THREADPOOL_H
+#define OPENXCOM_THREADPOOL_H
+
+#include <vector>
+#include <SDL.h>
+#include <SDL_thread.h>
+
+namespace OpenXcom
+{
+
+/**
+ * A persistent pool of worker threads used to split
+ * CPU-heavy work (like software scaling) into independent
+ * tasks. Workers sleep between jobs, so the pool can be
+ * kept around for the lifetime of its owner.
+ * The calling thread always helps out, so a pool with
+ * a single thread just runs everything inline.
+ * The engine keeps one shared pool for all its subsystems,
+ * so they don't fight over the CPU cores.
+ */
+class ThreadPool
+{
+public:
+	/// Function run for each task, with the job data and the task index.
+	typedef void (*TaskHandler)(void *data, int task);
+private:
+	std::vector<SDL_Thread*> _workers;
+	SDL_mutex *_mutex;
+	SDL_cond *_wake, *_done;
+	TaskHandler _handler;
+	void *_data;
+	int _tasks, _next, _pending;
+	bool _quit, _busy;
+	static ThreadPool *_shared;
+	/// Entry point for the worker threads.
+	static int work(void *pool);
+	/// Spawns the worker threads.
+	void start(int threads);
+	/// Stops the worker threads.
+	void stop();
+public:
+	/// Creates a pool with a number of threads.
+	ThreadPool(int threads);
+	/// Stops and cleans up the worker threads.
+	~ThreadPool();
+	/// Gets the number of threads running tasks.
+	int getThreadCount() const;
+	/// Changes the number of threads running tasks.
+	void resize(int threads);
+	/// Runs a job split into a number of tasks and waits for it to finish.
+	void run(TaskHandler handler, void *data, int tasks);
+	/// Gets the thread count requested by the options.
+	static int getDefaultThreadCount();
+	/// Gets the pool shared by the whole engine.
+	static ThreadPool *getShared();
+	/// Matches the shared pool to the workerThreads option.
+	static void updateShared();
+	/// Stops and deletes the shared pool.
+	static void destroyShared();
+};
+
+}
+
+#endif
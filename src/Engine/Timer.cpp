@@ -132,7 +132,9 @@ void Timer::think(State* state, Surface* surface)
 				(surface->*_surface)();
 			}
 			_start = slowTick();
-			if (_start > _frameSkipStart) _frameSkipStart = _start; // don't play animations in ffwd to catch up :P
+			// keep the timer's phase so coarse think ticks don't stretch the interval,
+			// but don't play animations in ffwd to catch up :P
+			if (_start >= _frameSkipStart + _interval) _frameSkipStart = _start;
 		}
 	}
 }
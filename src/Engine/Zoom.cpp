@@ -18,11 +18,13 @@
  */
 
 #include "Zoom.h"
+#include <algorithm>
 
 #include "Surface.h"
 #include "Logger.h"
 #include "Options.h"
 #include "Screen.h"
+#include "ThreadPool.h"
 
 #include "OpenGL.h"
 
@@ -56,597 +58,719 @@
 #include <emmintrin.h> // for SSE2 intrinsics; see http://msdn.microsoft.com/en-us/library/has3d153%28v=vs.71%29.aspx
 #endif
 
+// AVX2 kernels are compiled for that CPU alone and only picked at runtime
+#if defined(__SSE2__) && ((defined(__GNUC__) && (__i386__ || __x86_64__) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) || (defined(_MSC_VER) && _MSC_VER >= 1700))
+#define ZOOM_AVX2
+#include <immintrin.h>
+#ifdef __GNUC__
+#define ZOOM_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define ZOOM_AVX2_TARGET
+#endif
+#endif
+
 
 
 namespace OpenXcom
 {
 
 
+#ifdef __SSE2__
 /**
- * Optimized 8-bit zoomer for resizing by a factor of 2. Doesn't flip.
- * Used internally by _zoomSurfaceY() below.
- * source and dest. widths must be multiples of 8 bytes for 64-bit access
- *
- * @param src The surface to zoom (input).
- * @param dst The zoomed surface (output).
- * @return 0 for success or -1 for error.
+ * Checks the SSE2 feature bit returned by the CPUID instruction
+ * @return Does the CPU support SSE2?
  */
-/*
-static int zoomSurface2X_64bit(SDL_Surface *src, SDL_Surface *dst)
+bool Zoom::haveSSE2()
 {
-	Uint64 dataSrc;
-	Uint64 dataDst;
-	Uint8 *pixelSrc = (Uint8*)src->pixels;
-	Uint8 *pixelDstRow = (Uint8*)dst->pixels;
-	int sx, sy;
-	static bool proclaimed = false;
-	
-	if (!proclaimed)
+#ifdef __GNUC__
+	unsigned int CPUInfo[4] = {0, 0, 0, 0};
+	__get_cpuid(1, CPUInfo, CPUInfo+1, CPUInfo+2, CPUInfo+3);
+#elif _WIN32
+	int CPUInfo[4];
+	__cpuid(CPUInfo, 1);
+#else
+	unsigned int CPUInfo[4] = {0, 0, 0, 0};
+#endif
+
+	return (CPUInfo[3] & 0x04000000) ? true : false;
+}
+
+#endif
+
+/**
+ * Checks the AVX2 feature bit returned by the CPUID instruction,
+ * and that the OS saves the AVX registers on context switches.
+ * @return Can the CPU run AVX2 code?
+ */
+bool Zoom::haveAVX2()
+{
+#ifdef ZOOM_AVX2
+#ifdef __GNUC__
+	unsigned int CPUInfo[4] = {0, 0, 0, 0};
+	if (__get_cpuid_max(0, 0) < 7)
 	{
-		proclaimed = true;
-		Log(LOG_INFO) << "Using somewhat fast 2X zoom routine.";
+		return false;
 	}
-
-	for (sy = 0; sy < src->h; ++sy, pixelDstRow += dst->pitch*2)
+	__cpuid(1, CPUInfo[0], CPUInfo[1], CPUInfo[2], CPUInfo[3]);
+	if ((CPUInfo[2] & 0x18000000) != 0x18000000) // OSXSAVE and AVX
 	{
-		Uint64 *pixelDst = (Uint64*)pixelDstRow;
-		Uint64 *pixelDst2 = (Uint64*)(pixelDstRow + dst->pitch);	
-		for (sx = 0; sx < src->w; sx += 8, pixelSrc += 8)
-		{
-			dataSrc = *((Uint64*) pixelSrc);
-			// boo
-			(void)SDL_SwapLE64(dataSrc);
- */
-/* expanded form of data shift: 
-			dataDst = (dataSrc & 0xFF) | ((dataSrc & 0xFF) << 8) | 
-				((dataSrc & 0xFF00 ) << 8) | ((dataSrc & 0xFF00)) << 16)  | 
-				((dataSrc & 0xFF0000) << 16) | ((dataSrc & 0xFF0000) << 24) |
-				((dataSrc & 0xFF000000) << 24) | ((dataSrc & 0xFF000000) << 32);
- */
-			// compact form, combining terms with equal multipliers (shifts)
-/*
-			dataDst = (dataSrc & 0xFF) | ((dataSrc & 0xFFFF) << 8) | 
-				((dataSrc & 0xFFFF00) << 16)  | 
-				((dataSrc & 0xFFFF0000) << 24) |
-				((dataSrc & 0xFF000000) << 32);
-
-			*pixelDst = dataDst;
-			*pixelDst2 = dataDst;
-			pixelDst++; // forward 8 bytes!
-			pixelDst2++;
-			dataSrc >>= 32;
+		return false;
+	}
+	unsigned int xcr0 = 0, xcr0High = 0;
+	__asm__ __volatile__ ("xgetbv" : "=a" (xcr0), "=d" (xcr0High) : "c" (0));
+	if ((xcr0 & 6) != 6) // XMM and YMM state
+	{
+		return false;
+	}
+	__cpuid_count(7, 0, CPUInfo[0], CPUInfo[1], CPUInfo[2], CPUInfo[3]);
+#else
+	int CPUInfo[4];
+	__cpuid(CPUInfo, 0);
+	if (CPUInfo[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(CPUInfo, 1);
+	if ((CPUInfo[2] & 0x18000000) != 0x18000000) // OSXSAVE and AVX
+	{
+		return false;
+	}
+	if ((_xgetbv(0) & 6) != 6) // XMM and YMM state
+	{
+		return false;
+	}
+	__cpuidex(CPUInfo, 7, 0);
+#endif
+	return (CPUInfo[1] & 0x00000020) ? true : false;
+#else
+	return false;
+#endif
+}
 
-			dataDst = (dataSrc & 0xFF) | ((dataSrc & 0xFFFF) << 8) | 
-				((dataSrc & 0xFFFF00) << 16)  | 
-				((dataSrc & 0xFFFF0000) << 24) |
-				((dataSrc & 0xFF000000) << 32);
+/**
+ * Instruction sets the zoom kernels can use.
+ */
+enum SimdLevel { SIMD_NONE, SIMD_SSE2, SIMD_AVX2 };
 
-			*pixelDst = dataDst;
-			*pixelDst2 = dataDst;
-			pixelDst++;	// 8 bytes again		
-			pixelDst2++;
+/**
+ * Finds out the best instruction set the CPU supports,
+ * only checking the first time.
+ * @return The instruction set to use.
+ */
+static SimdLevel getSimdLevel()
+{
+	static int level = -1;
+	if (level == -1)
+	{
+		level = SIMD_NONE;
+#ifdef __SSE2__
+		if (Zoom::haveSSE2())
+		{
+			level = SIMD_SSE2;
 		}
+#endif
+		if (level == SIMD_SSE2 && Zoom::haveAVX2())
+		{
+			level = SIMD_AVX2;
+		}
+		const char *names[] = { "scalar", "SSE2", "AVX2" };
+		Log(LOG_INFO) << "Using " << names[level] << " zoom and palette routines.";
 	}
-	
-	return 0;
+	return (SimdLevel)level;
 }
- */
 
+/// Copies an 8bpp row onto one factor times wider, repeating each pixel.
+typedef void (*StretchRowFunc)(const Uint8 *src, Uint8 *dst, int width, int factor);
+/// Converts an 8bpp row to 32bpp through a color map, leaving the color key (-1 for none) untouched.
+typedef void (*PaletteRowFunc)(const Uint8 *src, Uint32 *dst, int width, const Uint32 *map, int key);
 
-#if defined(__WORDSIZE) && (__WORDSIZE == 64) || defined(SIZE_MAX) && (SIZE_MAX > 0xFFFFFFFF)
-#else
 /**
- * Optimized 8-bit zoomer for resizing by a factor of 2. Doesn't flip.
- * 32-bit version for sad old x86 chips which run out of registers 
- * with the 64-bit version.
- * Used internally by _zoomSurfaceY() below.
- * source and dest. widths must be multiples of 4 bytes for 32-bit access
+ * Stretches a row of pixels horizontally by a whole factor.
+ * Reference version for the SIMD kernels below, which
+ * must give exactly the same result.
  *
- * @param src The surface to zoom (input).
- * @param dst The zoomed surface (output).
- * @return 0 for success or -1 for error.
+ * @param src Source row.
+ * @param dst Destination row, width * factor pixels long.
+ * @param width Width of the source row.
+ * @param factor Horizontal scaling factor.
  */
-/*
-static int zoomSurface2X_32bit(SDL_Surface *src, SDL_Surface *dst)
+static void stretchRow(const Uint8 *src, Uint8 *dst, int width, int factor)
 {
-	Uint32 dataSrc;
-	Uint32 dataDst;
-	Uint8 *pixelSrc = (Uint8*)src->pixels;
-	Uint8 *pixelDstRow = (Uint8*)dst->pixels;
-	int sx, sy;
-	static bool proclaimed = false;
-	
-	if (!proclaimed)
+	for (int x = 0; x < width; ++x)
 	{
-		proclaimed = true;
-		Log(LOG_INFO) << "Using 32-bit 2X zoom routine.";
+		for (int i = 0; i < factor; ++i)
+		{
+			*dst++ = src[x];
+		}
 	}
+}
 
-
-	for (sy = 0; sy < src->h; ++sy, pixelDstRow += dst->pitch*2)
+/**
+ * Converts a row of 8bpp pixels to 32bpp.
+ * Reference version for the SIMD kernels below, which
+ * must give exactly the same result.
+ *
+ * @param src Source row.
+ * @param dst Destination row.
+ * @param width Width of the row.
+ * @param map 32bpp value of each palette color.
+ * @param key Color key to skip, or -1 to convert every pixel.
+ */
+static void paletteRow(const Uint8 *src, Uint32 *dst, int width, const Uint32 *map, int key)
+{
+	for (int x = 0; x < width; ++x)
 	{
-		Uint32 *pixelDst = (Uint32*)pixelDstRow;
-		Uint32 *pixelDst2 = (Uint32*)(pixelDstRow + dst->pitch);	
-		for (sx = 0; sx < src->w; sx += 4, pixelSrc += 4)
+		if (src[x] != key)
 		{
-			dataSrc = *((Uint32*) pixelSrc);
-
-			// boo
-			dataSrc = SDL_SwapLE32(dataSrc);
-			
-			dataDst = SDL_SwapLE32( (dataSrc & 0xFF) | ((dataSrc & 0xFFFF) << 8) | 
-				((dataSrc & 0xFF00) << 16)  );
+			dst[x] = map[src[x]];
+		}
+	}
+}
 
-			*pixelDst = dataDst;
-			*pixelDst2 = dataDst;
-			pixelDst++; // forward 4 bytes!
-			pixelDst2++;
+#ifdef __SSE2__
+/**
+ * SSE2 version of stretchRow().
+ * Factors 2 and 4 are done by interleaving 16 pixels at a time,
+ * other factors up to 16 by storing each pixel splatted across
+ * a whole register and letting the next store overwrite the excess.
+ */
+static void stretchRowSSE2(const Uint8 *src, Uint8 *dst, int width, int factor)
+{
+	int x = 0;
+	if (factor == 2)
+	{
+		for (; x + 16 <= width; x += 16)
+		{
+			__m128i data = _mm_loadu_si128((const __m128i*)(src + x));
+			_mm_storeu_si128((__m128i*)(dst + x * 2), _mm_unpacklo_epi8(data, data));
+			_mm_storeu_si128((__m128i*)(dst + x * 2 + 16), _mm_unpackhi_epi8(data, data));
+		}
+	}
+	else if (factor == 4)
+	{
+		for (; x + 16 <= width; x += 16)
+		{
+			__m128i data = _mm_loadu_si128((const __m128i*)(src + x));
+			__m128i low = _mm_unpacklo_epi8(data, data);
+			__m128i high = _mm_unpackhi_epi8(data, data);
+			_mm_storeu_si128((__m128i*)(dst + x * 4), _mm_unpacklo_epi16(low, low));
+			_mm_storeu_si128((__m128i*)(dst + x * 4 + 16), _mm_unpackhi_epi16(low, low));
+			_mm_storeu_si128((__m128i*)(dst + x * 4 + 32), _mm_unpacklo_epi16(high, high));
+			_mm_storeu_si128((__m128i*)(dst + x * 4 + 48), _mm_unpackhi_epi16(high, high));
+		}
+	}
+	else if (factor <= 16)
+	{
+		for (; (width - x) * factor >= 16; ++x)
+		{
+			_mm_storeu_si128((__m128i*)(dst + x * factor), _mm_set1_epi8((char)src[x]));
+		}
+	}
+	stretchRow(src + x, dst + x * factor, width - x, factor);
+}
 
-			dataSrc >>= 16; 
+/**
+ * SSE2 version of paletteRow().
+ * SSE2 can't look up the colors, but it can check 16 pixels
+ * against the color key at once, skipping transparent runs
+ * and writing opaque ones a whole register at a time.
+ */
+static void paletteRowSSE2(const Uint8 *src, Uint32 *dst, int width, const Uint32 *map, int key)
+{
+	__m128i keys = _mm_set1_epi8((char)key);
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		const Uint8 *s = src + x;
+		int mask = 0;
+		if (key >= 0)
+		{
+			mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)s), keys));
+		}
+		if (mask == 0xFFFF)
+		{
+			continue;
+		}
+		else if (mask != 0)
+		{
+			paletteRow(s, dst + x, 16, map, key);
+			continue;
+		}
+		for (int i = 0; i < 16; i += 4)
+		{
+			_mm_storeu_si128((__m128i*)(dst + x + i), _mm_set_epi32(map[s[i + 3]], map[s[i + 2]], map[s[i + 1]], map[s[i]]));
+		}
+	}
+	paletteRow(src + x, dst + x, width - x, map, key);
+}
+#endif
 
-			dataDst = SDL_SwapLE32( (dataSrc & 0xFF) | ((dataSrc & 0xFFFF) << 8) | 
-				((dataSrc & 0xFF00) << 16)  );
+#ifdef ZOOM_AVX2
+/**
+ * AVX2 version of stretchRow().
+ * Factors 2 and 4 widen the pixels and copy each byte into
+ * the new ones, other factors up to 32 are splatted like SSE2.
+ */
+ZOOM_AVX2_TARGET static void stretchRowAVX2(const Uint8 *src, Uint8 *dst, int width, int factor)
+{
+	int x = 0;
+	if (factor == 2)
+	{
+		for (; x + 16 <= width; x += 16)
+		{
+			__m256i data = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + x)));
+			_mm256_storeu_si256((__m256i*)(dst + x * 2), _mm256_or_si256(data, _mm256_slli_epi16(data, 8)));
+		}
+	}
+	else if (factor == 4)
+	{
+		__m256i spread = _mm256_set1_epi32(0x01010101);
+		for (; x + 8 <= width; x += 8)
+		{
+			__m256i data = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + x)));
+			_mm256_storeu_si256((__m256i*)(dst + x * 4), _mm256_mullo_epi32(data, spread));
+		}
+	}
+	else if (factor <= 32)
+	{
+		for (; (width - x) * factor >= 32; ++x)
+		{
+			_mm256_storeu_si256((__m256i*)(dst + x * factor), _mm256_set1_epi8((char)src[x]));
+		}
+	}
+	stretchRow(src + x, dst + x * factor, width - x, factor);
+}
 
-			*pixelDst = dataDst;
-			*pixelDst2 = dataDst;
-			pixelDst++; // forward 4 bytes!
-			pixelDst2++;
+/**
+ * AVX2 version of paletteRow().
+ * Looks up 8 colors at once with a gather, then only
+ * stores the ones that don't match the color key.
+ */
+ZOOM_AVX2_TARGET static void paletteRowAVX2(const Uint8 *src, Uint32 *dst, int width, const Uint32 *map, int key)
+{
+	__m256i keys = _mm256_set1_epi32(key);
+	__m256i ones = _mm256_set1_epi32(-1);
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + x)));
+		__m256i color = _mm256_i32gather_epi32((const int*)map, index, 4);
+		if (key < 0)
+		{
+			_mm256_storeu_si256((__m256i*)(dst + x), color);
+		}
+		else
+		{
+			__m256i opaque = _mm256_xor_si256(_mm256_cmpeq_epi32(index, keys), ones);
+			_mm256_maskstore_epi32((int*)(dst + x), opaque, color);
 		}
-		
 	}
-	
-	return 0;
+	paletteRow(src + x, dst + x, width - x, map, key);
 }
+#endif
+
+/**
+ * Picks the fastest stretchRow() kernel for this CPU.
+ * @return The row stretching function.
  */
+static StretchRowFunc pickStretchRow()
+{
+	switch (getSimdLevel())
+	{
+#ifdef ZOOM_AVX2
+	case SIMD_AVX2:
+		return stretchRowAVX2;
 #endif
+#ifdef __SSE2__
+	case SIMD_SSE2:
+		return stretchRowSSE2;
+#endif
+	default:
+		return stretchRow;
+	}
+}
 
 /**
- * Optimized 8-bit zoomer for resizing by a factor of 4. Doesn't flip.
- * Used internally by _zoomSurfaceY() below.
- * source and dest. widths must be multiples of 8 bytes for 64-bit access
- *
- * @param src The surface to zoom (input).
- * @param dst The zoomed surface (output).
- * @return 0 for success or -1 for error.
+ * Picks the fastest paletteRow() kernel for this CPU.
+ * @return The palette conversion function.
  */
-/*
-static int zoomSurface4X_64bit(SDL_Surface *src, SDL_Surface *dst)
+static PaletteRowFunc pickPaletteRow()
 {
-	Uint64 dataSrc;
-	Uint64 dataDst;
-	Uint8 *pixelSrc = (Uint8*)src->pixels;
-	Uint8 *pixelDstRow = (Uint8*)dst->pixels;
-	int sx, sy;
-	static bool proclaimed = false;
-	
-	if (!proclaimed)
+	switch (getSimdLevel())
 	{
-		proclaimed = true;
-		Log(LOG_INFO) << "Using modestly fast 4X zoom routine.";
+#ifdef ZOOM_AVX2
+	case SIMD_AVX2:
+		return paletteRowAVX2;
+#endif
+#ifdef __SSE2__
+	case SIMD_SSE2:
+		return paletteRowSSE2;
+#endif
+	default:
+		return paletteRow;
 	}
+}
 
-	for (sy = 0; sy < src->h; ++sy, pixelDstRow += dst->pitch*4)
+/**
+ * Stretches a row of 32bpp pixels horizontally by a whole factor.
+ *
+ * @param src Source row.
+ * @param dst Destination row, width * factor pixels long.
+ * @param width Width of the source row.
+ * @param factor Horizontal scaling factor.
+ */
+static void stretchRow32(const Uint32 *src, Uint32 *dst, int width, int factor)
+{
+	for (int x = 0; x < width; ++x)
 	{
-		Uint8 *pixelDst = pixelDstRow;
-	
-		for (sx = 0; sx < src->w; sx += 8, pixelSrc += 8)
+		Uint32 pixel = src[x];
+		for (int i = 0; i < factor; ++i)
 		{
-			dataSrc = *((Uint64*) pixelSrc);
-			// boo
-			(void)SDL_SwapLE64(dataSrc);
- */
-			/* expanded form of data shift:
-			dataDst = (dataSrc & 0xFF) | ((dataSrc & 0xFF) << 8) | 
-				((dataSrc & 0xFF) << 16 | ((datasrc & 0xFF) << 24) |
-				((dataSrc & 0xFF00 ) << 24) | ((dataSrc & 0xFF00) << 32)  | 
-				((dataSrc & 0xFF00 ) << 40) | ((dataSrc & 0xFF00) << 48) ;
-				 */
-/*
-			for (int i = 0; i < 4; ++i)
-			{
-				// compact form, combining terms with equal multipliers (shifts)
-				dataDst = (dataSrc & 0xFF) | ((dataSrc & 0xFF) << 8) | 
-					((dataSrc & 0xFF) << 16) | 
-					((dataSrc & 0xFFFF ) << 24) | ((dataSrc & 0xFF00) << 32)  | 
-					((dataSrc & 0xFF00 ) << 40) | ((dataSrc & 0xFF00) << 48) ;
-
-				*((Uint64*)pixelDst) = dataDst;
-				*((Uint64*)(pixelDst + dst->pitch)) = dataDst;
-				*((Uint64*)(pixelDst + dst->pitch*2)) = dataDst;
-				*((Uint64*)(pixelDst + dst->pitch*3)) = dataDst;
-				pixelDst+=8; // forward 8 bytes!
-				dataSrc >>= 16;
-			}
+			*dst++ = pixel;
 		}
 	}
-	
-	return 0;
 }
- */
 
-
-#if defined(__WORDSIZE) && (__WORDSIZE == 64) || defined(SIZE_MAX) && (SIZE_MAX > 0xFFFFFFFF)
-#else
 /**
- * Optimized 8-bit zoomer for resizing by a factor of 4. Doesn't flip.
- * 32-bit version.
- * Used internally by _zoomSurfaceY() below.
- * source and dest. widths must be multiples of 4 bytes for 32-bit access
+ * Optimized 8-bit and 32-bit zoomer for resizing by whole factors.
+ * Doesn't flip. Each source row is stretched once and then copied
+ * to the other destination rows it covers. Gives the same result
+ * as the generic zoomer in _zoomSurfaceY() below.
  *
  * @param src The surface to zoom (input).
  * @param dst The zoomed surface (output).
  * @return 0 for success or -1 for error.
  */
-/*
-static int zoomSurface4X_32bit(SDL_Surface *src, SDL_Surface *dst)
+static int zoomSurfaceInteger(SDL_Surface *src, SDL_Surface *dst)
 {
-	Uint32 dataSrc;
-	Uint32 dataDst;
-	Uint8 *pixelSrc = (Uint8*)src->pixels;
-	Uint8 *pixelDstRow = (Uint8*)dst->pixels;
-	int sx, sy;
-	static bool proclaimed = false;
-	
-	if (!proclaimed)
+	static StretchRowFunc stretch = pickStretchRow();
+	int factorX = dst->w / src->w;
+	int factorY = dst->h / src->h;
+	int bpp = src->format->BytesPerPixel;
+	Uint8 *srcRow = (Uint8*)src->pixels;
+	Uint8 *dstRow = (Uint8*)dst->pixels;
+
+	for (int y = 0; y < src->h; ++y, srcRow += src->pitch)
 	{
-		proclaimed = true;
-		Log(LOG_INFO) << "Using 32-bit 4X zoom routine.";
-	}
-
-	for (sy = 0; sy < src->h; ++sy, pixelDstRow += dst->pitch*4)
-	{
-		Uint32 *pixelDst = (Uint32*)pixelDstRow;
-		Uint32 *pixelDst2 = (Uint32*)(pixelDstRow + dst->pitch);
-		Uint32 *pixelDst3 = (Uint32*)(pixelDstRow + 2*dst->pitch);
-		Uint32 *pixelDst4 = (Uint32*)(pixelDstRow + 3*dst->pitch);
-		for (sx = 0; sx < src->w; sx += 4, pixelSrc += 4)
+		Uint8 *stretched = dstRow;
+		if (bpp == 4)
 		{
-			dataSrc = *((Uint32*) pixelSrc);
-			// boo
-			dataSrc = SDL_SwapLE32(dataSrc);
-			
-			for (int i = 0; i < 4; ++i)
-			{
-				dataDst = SDL_SwapLE32( (dataSrc & 0xFF) | ((dataSrc & 0xFF) << 8) | 
-					((dataSrc & 0xFF) << 16) | ((dataSrc & 0xFF ) << 24) ); 
-
-				*pixelDst = dataDst;
-				*pixelDst2 = dataDst;
-				*pixelDst3 = dataDst;
-				*pixelDst4 = dataDst;
-				pixelDst++; // forward 4 bytes!
-				pixelDst2++;
-				pixelDst3++;
-				pixelDst4++;
-				dataSrc >>= 8;
-			}
+			stretchRow32((const Uint32*)srcRow, (Uint32*)stretched, src->w, factorX);
+		}
+		else
+		{
+			stretch(srcRow, stretched, src->w, factorX);
+		}
+		dstRow += dst->pitch;
+		for (int i = 1; i < factorY; ++i, dstRow += dst->pitch)
+		{
+			memcpy(dstRow, stretched, dst->w * bpp);
 		}
 	}
-	
 	return 0;
 }
- */
-#endif
 
 /**
- * Optimized 8-bit zoomer for resizing by a factor of 4. Doesn't flip.
- * 32-bit version.
- * Used internally by _zoomSurfaceY() below.
- * source and dest. widths must be multiples of 4 bytes for 32-bit access
+ * Blits an 8bpp surface onto a 32bpp one, converting the
+ * palette with the SIMD kernels above. Clips and handles the
+ * color key exactly like SDL_BlitSurface(), which is still
+ * used for any other combination of surfaces and for small
+ * blits that aren't worth building the color map for.
  *
- * @param src The surface to zoom (input).
- * @param dst The zoomed surface (output).
+ * @param src The surface to blit (input).
+ * @param srcrect Area of the source to blit, 0 for all of it.
+ * @param dst The surface to blit onto (output).
+ * @param dstrect Position to blit to, 0 for the top-left corner. Returns the area that was blitted.
  * @return 0 for success or -1 for error.
  */
-/*
-static int zoomSurface2X_XAxis_32bit(SDL_Surface *src, SDL_Surface *dst)
+int Zoom::blitPalette(SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect)
 {
-	Uint32 dataSrc;
-	Uint32 dataDst;
-	Uint8 *pixelSrc;
-	Uint8 *pixelDstRow = (Uint8*)dst->pixels;
-	Uint8 *pixelSrcRow = (Uint8*)src->pixels;
-	int sx;
-	int dsty;
-	static bool proclaimed = false;
+	const int MIN_PIXELS = 64 * 64;
 
-	static Uint32 *say = 0;
-	Uint32 *csay;
-	int csy;
-	
-	if (!proclaimed)
+	if (src->format->BitsPerPixel != 8 || dst->format->BytesPerPixel != 4 ||
+		(src->flags & (SDL_SRCALPHA | SDL_RLEACCEL)) || src->format->palette == 0 ||
+		(srcrect ? srcrect->w * srcrect->h : src->w * src->h) < MIN_PIXELS)
 	{
-		proclaimed = true;
-		Log(LOG_INFO) << "Using mediocre scaling routine due to screen height.";
-	}
-	
-	if ((say = (Uint32 *) realloc(say, (dst->h + 1) * sizeof(Uint32))) == NULL) {
-		say = 0;
-		return (-1);
+		return SDL_BlitSurface(src, srcrect, dst, dstrect);
 	}
 
-	csy = 0;
-	csay = say;
-	for (int y = 0; y < dst->h; y++) {
-		csy += src->h;
-		*csay = 0;
-		while (csy >= dst->h) {
-			csy -= dst->h;
-			(*csay)++;
-		}
-		(*csay) *= src->pitch;
-		csay++;
+	// same clipping as SDL_UpperBlit()
+	SDL_Rect fulldst = {0, 0, 0, 0};
+	if (dstrect == 0)
+	{
+		dstrect = &fulldst;
 	}
-	
-	for (dsty = 0; dsty < dst->h; ++dsty, pixelDstRow += dst->pitch)
+	int srcx = 0, srcy = 0, w = src->w, h = src->h;
+	if (srcrect)
 	{
-		if (!say[dsty]) continue;
-
-		Uint32 *pixelDst = (Uint32*)pixelDstRow;
-		pixelSrc = pixelSrcRow;
-		pixelSrcRow += say[dsty];
-
-		for (sx = 0; sx < src->w; sx += 4, pixelSrc += 4)
+		srcx = srcrect->x;
+		w = srcrect->w;
+		if (srcx < 0)
 		{
-			dataSrc = *((Uint32*) pixelSrc);
-			// boo
-			dataSrc = SDL_SwapLE32(dataSrc);
-			
-			for (int i = 0; i < 2; ++i)
-			{
-				dataDst = SDL_SwapLE32( (dataSrc & 0xFF) | ((dataSrc & 0xFFFF) << 8) | 
-					((dataSrc & 0xFF00) << 16) );
+			w += srcx;
+			dstrect->x -= srcx;
+			srcx = 0;
+		}
+		w = std::min(w, src->w - srcx);
+		srcy = srcrect->y;
+		h = srcrect->h;
+		if (srcy < 0)
+		{
+			h += srcy;
+			dstrect->y -= srcy;
+			srcy = 0;
+		}
+		h = std::min(h, src->h - srcy);
+	}
+	const SDL_Rect &clip = dst->clip_rect;
+	int d = clip.x - dstrect->x;
+	if (d > 0)
+	{
+		w -= d;
+		dstrect->x += d;
+		srcx += d;
+	}
+	d = dstrect->x + w - clip.x - clip.w;
+	if (d > 0)
+	{
+		w -= d;
+	}
+	d = clip.y - dstrect->y;
+	if (d > 0)
+	{
+		h -= d;
+		dstrect->y += d;
+		srcy += d;
+	}
+	d = dstrect->y + h - clip.y - clip.h;
+	if (d > 0)
+	{
+		h -= d;
+	}
+	if (w <= 0 || h <= 0)
+	{
+		dstrect->w = dstrect->h = 0;
+		return 0;
+	}
+	dstrect->w = w;
+	dstrect->h = h;
 
-				int j = 0;
-				do
-				{
-					if (dsty + j >= dst->h) break;
+	static PaletteRowFunc convert = pickPaletteRow();
+	Uint32 map[256];
+	SDL_Palette *palette = src->format->palette;
+	for (int i = 0; i < 256; ++i)
+	{
+		map[i] = i < palette->ncolors ? SDL_MapRGB(dst->format, palette->colors[i].r, palette->colors[i].g, palette->colors[i].b) : 0;
+	}
+	int key = (src->flags & SDL_SRCCOLORKEY) ? (int)src->format->colorkey : -1;
 
-					*(pixelDst + (dst->pitch/sizeof(Uint32))*j) = dataDst;
-				} while (say[dsty + ++j] == 0); // fill in all relevant rows
-				
-				dataSrc >>= 16;
-				pixelDst++; // forward 4 bytes!
-			}
-		}
+	if (SDL_MUSTLOCK(src) && SDL_LockSurface(src) < 0)
+	{
+		return -1;
 	}
-	
+	if (SDL_MUSTLOCK(dst) && SDL_LockSurface(dst) < 0)
+	{
+		if (SDL_MUSTLOCK(src)) SDL_UnlockSurface(src);
+		return -1;
+	}
+	Uint8 *srcRow = (Uint8*)src->pixels + srcy * src->pitch + srcx;
+	Uint8 *dstRow = (Uint8*)dst->pixels + dstrect->y * dst->pitch + dstrect->x * 4;
+	for (int y = 0; y < h; ++y, srcRow += src->pitch, dstRow += dst->pitch)
+	{
+		convert(srcRow, (Uint32*)dstRow, w, map, key);
+	}
+	if (SDL_MUSTLOCK(dst)) SDL_UnlockSurface(dst);
+	if (SDL_MUSTLOCK(src)) SDL_UnlockSurface(src);
 	return 0;
 }
+
+/**
+ * Filters the software zoomer can pick, depending on
+ * the options and the source/destination sizes.
  */
+enum ZoomFilter { ZOOM_NEAREST, ZOOM_XBRZ, ZOOM_HQX, ZOOM_SCALE };
 
+/**
+ * Parameters shared by all the stripes of a scaling job.
+ */
+struct StripeJob
+{
+	ZoomFilter filter;
+	int factor;
+	SDL_Surface *src, *dst;
+	int yFirst, yLast, rowsPerStripe;
+};
 
 /**
- * Optimized 8-bit zoomer for resizing by a factor of 2. Doesn't flip.
- * 32-bit version.
- * Used internally by _zoomSurfaceY() below.
- * source and dest. widths must be multiples of 4 bytes for 32-bit access
+ * Minimum number of source rows per stripe, so the threads
+ * aren't swamped by the overhead of tiny stripes.
+ */
+const int MIN_STRIPE_ROWS = 16;
+
+/**
+ * Number of source rows around a changed row that the
+ * smoothing filters look at. Rezooming a band of rows must
+ * also redo this many rows above and below it.
+ */
+const int FILTER_ROW_MARGIN = 2;
+
+/**
+ * Picks the filter _zoomSurfaceY() uses for a given pair of surfaces.
  *
  * @param src The surface to zoom (input).
  * @param dst The zoomed surface (output).
- * @return 0 for success or -1 for error.
+ * @param factor Returns the scaling factor of the filter.
+ * @return The filter to use.
  */
-/*
-static int zoomSurface4X_XAxis_32bit(SDL_Surface *src, SDL_Surface *dst)
+static ZoomFilter pickFilter(SDL_Surface *src, SDL_Surface *dst, int &factor)
 {
-	Uint32 dataSrc;
-	Uint32 dataDst;
-	Uint8 *pixelSrc;
-	Uint8 *pixelDstRow = (Uint8*)dst->pixels;
-	Uint8 *pixelSrcRow = (Uint8*)src->pixels;
-	int sx;
-	int dsty;
-	static bool proclaimed = false;
-
-	static Uint32 *say = 0;
-	Uint32 *csay;
-	int csy;
-	
-	if (!proclaimed)
+	if (Screen::is32bitEnabled())
 	{
-		proclaimed = true;
-		Log(LOG_INFO) << "Using mediocre scaling routine due to screen height.";
-	}
-	
-	if ((say = (Uint32 *) realloc(say, (dst->h + 1) * sizeof(Uint32))) == NULL) {
-		say = 0;
-		return (-1);
-	}
-	
-	csy = 0;
-	csay = say;
-	for (int y = 0; y < dst->h; y++) {
-		csy += src->h;
-		*csay = 0;
-		while (csy >= dst->h) {
-			csy -= dst->h;
-			(*csay)++;
+		if (Options::useXBRZFilter)
+		{
+			// check the resolution to see which scale we need
+			for (factor = 2; factor <= 5; factor++)
+			{
+				if (dst->w == src->w * factor && dst->h == src->h * factor)
+				{
+					return ZOOM_XBRZ;
+				}
+			}
 		}
-		(*csay) *= src->pitch;
-		csay++;
-	}
-
-	for (dsty = 0; dsty < dst->h; ++dsty, pixelDstRow += dst->pitch)
-	{
-		if (!say[dsty]) continue;
-
-		Uint32 *pixelDst = (Uint32*)pixelDstRow;
-		pixelSrc = pixelSrcRow;
-		pixelSrcRow += say[dsty];
 
-		for (sx = 0; sx < src->w; sx += 4, pixelSrc += 4)
+		if (Options::useHQXFilter)
 		{
-			dataSrc = *((Uint32*) pixelSrc);
-			// boo
-			dataSrc = SDL_SwapLE32(dataSrc);
-			
-			for (int i = 0; i < 4; ++i)
+			for (factor = 2; factor <= 4; factor++)
 			{
-				dataDst = SDL_SwapLE32( (dataSrc & 0xFF) | ((dataSrc & 0xFF) << 8) | 
-					((dataSrc & 0xFF) << 16) | ((dataSrc & 0xFF ) << 24) ); 
-			
-				int j = 0;
-				do
+				if (dst->w == src->w * factor && dst->h == src->h * factor)
 				{
-					if (dsty + j >= dst->h) break;
+					return ZOOM_HQX;
+				}
+			}
+		}
+	}
 
-					*(pixelDst + (dst->pitch/sizeof(Uint32))*j) = dataDst;
-				} while (say[dsty + ++j] == 0); // fill in all relevant rows
-				
-				dataSrc >>= 8;
-				pixelDst++; // forward 4 bytes!
+	if (Options::useScaleFilter)
+	{
+		// check the resolution to see which of scale2x, scale3x, etc. we need
+		for (factor = 2; factor <= 4; factor++)
+		{
+			if (dst->w == src->w * factor && dst->h == src->h * factor && !scale_precondition(factor, src->format->BytesPerPixel, src->w, src->h))
+			{
+				return ZOOM_SCALE;
 			}
 		}
 	}
-	
-	return 0;
+
+	factor = 0;
+	return ZOOM_NEAREST;
 }
- */
 
-#ifdef __SSE2__
 /**
- * Optimized 8-bit zoomer for resizing by a factor of 4. Doesn't flip.
- * Used internally by _zoomSurfaceY() below.
- * This is an SSE2 version written with Intel intrinsics.
- * source and dest. widths must be multiples of 16 bytes for 128-bit access
- * and it would help if they were aligned properly... :(
+ * Scales one horizontal stripe of the source surface.
+ * Both xBRZ and HQX read the neighbouring rows outside
+ * the stripe straight from the full source image, so
+ * stripes stitch together exactly like a single pass.
+ * Used internally by scaleStriped() below.
  *
- * @param src The surface to zoom (input).
- * @param dst The zoomed surface (output).
- * @return 0 for success or -1 for error.
+ * @param data The StripeJob to run.
+ * @param task Index of the stripe to scale.
  */
-/*
-static int zoomSurface4X_SSE2(SDL_Surface *src, SDL_Surface *dst)
+static void scaleStripe(void *data, int task)
 {
-	__m128i dataSrc;
-	__m128i dataDst;
-	Uint8 *pixelSrc = (Uint8*)src->pixels;
-	Uint8 *pixelDstRow = (Uint8*)dst->pixels;
-	int sx, sy;
-	static bool proclaimed = false;
+	StripeJob *job = (StripeJob*)data;
+	SDL_Surface *src = job->src, *dst = job->dst;
+	int yFirst = job->yFirst + task * job->rowsPerStripe;
+	int yLast = std::min(yFirst + job->rowsPerStripe, job->yLast);
 
-	if (!proclaimed)
+	if (job->filter == ZOOM_XBRZ)
 	{
-		proclaimed = true;
-		Log(LOG_INFO) << "Using SSE2 4X zoom routine.";
+		xbrz::scale(job->factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h, xbrz::ScalerCfg(), yFirst, yLast);
 	}
-
-	for (sy = 0; sy < src->h; ++sy, pixelDstRow += dst->pitch*4)
+	else if (job->factor == 2)
 	{
-		__m128i *pixelDst =  (__m128i*)pixelDstRow;
-		__m128i *pixelDst2 = (__m128i*)((Uint8*)pixelDstRow + dst->pitch);
-		__m128i *pixelDst3 = (__m128i*)((Uint8*)pixelDstRow + dst->pitch*2);
-		__m128i *pixelDst4 = (__m128i*)((Uint8*)pixelDstRow + dst->pitch*3);
-		for (sx = 0; sx < src->w; sx += 16, pixelSrc += 16)
-		{
-			dataSrc = *((__m128i*) pixelSrc);
-
-			__m128i halfDone = _mm_unpacklo_epi8(dataSrc, dataSrc); 
-			dataDst = _mm_unpacklo_epi8(halfDone, halfDone);
- */
-/* #define WRITE_DST if ((char*)pixelDst4 + 128 > (char*)dst->pixels+(dst->w*dst->pitch)) { Log(LOG_ERROR) << "HELL"; exit(0); } \ */
-#define WRITE_DST			*(pixelDst++) = dataDst; \
-			*(pixelDst2++) = dataDst; \
-			*(pixelDst3++) = dataDst; \
-			*(pixelDst4++) = dataDst; \
-			
-/*
-			WRITE_DST;
-			
-			dataDst = _mm_unpackhi_epi8(halfDone, halfDone);
-			
-			WRITE_DST;
-			
-			halfDone = _mm_unpackhi_epi8(dataSrc, dataSrc);
-			dataDst = _mm_unpacklo_epi8(halfDone, halfDone);
-			
-			WRITE_DST;
-			
-			dataDst = _mm_unpackhi_epi8(halfDone, halfDone);
-			
-			WRITE_DST;
-		}	
+		hq2x_32_rb_slice((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, yFirst, yLast);
+	}
+	else if (job->factor == 3)
+	{
+		hq3x_32_rb_slice((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, yFirst, yLast);
+	}
+	else if (job->factor == 4)
+	{
+		hq4x_32_rb_slice((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, yFirst, yLast);
 	}
-
-	return 0;
 }
- */
 
 /**
- * Optimized 8-bit zoomer for resizing by a factor of 2. Doesn't flip.
+ * Splits a 32-bit xBRZ or HQX scale of the source rows
+ * [yFirst, yLast) into horizontal stripes and runs them on
+ * the engine's shared thread pool.
  * Used internally by _zoomSurfaceY() below.
- * This is an SSE2 version written with Intel intrinsics.
- * source and dest. widths must be multiples of 16 bytes for 128-bit access
- * and it would help if they were aligned properly... :(
  *
+ * @param filter The filter to use.
+ * @param factor The scaling factor.
  * @param src The surface to zoom (input).
  * @param dst The zoomed surface (output).
- * @return 0 for success or -1 for error.
+ * @param yFirst First source row to scale.
+ * @param yLast Source row past the last one to scale.
  */
-/*
-static int zoomSurface2X_SSE2(SDL_Surface *src, SDL_Surface *dst)
+static void scaleStriped(ZoomFilter filter, int factor, SDL_Surface *src, SDL_Surface *dst, int yFirst, int yLast)
 {
-	__m128i dataSrc;
-	__m128i dataDst;
-	Uint8 *pixelSrc = (Uint8*)src->pixels;
-	Uint8 *pixelDstRow = (Uint8*)dst->pixels;
-	int sx, sy;
-	static bool proclaimed = false;
-	
-	if (!proclaimed)
-	{
-		proclaimed = true;
-		Log(LOG_INFO) << "Using SSE2 2X zoom routine.";
-	}
-
-	for (sy = 0; sy < src->h; ++sy, pixelDstRow += dst->pitch*2)
+	ThreadPool *pool = ThreadPool::getShared();
+	if (filter == ZOOM_HQX)
 	{
-		__m128i *pixelDst =  (__m128i*)pixelDstRow;
-		__m128i *pixelDst2 = (__m128i*)((Uint8*)pixelDstRow + dst->pitch);
+		static bool initDone = false;
 
-		for (sx = 0; sx < src->w; sx += 16, pixelSrc += 16)
+		if (!initDone)
 		{
-			dataSrc = *((__m128i*) pixelSrc);
-
-			dataDst = _mm_unpacklo_epi8(dataSrc, dataSrc); 
-
-#undef WRITE_DST
-#define WRITE_DST			*(pixelDst++) = dataDst; \
-			*(pixelDst2++) = dataDst; \
-			
-			WRITE_DST;
-			
-			dataDst = _mm_unpackhi_epi8(dataSrc, dataSrc);
-			
-			WRITE_DST;
+			hqxInit();
+			initDone = true;
 		}
 	}
-	
-	return 0;
+
+	int stripes = std::max(1, std::min(pool->getThreadCount(), (yLast - yFirst) / MIN_STRIPE_ROWS));
+	StripeJob job;
+	job.filter = filter;
+	job.factor = factor;
+	job.src = src;
+	job.dst = dst;
+	job.yFirst = yFirst;
+	job.yLast = yLast;
+	job.rowsPerStripe = (yLast - yFirst + stripes - 1) / stripes;
+	pool->run(scaleStripe, &job, stripes);
 }
- */
 
 /**
- * Checks the SSE2 feature bit returned by the CPUID instruction
- * @return Does the CPU support SSE2?
+ * Copies a band of rows from one surface onto another at an offset.
+ * 8-bit surfaces are copied raw, so the result doesn't depend on
+ * the palette of the intermediate surface.
+ *
+ * @param src The surface to copy from.
+ * @param dst The surface to copy to.
+ * @param yFirst First row to copy.
+ * @param yLast Row past the last one to copy.
+ * @param x Horizontal offset in the destination.
+ * @param y Vertical offset in the destination.
  */
-bool Zoom::haveSSE2()
+static void copyRows(SDL_Surface *src, SDL_Surface *dst, int yFirst, int yLast, int x, int y)
 {
-#ifdef __GNUC__
-	unsigned int CPUInfo[4] = {0, 0, 0, 0};
-	__get_cpuid(1, CPUInfo, CPUInfo+1, CPUInfo+2, CPUInfo+3);
-#elif _WIN32
-	int CPUInfo[4];
-	__cpuid(CPUInfo, 1);
-#else
-	unsigned int CPUInfo[4] = {0, 0, 0, 0};
-#endif
-
-	return (CPUInfo[3] & 0x04000000) ? true : false;
+	if (src->format->BitsPerPixel == 8 && dst->format->BitsPerPixel == 8)
+	{
+		Uint8 *srcRow = (Uint8*)src->pixels + yFirst * src->pitch;
+		Uint8 *dstRow = (Uint8*)dst->pixels + (y + yFirst) * dst->pitch + x;
+		for (int row = yFirst; row < yLast; ++row, srcRow += src->pitch, dstRow += dst->pitch)
+		{
+			memcpy(dstRow, srcRow, src->w);
+		}
+	}
+	else
+	{
+		SDL_Rect srcrect = {0, (Sint16)yFirst, (Uint16)src->w, (Uint16)(yLast - yFirst)};
+		SDL_Rect dstrect = {(Sint16)x, (Sint16)(y + yFirst), (Uint16)src->w, (Uint16)(yLast - yFirst)};
+		Zoom::blitPalette(src, &srcrect, dst, &dstrect);
+	}
 }
 
-#endif
-
 /**
  * Wrapper around various software and OpenGL screen buffer pushing functions which zoom.
  * Basically called just from Screen::flip()
@@ -658,42 +782,119 @@ bool Zoom::haveSSE2()
  * @param leftBlackBand Size of left black band in pixels (letterboxing).
  * @param rightBlackBand Size of right black band in pixels (letterboxing).
  * @param glOut OpenGL output.
+ * @param buffer Intermediate surface the size of the letterboxed area, used when zooming between black bands.
  */
-void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut)
+void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut, SDL_Surface *buffer)
 {
 	if (Screen::isOpenGLEnabled())
 	{
 #ifndef __NO_OPENGL
 		if (glOut->buffer_surface)
 		{
-			SDL_BlitSurface(src, 0, glOut->buffer_surface->getSurface(), 0); // TODO; this is less than ideal...
+			blitPalette(src, 0, glOut->buffer_surface->getSurface(), 0); // TODO; this is less than ideal...
 
 			glOut->refresh(glOut->linear, glOut->iwidth, glOut->iheight, dst->w, dst->h, topBlackBand, bottomBlackBand, leftBlackBand, rightBlackBand);
 			SDL_GL_SwapBuffers();
 		}
 #endif
 	}
-	else if (topBlackBand <= 0 && bottomBlackBand <= 0 && leftBlackBand <= 0 && rightBlackBand <= 0)
+	else
 	{
-		_zoomSurfaceY(src, dst, 0, 0);
+		int yFirst = 0, yLast = src->h;
+		flipRowsWithZoom(src, dst, topBlackBand, bottomBlackBand, leftBlackBand, rightBlackBand, buffer, yFirst, yLast);
+	}
+}
+
+/**
+ * Software-only version of flipWithZoom() that only pushes
+ * a band of changed rows of the source surface. Smoothing
+ * filters also redo the rows around the band that depend on it.
+ *
+ * @param src The surface to zoom (input).
+ * @param dst The zoomed surface (output).
+ * @param topBlackBand Size of top black band in pixels (letterboxing).
+ * @param bottomBlackBand Size of bottom black band in pixels (letterboxing).
+ * @param leftBlackBand Size of left black band in pixels (letterboxing).
+ * @param rightBlackBand Size of right black band in pixels (letterboxing).
+ * @param buffer Intermediate surface the size of the letterboxed area, used when zooming between black bands.
+ * @param yFirst First source row to push, returns the first destination row that was updated.
+ * @param yLast Source row past the last one to push, returns the destination row past the last one that was updated.
+ * @return True if only the requested band was pushed, False if the whole surface had to be.
+ */
+bool Zoom::flipRowsWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, SDL_Surface *buffer, int &yFirst, int &yLast)
+{
+	bool partial = true;
+	if (topBlackBand <= 0 && bottomBlackBand <= 0 && leftBlackBand <= 0 && rightBlackBand <= 0)
+	{
+		if (dst->w == src->w && dst->h == src->h)
+		{
+			copyRows(src, dst, yFirst, yLast, 0, 0);
+		}
+		else
+		{
+			partial = _zoomSurfaceRows(src, dst, yFirst, yLast);
+		}
 	}
 	else if (dst->w - leftBlackBand - rightBlackBand == src->w && dst->h - topBlackBand - bottomBlackBand == src->h)
 	{
-		SDL_Rect dstrect = {(Sint16)leftBlackBand, (Sint16)topBlackBand, (Uint16)src->w, (Uint16)src->h};
-		SDL_BlitSurface(src, NULL, dst, &dstrect);
+		copyRows(src, dst, yFirst, yLast, leftBlackBand, topBlackBand);
+		yFirst += topBlackBand;
+		yLast += topBlackBand;
 	}
 	else
 	{
-		SDL_Surface *tmp = SDL_CreateRGBSurface(dst->flags, dst->w - leftBlackBand - rightBlackBand, dst->h - topBlackBand - bottomBlackBand, dst->format->BitsPerPixel, 0, 0, 0, 0);
-		_zoomSurfaceY(src, tmp, 0, 0);
-		if (src->format->palette != NULL)
-		{
-			SDL_SetPalette(tmp, SDL_LOGPAL|SDL_PHYSPAL, src->format->palette->colors, 0, src->format->palette->ncolors);
-		}
-		SDL_Rect dstrect = {(Sint16)leftBlackBand, (Sint16)topBlackBand, (Uint16)tmp->w, (Uint16)tmp->h};
-		SDL_BlitSurface(tmp, NULL, dst, &dstrect);
-		SDL_FreeSurface(tmp);
+		partial = _zoomSurfaceRows(src, buffer, yFirst, yLast);
+		copyRows(buffer, dst, yFirst, yLast, leftBlackBand, topBlackBand);
+		yFirst += topBlackBand;
+		yLast += topBlackBand;
+	}
+	return partial;
+}
+
+/**
+ * Zooms only the source rows [yFirst, yLast) onto the matching
+ * destination rows, leaving the rest of the destination alone.
+ * Falls back to zooming the whole surface if the vertical
+ * factor isn't a whole number or the filter can't do bands.
+ *
+ * @param src The surface to zoom (input).
+ * @param dst The zoomed surface (output).
+ * @param yFirst First source row to zoom, returns the first destination row that was updated.
+ * @param yLast Source row past the last one to zoom, returns the destination row past the last one that was updated.
+ * @return True if only the requested band was zoomed, False if the whole surface had to be.
+ */
+bool Zoom::_zoomSurfaceRows(SDL_Surface *src, SDL_Surface *dst, int &yFirst, int &yLast)
+{
+	int factor = 0;
+	ZoomFilter filter = pickFilter(src, dst, factor);
+	int factorY = dst->h / src->h;
+
+	if (filter == ZOOM_XBRZ || filter == ZOOM_HQX)
+	{
+		yFirst = std::max(0, yFirst - FILTER_ROW_MARGIN);
+		yLast = std::min(src->h, yLast + FILTER_ROW_MARGIN);
+		scaleStriped(filter, factor, src, dst, yFirst, yLast);
 	}
+	else if (filter == ZOOM_NEAREST && dst->h == src->h * factorY)
+	{
+		// the rows map one-to-many, so zoom a slice of each surface on its own
+		SDL_Surface srcRows = *src, dstRows = *dst;
+		srcRows.pixels = (Uint8*)src->pixels + yFirst * src->pitch;
+		srcRows.h = yLast - yFirst;
+		dstRows.pixels = (Uint8*)dst->pixels + yFirst * factorY * dst->pitch;
+		dstRows.h = (yLast - yFirst) * factorY;
+		_zoomSurfaceY(&srcRows, &dstRows, 0, 0);
+	}
+	else
+	{
+		_zoomSurfaceY(src, dst, 0, 0);
+		yFirst = 0;
+		yLast = dst->h;
+		return false;
+	}
+	yFirst *= factorY;
+	yLast *= factorY;
+	return true;
 }
 
 
@@ -721,119 +922,34 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 	int dgap;
 	static bool proclaimed = false;
 
-	if (Screen::is32bitEnabled())
+	int factor = 0;
+	ZoomFilter filter = pickFilter(src, dst, factor);
+	switch (filter)
 	{
-		if (Options::useXBRZFilter)
-		{
-			// check the resolution to see which scale we need
-			for (size_t factor = 2; factor <= 5; factor++)
-			{
-				if (dst->w == src->w * (int)factor && dst->h == src->h * (int)factor)
-				{
-					xbrz::scale(factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h);
-					return 0;
-				}
-			}
-		}
-
-		if (Options::useHQXFilter)
-		{
-			static bool initDone = false;
-
-			if (!initDone)
-			{
-				hqxInit();
-				initDone = true;
-			}
-
-			// HQX_API void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
-
-			if (dst->w == src->w * 2 && dst->h == src->h * 2)
-			{
-				hq2x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
-				return 0;
-			}
-
-			if (dst->w == src->w * 3 && dst->h == src->h * 3)
-			{
-				hq3x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
-				return 0;
-			}
-
-			if (dst->w == src->w * 4 && dst->h == src->h * 4)
-			{
-				hq4x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
-				return 0;
-			}
-		}
-	}
-
-	if (Options::useScaleFilter)
-	{
-		// check the resolution to see which of scale2x, scale3x, etc. we need
-		for (size_t factor = 2; factor <= 4; factor++)
-		{
-			if (dst->w == src->w * (int)factor && dst->h == src->h * (int)factor && !scale_precondition(factor, src->format->BytesPerPixel, src->w, src->h))
-			{
-				scale(factor, dst->pixels, dst->pitch, src->pixels, src->pitch, src->format->BytesPerPixel, src->w, src->h);
-				return 0;
-			}
-		}
+	case ZOOM_XBRZ:
+	case ZOOM_HQX:
+		scaleStriped(filter, factor, src, dst, 0, src->h);
+		return 0;
+	case ZOOM_SCALE:
+		scale(factor, dst->pixels, dst->pitch, src->pixels, src->pitch, src->format->BytesPerPixel, src->w, src->h);
+		return 0;
+	default:
+		break;
 	}
 
-	// if we're scaling by a factor of 2 or 4, try to use a more efficient function	
-	/*
-	if (src->format->BytesPerPixel == 1 && dst->format->BytesPerPixel == 1)
-	{
-
-#ifdef __SSE2__
-		static bool _haveSSE2 = haveSSE2();
-
-		if (_haveSSE2 &&
-			!((ptrdiff_t)src->pixels % 16) && 
-			!((ptrdiff_t)dst->pixels % 16)) // alignment check
-		{
-			if (dst->w == src->w * 2 && dst->h == src->h * 2) return  zoomSurface2X_SSE2(src, dst);
-			else if (dst->w == src->w * 4 && dst->h == src->h * 4) return  zoomSurface4X_SSE2(src, dst);
-		} else
-		{
-			static bool complained = false;
-
-			if (!complained)
-			{
-				complained = true;
-				Log(LOG_ERROR) << "Misaligned surface buffers.";
-			}
-		}
-#endif
-
-// __WORDSIZE is defined on Linux, SIZE_MAX on Windows
-#if defined(__WORDSIZE) && (__WORDSIZE == 64) || defined(SIZE_MAX) && (SIZE_MAX > 0xFFFFFFFF)
-		if (dst->w == src->w * 2 && dst->h == src->h * 2) return  zoomSurface2X_64bit(src, dst);
-		else if (dst->w == src->w * 4 && dst->h == src->h * 4) return  zoomSurface4X_64bit(src, dst);
-#else
-		if (sizeof(void *) == 8)
-		{
-			if (dst->w == src->w * 2 && dst->h == src->h * 2) return  zoomSurface2X_64bit(src, dst);
-			else if (dst->w == src->w * 4 && dst->h == src->h * 4) return  zoomSurface4X_64bit(src, dst);
-		}
-		else
-		{
-			if (dst->w == src->w * 2 && dst->h == src->h * 2) return  zoomSurface2X_32bit(src, dst);
-			else if (dst->w == src->w * 4 && dst->h == src->h * 4) return  zoomSurface4X_32bit(src, dst);
-		}
-#endif
-
-		// maybe X is scaled by 2 or 4 but not Y?
-		if (dst->w == src->w * 4) return zoomSurface4X_XAxis_32bit(src, dst);
-		else if (dst->w == src->w * 2) return zoomSurface2X_XAxis_32bit(src, dst);
-	}
-	*/
 	if (!proclaimed)
 	{
 		Log(LOG_INFO) << "Using software scaling routine. For best results, try an OpenGL filter.";
 		proclaimed = true;
 	}
+
+	// whole factors have their own optimized zoomer
+	if ((src->format->BytesPerPixel == 1 || src->format->BytesPerPixel == 4) &&
+		src->format->BytesPerPixel == dst->format->BytesPerPixel &&
+		!flipx && !flipy && dst->w % src->w == 0 && dst->h % src->h == 0)
+	{
+		return zoomSurfaceInteger(src, dst);
+	}
 	
 	/*
 	* Allocate memory for row increments
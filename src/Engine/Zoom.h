@@ -31,11 +31,19 @@ class Zoom
 
 	public:
 	/// Flip screen given src and dst; might use software or OpenGL.
-	static void flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut);
+	static void flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut, SDL_Surface *buffer);
+	/// Flip a band of rows of src to dst in software, returning the dst rows that changed.
+	static bool flipRowsWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, SDL_Surface *buffer, int &yFirst, int &yLast);
+	/// Copy a band of rows of src to dst, resizing as needed.
+	static bool _zoomSurfaceRows(SDL_Surface *src, SDL_Surface *dst, int &yFirst, int &yLast);
 	/// Copy src to dst, resizing as needed. Please don't use flipx or flipy as the optimized functions ignore these parameters.
 	static int _zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy);
 	/// Check for SSE2 instructions using CPUID.
 	static bool haveSSE2();
+	/// Check for AVX2 instructions using CPUID.
+	static bool haveAVX2();
+	/// Blit an 8bpp surface onto a 32bpp one, like SDL_BlitSurface but faster.
+	static int blitPalette(SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect);
 
 private:
 
@@ -88,21 +88,20 @@ void ConfirmCydoniaState::btnYesClick(Action *)
 
 	SavedBattleGame *bgame = new SavedBattleGame();
 	_game->getSavedGame()->setBattleGame(bgame);
-	BattlescapeGenerator bgen = BattlescapeGenerator(_game);
+	BattlescapeGenerator *bgen = new BattlescapeGenerator(_game);
 	for (std::vector<std::string>::const_iterator i = _game->getMod()->getDeploymentsList().begin(); i != _game->getMod()->getDeploymentsList().end(); ++i)
 	{
 		AlienDeployment *deployment = _game->getMod()->getDeployment(*i);
 		if (deployment->isFinalDestination())
 		{
 			bgame->setMissionType(*i);
-			bgen.setAlienRace(deployment->getRace());
+			bgen->setAlienRace(deployment->getRace());
 			break;
 		}
 	}
-	bgen.setCraft(_craft);
-	bgen.run();
+	bgen->setCraft(_craft);
 
-	_game->pushState(new BriefingState(_craft));
+	_game->pushState(new BriefingState(_craft, 0, bgen));
 
 }
 
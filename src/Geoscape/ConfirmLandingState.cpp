@@ -127,38 +127,38 @@ void ConfirmLandingState::btnYesClick(Action *)
 
 	SavedBattleGame *bgame = new SavedBattleGame();
 	_game->getSavedGame()->setBattleGame(bgame);
-	BattlescapeGenerator bgen(_game);
-	bgen.setWorldTexture(_texture);
-	bgen.setWorldShade(_shade);
-	bgen.setCraft(_craft);
+	BattlescapeGenerator *bgen = new BattlescapeGenerator(_game);
+	bgen->setWorldTexture(_texture);
+	bgen->setWorldShade(_shade);
+	bgen->setCraft(_craft);
 	if (u != 0)
 	{
 		if (u->getStatus() == Ufo::CRASHED)
 			bgame->setMissionType("STR_UFO_CRASH_RECOVERY");
 		else
 			bgame->setMissionType("STR_UFO_GROUND_ASSAULT");
-		bgen.setUfo(u);
-		bgen.setAlienRace(u->getAlienRace());
+		bgen->setUfo(u);
+		bgen->setAlienRace(u->getAlienRace());
 	}
 	else if (m != 0)
 	{
 		bgame->setMissionType(m->getDeployment()->getType());
-		bgen.setMissionSite(m);
-		bgen.setAlienRace(m->getAlienRace());
+		bgen->setMissionSite(m);
+		bgen->setAlienRace(m->getAlienRace());
 	}
 	else if (b != 0)
 	{
 		bgame->setMissionType("STR_ALIEN_BASE_ASSAULT");
-		bgen.setAlienBase(b);
-		bgen.setAlienRace(b->getAlienRace());
-		bgen.setWorldTexture(0);
+		bgen->setAlienBase(b);
+		bgen->setAlienRace(b->getAlienRace());
+		bgen->setWorldTexture(0);
 	}
 	else
 	{
+		delete bgen;
 		throw Exception("No mission available!");
 	}
-	bgen.run();
-	_game->pushState(new BriefingState(_craft));
+	_game->pushState(new BriefingState(_craft, 0, bgen));
 }
 
 /**
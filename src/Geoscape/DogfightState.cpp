@@ -306,25 +306,30 @@ DogfightState::DogfightState(GeoscapeState *state, Craft *craft, Ufo *ufo) : _st
 	graphic = _game->getMod()->getSurface("INTERWIN.DAT");
 	graphic->setX(0);
 	graphic->setY(0);
-	graphic->getCrop()->x = 0;
-	graphic->getCrop()->y = 0;
-	graphic->getCrop()->w = _window->getWidth();
-	graphic->getCrop()->h = _window->getHeight();
-	_window->drawRect(graphic->getCrop(), 15);
+	SDL_Rect crop;
+	crop.x = 0;
+	crop.y = 0;
+	crop.w = _window->getWidth();
+	crop.h = _window->getHeight();
+	graphic->setCrop(crop);
+	_window->drawRect(&crop, 15);
 	graphic->blit(_window);
 
-	_preview->drawRect(graphic->getCrop(), 15);
-	graphic->getCrop()->y = dogfightInterface->getElement("previewTop")->y;
-	graphic->getCrop()->h = dogfightInterface->getElement("previewTop")->h;
+	_preview->drawRect(&crop, 15);
+	crop.y = dogfightInterface->getElement("previewTop")->y;
+	crop.h = dogfightInterface->getElement("previewTop")->h;
+	graphic->setCrop(crop);
 	graphic->blit(_preview);
 	graphic->setY(_window->getHeight() - dogfightInterface->getElement("previewBot")->h);
-	graphic->getCrop()->y = dogfightInterface->getElement("previewBot")->y;
-	graphic->getCrop()->h = dogfightInterface->getElement("previewBot")->h;
+	crop.y = dogfightInterface->getElement("previewBot")->y;
+	crop.h = dogfightInterface->getElement("previewBot")->h;
+	graphic->setCrop(crop);
 	graphic->blit(_preview);
 	if (ufo->getRules()->getModSprite().empty())
 	{
-		graphic->getCrop()->y = dogfightInterface->getElement("previewMid")->y + dogfightInterface->getElement("previewMid")->h * _ufo->getRules()->getSprite();
-		graphic->getCrop()->h = dogfightInterface->getElement("previewMid")->h;
+		crop.y = dogfightInterface->getElement("previewMid")->y + dogfightInterface->getElement("previewMid")->h * _ufo->getRules()->getSprite();
+		crop.h = dogfightInterface->getElement("previewMid")->h;
+		graphic->setCrop(crop);
 	}
 	else
 	{
@@ -107,6 +107,7 @@
 #include "../Savegame/CraftWeapon.h"
 #include "../Mod/RuleCraftWeapon.h"
 #include "../Mod/RuleInterface.h"
+#include "SphereGrid.h"
 
 namespace OpenXcom
 {
@@ -115,7 +116,7 @@ namespace OpenXcom
  * Initializes all the elements in the Geoscape screen.
  * @param game Pointer to the core game.
  */
-GeoscapeState::GeoscapeState() : _pause(false), _zoomInEffectDone(false), _zoomOutEffectDone(false), _minimizedDogfights(0)
+GeoscapeState::GeoscapeState() : _pause(false), _zoomInEffectDone(false), _zoomOutEffectDone(false), _minimizedDogfights(0), _rangeGrid(new SphereGrid(36, 72))
 {
 	int screenWidth = Options::baseXGeoscape;
 	int screenHeight = Options::baseYGeoscape;
@@ -391,6 +392,7 @@ GeoscapeState::GeoscapeState() : _pause(false), _zoomInEffectDone(false), _zoomO
  */
 GeoscapeState::~GeoscapeState()
 {
+	delete _rangeGrid;
 	delete _gameTimer;
 	delete _zoomInEffectTimer;
 	delete _zoomOutEffectTimer;
@@ -422,6 +424,22 @@ void GeoscapeState::blit()
 	}
 }
 
+/**
+ * Gets the changed area of the geoscape, including
+ * any dogfights going on.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool GeoscapeState::getDamage(SDL_Rect &rect)
+{
+	bool damaged = State::getDamage(rect);
+	for (std::list<DogfightState*>::iterator it = _dogfights.begin(); it != _dogfights.end(); ++it)
+	{
+		damaged = (*it)->getDamage(rect) || damaged;
+	}
+	return damaged;
+}
+
 /**
  * Handle key shortcuts.
  * @param action Pointer to an action.
@@ -654,10 +672,31 @@ void GeoscapeState::timeAdvance()
 		timeSpan = 12 * 5 * 6 * 2 * 24;
 	}
 
+	// steps where nothing moves only count down the landed UFOs,
+	// so those are skipped and the countdown caught up in one go
+	int idleSteps = 0, skippedSteps = 0;
 	for (int i = 0; i < timeSpan && !_pause; ++i)
 	{
 		TimeTrigger trigger;
 		trigger = _game->getSavedGame()->getTime()->advance();
+		if (trigger == TIME_5SEC)
+		{
+			if (idleSteps == 0)
+			{
+				passIdleSteps(skippedSteps);
+				skippedSteps = 0;
+				idleSteps = getIdleSteps();
+			}
+			if (idleSteps > 0)
+			{
+				--idleSteps;
+				++skippedSteps;
+				continue;
+			}
+		}
+		passIdleSteps(skippedSteps);
+		skippedSteps = 0;
+		idleSteps = 0;
 		switch (trigger)
 		{
 		case TIME_1MONTH:
@@ -674,6 +713,7 @@ void GeoscapeState::timeAdvance()
 			time5Seconds();
 		}
 	}
+	passIdleSteps(skippedSteps);
 
 	_pause = !_dogfightsToBeStarted.empty();
 
@@ -681,6 +721,67 @@ void GeoscapeState::timeAdvance()
 	_globe->draw();
 }
 
+/**
+ * Works out how many of the upcoming 5 second steps would do nothing
+ * but count down the landed UFOs, because nothing is flying, crashed
+ * UFOs are already detected and no UFO is about to lift off.
+ * @return Number of steps, 0 if the next one needs to run.
+ */
+int GeoscapeState::getIdleSteps() const
+{
+	SavedGame *save = _game->getSavedGame();
+	if (save->getBases()->empty() || !save->getWaypoints()->empty() || !_dogfights.empty() || !_dogfightsToBeStarted.empty())
+	{
+		return 0;
+	}
+	int steps = 12 * 5 * 6 * 2 * 24;
+	for (std::vector<Ufo*>::const_iterator i = save->getUfos()->begin(); i != save->getUfos()->end(); ++i)
+	{
+		switch ((*i)->getStatus())
+		{
+		case Ufo::LANDED:
+			// the step that reaches 0 lifts off
+			steps = std::min(steps, (int)((*i)->getSecondsRemaining() / 5) - 1);
+			break;
+		case Ufo::CRASHED:
+			if (!(*i)->getDetected() || (*i)->getSecondsRemaining() == 0)
+				return 0;
+			break;
+		default:
+			return 0;
+		}
+	}
+	for (std::vector<Base*>::const_iterator i = save->getBases()->begin(); i != save->getBases()->end(); ++i)
+	{
+		for (std::vector<Craft*>::const_iterator j = (*i)->getCrafts()->begin(); j != (*i)->getCrafts()->end(); ++j)
+		{
+			if (!(*j)->isIdle())
+				return 0;
+		}
+	}
+	return std::max(steps, 0);
+}
+
+/**
+ * Catches up with the 5 second steps skipped by timeAdvance(),
+ * counting down the landed UFOs like time5Seconds() would have.
+ * @param steps Number of skipped steps.
+ */
+void GeoscapeState::passIdleSteps(int steps)
+{
+	if (steps == 0)
+	{
+		return;
+	}
+	for (std::vector<Ufo*>::iterator i = _game->getSavedGame()->getUfos()->begin(); i != _game->getSavedGame()->getUfos()->end(); ++i)
+	{
+		if ((*i)->getStatus() == Ufo::LANDED)
+		{
+			(*i)->setSecondsRemaining((*i)->getSecondsRemaining() - 5 * steps);
+		}
+	}
+}
+
 /**
  * Takes care of any game logic that has to
  * run every game second, like craft movement.
@@ -1052,6 +1153,28 @@ bool DetectXCOMBase::operator()(const Ufo *ufo) const
 	return RNG::percent(_base.getDetectionChance());
 }
 
+/**
+ * Checks if any UFO detects an XCOM base. Only the UFOs that might
+ * have the base in sight are tried, in the same order as the list.
+ * @param base The base.
+ * @param ufos List of UFOs.
+ * @param sight Grid of the UFOs' sight ranges.
+ * @return If the base is detected.
+ */
+static bool detectXCOMBase(const Base &base, const std::vector<Ufo*> &ufos, const SphereGrid &sight)
+{
+	DetectXCOMBase detector(base);
+	const std::vector<int> &candidates = sight.getEntries(base.getLongitude(), base.getLatitude());
+	for (std::vector<int>::const_iterator i = candidates.begin(); i != candidates.end(); ++i)
+	{
+		if (detector(ufos[*i]))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
  * Functor that marks an XCOM base for retaliation.
  * This is required because of the iterator type.
@@ -1100,14 +1223,19 @@ void GeoscapeState::time10Minutes()
 			}
 		}
 	}
+	// UFOs only look for bases within their sight range
+	_rangeGrid->clear();
+	for (std::vector<Ufo*>::iterator u = _game->getSavedGame()->getUfos()->begin(); u != _game->getSavedGame()->getUfos()->end(); ++u)
+	{
+		_rangeGrid->add(CordPolar((*u)->getLongitude(), (*u)->getLatitude()), (*u)->getRules()->getSightRange() * (1 / 60.0) * (M_PI / 180.0));
+	}
 	if (Options::aggressiveRetaliation)
 	{
 		// Detect as many bases as possible.
 		for (std::vector<Base*>::iterator iBase = _game->getSavedGame()->getBases()->begin(); iBase != _game->getSavedGame()->getBases()->end(); ++iBase)
 		{
 			// Find a UFO that detected this base, if any.
-			std::vector<Ufo*>::const_iterator uu = std::find_if (_game->getSavedGame()->getUfos()->begin(), _game->getSavedGame()->getUfos()->end(), DetectXCOMBase(**iBase));
-			if (uu != _game->getSavedGame()->getUfos()->end())
+			if (detectXCOMBase(**iBase, *_game->getSavedGame()->getUfos(), *_rangeGrid))
 			{
 				// Base found
 				(*iBase)->setRetaliationTarget(true);
@@ -1121,8 +1249,7 @@ void GeoscapeState::time10Minutes()
 		for (std::vector<Base*>::iterator iBase = _game->getSavedGame()->getBases()->begin(); iBase != _game->getSavedGame()->getBases()->end(); ++iBase)
 		{
 			// Find a UFO that detected this base, if any.
-			std::vector<Ufo*>::const_iterator uu = std::find_if (_game->getSavedGame()->getUfos()->begin(), _game->getSavedGame()->getUfos()->end(), DetectXCOMBase(**iBase));
-			if (uu != _game->getSavedGame()->getUfos()->end())
+			if (detectXCOMBase(**iBase, *_game->getSavedGame()->getUfos(), *_rangeGrid))
 			{
 				discovered[_game->getSavedGame()->locateRegion(**iBase)] = *iBase;
 			}
@@ -1284,6 +1411,24 @@ void GeoscapeState::time30Minutes()
 		}
 	}
 
+	// Radars and craft that might see each UFO get looked up on a grid,
+	// listed in the order the bases and their craft are gone through
+	std::vector< std::pair<Base*, Craft*> > detectors;
+	_rangeGrid->clear();
+	for (std::vector<Base*>::iterator b = _game->getSavedGame()->getBases()->begin(); b != _game->getSavedGame()->getBases()->end(); ++b)
+	{
+		_rangeGrid->add(CordPolar((*b)->getLongitude(), (*b)->getLatitude()), (*b)->getMaxRadarRange() * (1 / 60.0) * (M_PI / 180));
+		detectors.push_back(std::make_pair(*b, (Craft*)0));
+		for (std::vector<Craft*>::iterator c = (*b)->getCrafts()->begin(); c != (*b)->getCrafts()->end(); ++c)
+		{
+			if ((*c)->getStatus() == "STR_OUT" && (*c)->getRules()->getRadarRange() != 0)
+			{
+				_rangeGrid->add(CordPolar((*c)->getLongitude(), (*c)->getLatitude()), (*c)->getRules()->getRadarRange() * (1 / 60.0) * (M_PI / 180));
+				detectors.push_back(std::make_pair(*b, *c));
+			}
+		}
+	}
+
 	// Handle UFO detection and give aliens points
 	for (std::vector<Ufo*>::iterator u = _game->getSavedGame()->getUfos()->begin(); u != _game->getSavedGame()->getUfos()->end(); ++u)
 	{
@@ -1317,24 +1462,25 @@ void GeoscapeState::time30Minutes()
 			if (!(*u)->getDetected())
 			{
 				bool detected = false, hyperdetected = false;
-				for (std::vector<Base*>::iterator b = _game->getSavedGame()->getBases()->begin(); !hyperdetected && b != _game->getSavedGame()->getBases()->end(); ++b)
+				const std::vector<int> &candidates = _rangeGrid->getEntries((*u)->getLongitude(), (*u)->getLatitude());
+				for (std::vector<int>::const_iterator d = candidates.begin(); !hyperdetected && d != candidates.end(); ++d)
 				{
-					switch ((*b)->detect(*u))
-					{
-					case 2:	// hyper-wave decoder
-						(*u)->setHyperDetected(true);
-						hyperdetected = true;
-					case 1: // conventional radar
-						detected = true;
-					}
-					for (std::vector<Craft*>::iterator c = (*b)->getCrafts()->begin(); !detected && c != (*b)->getCrafts()->end(); ++c)
+					Craft *c = detectors[*d].second;
+					if (c == 0)
 					{
-						if ((*c)->getStatus() == "STR_OUT" && (*c)->detect(*u))
+						switch (detectors[*d].first->detect(*u))
 						{
+						case 2:	// hyper-wave decoder
+							(*u)->setHyperDetected(true);
+							hyperdetected = true;
+						case 1: // conventional radar
 							detected = true;
-							break;
 						}
 					}
+					else if (!detected && c->detect(*u))
+					{
+						detected = true;
+					}
 				}
 				if (detected)
 				{
@@ -1345,28 +1491,29 @@ void GeoscapeState::time30Minutes()
 			else
 			{
 				bool detected = false, hyperdetected = false;
-				for (std::vector<Base*>::iterator b = _game->getSavedGame()->getBases()->begin(); !hyperdetected && b != _game->getSavedGame()->getBases()->end(); ++b)
+				const std::vector<int> &candidates = _rangeGrid->getEntries((*u)->getLongitude(), (*u)->getLatitude());
+				for (std::vector<int>::const_iterator d = candidates.begin(); !hyperdetected && d != candidates.end(); ++d)
 				{
-					switch ((*b)->insideRadarRange(*u))
-					{
-					case 2:	// hyper-wave decoder
-						detected = true;
-						hyperdetected = true;
-						(*u)->setHyperDetected(true);
-						break;
-					case 1: // conventional radar
-						detected = true;
-						hyperdetected = (*u)->getHyperDetected();
-					}
-					for (std::vector<Craft*>::iterator c = (*b)->getCrafts()->begin(); !detected && c != (*b)->getCrafts()->end(); ++c)
+					Craft *c = detectors[*d].second;
+					if (c == 0)
 					{
-						if ((*c)->getStatus() == "STR_OUT" && (*c)->detect(*u))
+						switch (detectors[*d].first->insideRadarRange(*u))
 						{
+						case 2:	// hyper-wave decoder
 							detected = true;
-							hyperdetected = (*u)->getHyperDetected();
+							hyperdetected = true;
+							(*u)->setHyperDetected(true);
 							break;
+						case 1: // conventional radar
+							detected = true;
+							hyperdetected = (*u)->getHyperDetected();
 						}
 					}
+					else if (!detected && c->detect(*u))
+					{
+						detected = true;
+						hyperdetected = (*u)->getHyperDetected();
+					}
 				}
 				if (!detected)
 				{
@@ -2167,12 +2314,11 @@ void GeoscapeState::handleBaseDefense(Base *base, Ufo *ufo)
 		SavedBattleGame *bgame = new SavedBattleGame();
 		_game->getSavedGame()->setBattleGame(bgame);
 		bgame->setMissionType("STR_BASE_DEFENSE");
-		BattlescapeGenerator bgen = BattlescapeGenerator(_game);
-		bgen.setBase(base);
-		bgen.setAlienRace(ufo->getAlienRace());
-		bgen.run();
+		BattlescapeGenerator *bgen = new BattlescapeGenerator(_game);
+		bgen->setBase(base);
+		bgen->setAlienRace(ufo->getAlienRace());
 		_pause = true;
-		_game->pushState(new BriefingState(0, base));
+		_game->pushState(new BriefingState(0, base, bgen));
 	}
 	else
 	{
@@ -35,6 +35,7 @@ class Ufo;
 class MissionSite;
 class Base;
 class RuleMissionScript;
+class SphereGrid;
 
 /**
  * Geoscape screen which shows an overview of
@@ -57,6 +58,11 @@ private:
 	std::list<State*> _popups;
 	std::list<DogfightState*> _dogfights, _dogfightsToBeStarted;
 	size_t _minimizedDogfights;
+	SphereGrid *_rangeGrid;
+	/// Gets how many upcoming 5 second steps can only count down landed UFOs.
+	int getIdleSteps() const;
+	/// Counts down the landed UFOs for skipped 5 second steps.
+	void passIdleSteps(int steps);
 public:
 	/// Creates the Geoscape state.
 	GeoscapeState();
@@ -130,6 +136,8 @@ public:
 	void btnZoomOutRightClick(Action *action);
 	/// Blit method - renders the state and dogfights.
 	void blit();
+	/// Gets the changed area of the geoscape.
+	bool getDamage(SDL_Rect &rect);
 	/// Globe zoom in effect for dogfights.
 	void zoomInEffect();
 	/// Globe zoom out effect for dogfights.
@@ -53,8 +53,10 @@
 #include "../Mod/RuleBaseFacility.h"
 #include "../Mod/RuleCraft.h"
 #include "../Mod/RuleGlobe.h"
+#include "../Mod/PolygonIndex.h"
 #include "../Interface/Cursor.h"
 #include "../Engine/Screen.h"
+#include "../Engine/ThreadPool.h"
 
 namespace OpenXcom
 {
@@ -174,7 +176,14 @@ struct Ocean
 
 struct CreateShadow
 {
-	static inline Uint8 getShadowValue(const Uint8& dest, const Cord& earth, const Cord& sun, const Sint16& noise)
+	/**
+	 * Works out how dark a point of the globe is.
+	 * @param earth Normal of the globe surface.
+	 * @param sun Direction of the sun.
+	 * @param noise Noise added to the terminator.
+	 * @return Shade level, 0 for full daylight.
+	 */
+	static inline Sint16 getShadeLevel(const Cord& earth, const Cord& sun, const Sint16& noise)
 	{
 		Cord temp = earth;
 		//diff
@@ -199,8 +208,20 @@ struct CreateShadow
 		temp.x -= noise;
 
 		if (temp.x > 0.)
+			return (temp.x> 31)? 31 : (Sint16)temp.x;
+		return 0;
+	}
+
+	/**
+	 * Darkens a globe pixel.
+	 * @param dest Color of the pixel.
+	 * @param val Shade level of the pixel.
+	 * @return Shaded color.
+	 */
+	static inline Uint8 applyShade(const Uint8& dest, const Sint16& val)
+	{
+		if (val > 0)
 		{
-			const Sint16 val = (temp.x> 31)? 31 : (Sint16)temp.x;
 			const int d = dest & helper::ColorGroup;
 			if (d ==  Globe::OCEAN_COLOR || d == Globe::OCEAN_COLOR + 16)
 			{
@@ -234,15 +255,74 @@ struct CreateShadow
 		}
 	}
 
-	static inline void func(Uint8& dest, const Cord& earth, const Cord& sun, const Sint16& noise, const int&)
+	static inline Uint8 getShadowValue(const Uint8& dest, const Cord& earth, const Cord& sun, const Sint16& noise)
 	{
-		if (dest && earth.z)
-			dest = getShadowValue(dest, earth, sun, noise);
-		else
-			dest = 0;
+		return applyShade(dest, getShadeLevel(earth, sun, noise));
 	}
 };
 
+///shade layer values for pixels left alone and pixels off the globe
+const Sint8 SHADE_NONE = -2;
+const Sint8 SHADE_SPACE = -1;
+///steps per unit the sun direction is rounded to, about a shade level
+const double SUN_STEPS = 1024.0;
+///rows of the shade layer worked out by each task
+const int SHADE_ROWS = 16;
+
+///helper for working out the shade layer on several threads
+struct ShadeJob
+{
+	const std::vector<Cord> *earth;
+	const std::vector<Sint16> *noise;
+	Cord sun;
+	int width, height, x, y, moveX, moveY;
+	Sint8 *shade;
+};
+
+/**
+ * Works out the shade of a band of rows of the globe. Pixels
+ * line up with the earth normals and the noise exactly like
+ * ShaderDraw lines up the surface, the normals and the noise.
+ * @param data The job.
+ * @param task Index of the band.
+ */
+void shadeTask(void *data, int task)
+{
+	ShadeJob *job = (ShadeJob*)data;
+	const int noiseSize = static_data.random_surf_size;
+	int end = std::min(job->height, (task + 1) * SHADE_ROWS);
+	for (int py = task * SHADE_ROWS; py < end; ++py)
+	{
+		Sint8 *shade = job->shade + py * job->width;
+		int ey = job->y + py - job->moveY;
+		if (ey < 0 || ey >= job->height)
+		{
+			std::fill(shade, shade + job->width, SHADE_NONE);
+			continue;
+		}
+		int ny = (job->y + py) % noiseSize;
+		if (ny < 0) ny += noiseSize;
+		for (int px = 0; px < job->width; ++px)
+		{
+			int ex = job->x + px - job->moveX;
+			if (ex < 0 || ex >= job->width)
+			{
+				shade[px] = SHADE_NONE;
+				continue;
+			}
+			const Cord &earth = (*job->earth)[ey * job->width + ex];
+			if (!earth.z)
+			{
+				shade[px] = SHADE_SPACE;
+				continue;
+			}
+			int nx = (job->x + px) % noiseSize;
+			if (nx < 0) nx += noiseSize;
+			shade[px] = CreateShadow::getShadeLevel(earth, job->sun, (*job->noise)[ny * noiseSize + nx]);
+		}
+	}
+}
+
 }//namespace
 
 
@@ -256,7 +336,7 @@ struct CreateShadow
  * @param x X position in pixels.
  * @param y Y position in pixels.
  */
-Globe::Globe(Game* game, int cenX, int cenY, int width, int height, int x, int y) : InteractiveSurface(width, height, x, y), _rotLon(0.0), _rotLat(0.0), _hoverLon(0.0), _hoverLat(0.0), _cenX(cenX), _cenY(cenY), _game(game), _hover(false), _blink(-1),
+Globe::Globe(Game* game, int cenX, int cenY, int width, int height, int x, int y) : InteractiveSurface(width, height, x, y), _rotLon(0.0), _rotLat(0.0), _hoverLon(0.0), _hoverLat(0.0), _cenX(cenX), _cenY(cenY), _game(game), _hover(false), _blink(-1), _cacheLon(0.0), _cacheLat(0.0), _cacheRadius(0.0), _cacheX(0), _cacheY(0), _shadeValid(false), _shadeZoom(0), _shadeMoveX(0), _shadeMoveY(0), _shadeX(0), _shadeY(0),
 																					_isMouseScrolling(false), _isMouseScrolled(false), _xBeforeMouseScrolling(0), _yBeforeMouseScrolling(0), _lonBeforeMouseScrolling(0.0), _latBeforeMouseScrolling(0.0), _mouseScrollingStartTime(0), _totalMouseMoveX(0), _totalMouseMoveY(0), _mouseMovedOverThreshold(false)
 {
 	_rules = game->getMod()->getGlobe();
@@ -288,6 +368,7 @@ Globe::Globe(Game* game, int cenX, int cenY, int width, int height, int x, int y
 	for (size_t i=0; i<_randomNoiseData.size(); ++i)
 		_randomNoiseData[i] = rand()%4;
 
+	loadPolygons();
 	cachePolygons();
 }
 
@@ -304,11 +385,6 @@ Globe::~Globe()
 	delete _markerSet;
 	delete _radars;
 	delete _clipper;
-
-	for (std::list<Polygon*>::iterator i = _cacheLand.begin(); i != _cacheLand.end(); ++i)
-	{
-		delete *i;
-	}
 }
 
 /**
@@ -396,48 +472,15 @@ double Globe::lastVisibleLat(double lon) const
 }
 
 
+/**
+ * Gets the world polygon under a point of the globe.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return Pointer to the polygon, or NULL if it's over the sea.
+ */
 Polygon* Globe::getPolygonFromLonLat(double lon, double lat) const
 {
-	const double zDiscard=0.75f;
-    double coslat = cos(lat);
-    double sinlat = sin(lat);
-
-	for (std::list<Polygon*>::iterator i = _rules->getPolygons()->begin(); i != _rules->getPolygons()->end(); ++i)
-	{
-		double x, y, z, x2, y2;
-		double clat, clon;
-		z = 0;
-		for (int j = 0; j < (*i)->getPoints(); ++j)
-		{
-			z = coslat * cos((*i)->getLatitude(j)) * cos((*i)->getLongitude(j) - lon) + sinlat * sin((*i)->getLatitude(j));
-			if (z<zDiscard) break; //discarded
-		}
-		if (z<zDiscard) continue; //discarded
-
-		bool odd = false;
-
-		clat = (*i)->getLatitude(0); //initial point
-		clon = (*i)->getLongitude(0);
-		x = cos(clat) * sin(clon - lon);
-		y = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
-
-		for (int j = 0; j < (*i)->getPoints(); ++j)
-		{
-			int k = (j + 1) % (*i)->getPoints(); //index of next point in poly
-			clat = (*i)->getLatitude(k);
-			clon = (*i)->getLongitude(k);
-
-			x2 = cos(clat) * sin(clon - lon);
-			y2 = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
-			if ( ((y>0)!=(y2>0)) && (0 < (x2-x)*(0-y)/(y2-y)+x) )
-				odd = !odd;
-			x = x2;
-			y = y2;
-
-		}
-		if (odd) return *i;
-	}
-	return NULL;
+	return _rules->getPolygonIndex()->find(lon, lat);
 }
 
 /**
@@ -761,39 +804,81 @@ std::vector<Target*> Globe::getTargets(int x, int y, bool craft) const
 }
 
 /**
- * Takes care of pre-calculating all the polygons currently visible
- * on the globe and caching them so they only need to be recalculated
- * when the globe is actually moved.
+ * Stores the points of all the world polygons as unit vectors,
+ * so projecting them on the globe doesn't need any trigonometry.
+ * The axes are kept in separate arrays so the projection loop
+ * can be vectorized by the compiler.
  */
-void Globe::cachePolygons()
+void Globe::loadPolygons()
 {
-	cache(_rules->getPolygons(), &_cacheLand);
+	std::list<Polygon*> *polygons = _rules->getPolygons();
+	_landPolygons.assign(polygons->begin(), polygons->end());
+	_landFirst.clear();
+	_landX.clear();
+	_landY.clear();
+	_landZ.clear();
+	for (std::vector<Polygon*>::iterator i = _landPolygons.begin(); i != _landPolygons.end(); ++i)
+	{
+		_landFirst.push_back(_landX.size());
+		for (int j = 0; j < (*i)->getPoints(); ++j)
+		{
+			Cord point = Cord(CordPolar((*i)->getLongitude(j), (*i)->getLatitude(j)));
+			_landX.push_back(point.x);
+			_landY.push_back(point.y);
+			_landZ.push_back(point.z);
+		}
+	}
+	_landFirst.push_back(_landX.size());
+	_screenX.resize(_landX.size());
+	_screenY.resize(_landX.size());
+	_cacheRadius = 0.0;
 }
 
 /**
- * Caches a set of polygons.
- * @param polygons Pointer to list of polygons.
- * @param cache Pointer to cache.
+ * Takes care of pre-calculating all the polygons currently visible
+ * on the globe and caching them so they only need to be recalculated
+ * when the globe is actually moved or zoomed.
  */
-void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
+void Globe::cachePolygons()
 {
-	// Clear existing cache
-	for (std::list<Polygon*>::iterator i = cache->begin(); i != cache->end(); ++i)
+	if (_cacheLon == _cenLon && _cacheLat == _cenLat && _cacheRadius == _radius && _cacheX == _cenX && _cacheY == _cenY)
 	{
-		delete *i;
+		return;
 	}
-	cache->clear();
+	_cacheLon = _cenLon;
+	_cacheLat = _cenLat;
+	_cacheRadius = _radius;
+	_cacheX = _cenX;
+	_cacheY = _cenY;
 
-	// Pre-calculate values to cache
-	for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); ++i)
+	// rotates the unit vectors so the globe center faces the viewer
+	const double sinLon = sin(_cenLon), cosLon = cos(_cenLon);
+	const double sinLat = sin(_cenLat), cosLat = cos(_cenLat);
+	const double rightX = cosLon, rightZ = -sinLon;
+	const double upX = -sinLat * sinLon, upY = cosLat, upZ = -sinLat * cosLon;
+	const double depthX = cosLat * sinLon, depthY = sinLat, depthZ = cosLat * cosLon;
+
+	const double *vx = _landX.empty() ? 0 : &_landX[0];
+	const double *vy = _landY.empty() ? 0 : &_landY[0];
+	const double *vz = _landZ.empty() ? 0 : &_landZ[0];
+	Sint16 *sx = _screenX.empty() ? 0 : &_screenX[0];
+	Sint16 *sy = _screenY.empty() ? 0 : &_screenY[0];
+	const int points = _landX.size();
+	for (int j = 0; j < points; ++j)
+	{
+		sx[j] = _cenX + (Sint16)floor(_radius * (rightX * vx[j] + rightZ * vz[j]));
+		sy[j] = _cenY + (Sint16)floor(_radius * (upX * vx[j] + upY * vy[j] + upZ * vz[j]));
+	}
+
+	_cacheLand.clear();
+	for (int i = 0; i < (int)_landPolygons.size(); ++i)
 	{
 		// Is quad on the back face?
 		double closest = 0.0;
-		double z;
 		double furthest = 0.0;
-		for (int j = 0; j < (*i)->getPoints(); ++j)
+		for (int j = _landFirst[i]; j < _landFirst[i + 1]; ++j)
 		{
-			z = cos(_cenLat) * cos((*i)->getLatitude(j)) * cos((*i)->getLongitude(j) - _cenLon) + sin(_cenLat) * sin((*i)->getLatitude(j));
+			double z = depthX * vx[j] + depthY * vy[j] + depthZ * vz[j];
 			if (z > closest)
 				closest = z;
 			else if (z < furthest)
@@ -802,18 +887,7 @@ void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
 		if (-furthest > closest)
 			continue;
 
-		Polygon* p = new Polygon(**i);
-
-		// Convert coordinates
-		for (int j = 0; j < p->getPoints(); ++j)
-		{
-			Sint16 x, y;
-			polarToCart(p->getLongitude(j), p->getLatitude(j), &x, &y);
-			p->setX(j, x);
-			p->setY(j, y);
-		}
-
-		cache->push_back(p);
+		_cacheLand.push_back(i);
 	}
 }
 
@@ -914,19 +988,13 @@ void Globe::drawOcean()
  */
 void Globe::drawLand()
 {
-	Sint16 x[4], y[4];
-
-	for (std::list<Polygon*>::iterator i = _cacheLand.begin(); i != _cacheLand.end(); ++i)
+	for (std::vector<int>::iterator i = _cacheLand.begin(); i != _cacheLand.end(); ++i)
 	{
-		// Convert coordinates
-		for (int j = 0; j < (*i)->getPoints(); ++j)
-		{
-			x[j] = (*i)->getX(j);
-			y[j] = (*i)->getY(j);
-		}
+		Polygon *polygon = _landPolygons[*i];
+		int first = _landFirst[*i];
 
 		// Apply textures according to zoom and shade
-		drawTexturedPolygon(x, y, (*i)->getPoints(), _texture->getFrame((*i)->getTexture() + _zoomTexture), 0, 0);
+		drawTexturedPolygon(&_screenX[first], &_screenY[first], polygon->getPoints(), _texture->getFrame(polygon->getTexture() + _zoomTexture), 0, 0);
 	}
 }
 
@@ -988,15 +1056,53 @@ Cord Globe::getSunDirection(double lon, double lat) const
 
 void Globe::drawShadow()
 {
-	ShaderMove<Cord> earth = ShaderMove<Cord>(_earthData[_zoom], getWidth(), getHeight());
-	ShaderRepeat<Sint16> noise = ShaderRepeat<Sint16>(_randomNoiseData, static_data.random_surf_size, static_data.random_surf_size);
-
-	earth.setMove(_cenX-getWidth()/2, _cenY-getHeight()/2);
+	// the sun is rounded so the shading can be reused while it barely moves
+	Cord sun = getSunDirection(_cenLon, _cenLat);
+	sun.x = Round(sun.x * SUN_STEPS) / SUN_STEPS;
+	sun.y = Round(sun.y * SUN_STEPS) / SUN_STEPS;
+	sun.z = Round(sun.z * SUN_STEPS) / SUN_STEPS;
+	int moveX = _cenX - getWidth() / 2, moveY = _cenY - getHeight() / 2;
+	if (!_shadeValid || !(_shadeSun == sun) || _shadeZoom != _zoom || _shadeMoveX != moveX || _shadeMoveY != moveY ||
+		_shadeX != getX() || _shadeY != getY() || (int)_shadeLayer.size() != getWidth() * getHeight())
+	{
+		_shadeLayer.resize(getWidth() * getHeight());
+		_shadeValid = true;
+		_shadeSun = sun;
+		_shadeZoom = _zoom;
+		_shadeMoveX = moveX;
+		_shadeMoveY = moveY;
+		_shadeX = getX();
+		_shadeY = getY();
+		ShadeJob job;
+		job.earth = &_earthData[_zoom];
+		job.noise = &_randomNoiseData;
+		job.sun = sun;
+		job.width = getWidth();
+		job.height = getHeight();
+		job.x = getX();
+		job.y = getY();
+		job.moveX = moveX;
+		job.moveY = moveY;
+		job.shade = _shadeLayer.empty() ? 0 : &_shadeLayer[0];
+		ThreadPool::getShared()->run(shadeTask, &job, (getHeight() + SHADE_ROWS - 1) / SHADE_ROWS);
+	}
 
 	lock();
-	ShaderDraw<CreateShadow>(ShaderSurface(this), earth, ShaderScalar(getSunDirection(_cenLon, _cenLat)), noise);
+	for (int y = 0; y < getHeight(); ++y)
+	{
+		Uint8 *dest = (Uint8*)getSurface()->pixels + y * getSurface()->pitch;
+		const Sint8 *shade = &_shadeLayer[y * getWidth()];
+		for (int x = 0; x < getWidth(); ++x)
+		{
+			if (shade[x] == SHADE_NONE)
+				continue;
+			if (dest[x] && shade[x] != SHADE_SPACE)
+				dest[x] = CreateShadow::applyShade(dest[x], shade[x]);
+			else
+				dest[x] = 0;
+		}
+	}
 	unlock();
-
 }
 
 
@@ -1570,6 +1676,21 @@ void Globe::blit(Surface *surface)
 	_markers->blit(surface);
 }
 
+/**
+ * Gets the changed area of the globe, including
+ * its overlay layers.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool Globe::getDamage(SDL_Rect &rect)
+{
+	bool damaged = Surface::getDamage(rect);
+	damaged = _radars->getDamage(rect) || damaged;
+	damaged = _countries->getDamage(rect) || damaged;
+	damaged = _markers->getDamage(rect) || damaged;
+	return damaged;
+}
+
 /**
  * Ignores any mouse hovers that are outside the globe.
  * @param action Pointer to an action.
@@ -1866,6 +1987,7 @@ void Globe::setupRadii(int width, int height)
 	_radiusStep = (_zoomRadius[DOGFIGHT_ZOOM] - _zoomRadius[0]) / 10.0;
 
 	_earthData.resize(_zoomRadius.size());
+	_shadeValid = false;
 	//filling normal field for each radius
 
 	for (size_t r = 0; r<_zoomRadius.size(); ++r)
@@ -63,7 +63,22 @@ private:
 	bool _hover;
 	int _blink;
 	Timer *_blinkTimer, *_rotTimer;
-	std::list<Polygon*> _cacheLand;
+	///world polygons, with the unit vectors of their points split by axis
+	std::vector<Polygon*> _landPolygons;
+	std::vector<int> _landFirst;
+	std::vector<double> _landX, _landY, _landZ;
+	///screen position of every polygon point, and the polygons facing the viewer
+	std::vector<Sint16> _screenX, _screenY;
+	std::vector<int> _cacheLand;
+	///globe view the polygons were last projected for
+	double _cacheLon, _cacheLat, _cacheRadius;
+	Sint16 _cacheX, _cacheY;
+	///shade level of every pixel, for the sun and view it was worked out for
+	std::vector<Sint8> _shadeLayer;
+	bool _shadeValid;
+	Cord _shadeSun;
+	size_t _shadeZoom;
+	int _shadeMoveX, _shadeMoveY, _shadeX, _shadeY;
 	FastLineClip *_clipper;
 	double _radius, _radiusStep;
 	///normal of each pixel in earth globe per zoom level
@@ -90,8 +105,8 @@ private:
 	Polygon* getPolygonFromLonLat(double lon, double lat) const;
 	/// Checks if a target is near a point.
 	bool targetNear(Target* target, int x, int y) const;
-	/// Caches a set of polygons.
-	void cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache);
+	/// Stores the world polygon points as unit vectors.
+	void loadPolygons();
 	/// Get position of sun relative to given position in polar cords and date.
 	Cord getSunDirection(double lon, double lat) const;
 	/// Draw globe range circle.
@@ -187,6 +202,8 @@ public:
 	void drawMarkers();
 	/// Blits the globe onto another surface.
 	void blit(Surface *surface);
+	/// Gets the changed area of the globe.
+	bool getDamage(SDL_Rect &rect);
 	/// Special handling for mouse hover.
 	void mouseOver(Action *action, State *state);
 	/// Special handling for mouse presses.
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _USE_MATH_DEFINES
+#include "SphereGrid.h"
+#include <cmath>
+
+namespace OpenXcom
+{
+
+/**
+ * Creates an empty grid.
+ * @param rows Number of latitude bands.
+ * @param columns Number of longitude bands.
+ */
+SphereGrid::SphereGrid(int rows, int columns) : _rows(rows), _columns(columns), _entries(0), _cells(rows * columns)
+{
+}
+
+/**
+ * Cleans up the grid.
+ */
+SphereGrid::~SphereGrid()
+{
+}
+
+/**
+ * Gets the cell a point of the globe falls in.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return Cell index.
+ */
+int SphereGrid::getCell(double lon, double lat) const
+{
+	double wrapped = fmod(lon, 2 * M_PI);
+	if (wrapped < 0)
+	{
+		wrapped += 2 * M_PI;
+	}
+	int row = (int)floor((lat + M_PI_2) / M_PI * _rows);
+	int column = (int)floor(wrapped / (2 * M_PI) * _columns);
+	row = row < 0 ? 0 : (row >= _rows ? _rows - 1 : row);
+	column = column < 0 ? 0 : (column >= _columns ? _columns - 1 : column);
+	return row * _columns + column;
+}
+
+/**
+ * Removes all the entries, only going through
+ * the cells that were used.
+ */
+void SphereGrid::clear()
+{
+	for (std::vector<int>::iterator i = _used.begin(); i != _used.end(); ++i)
+	{
+		_cells[*i].clear();
+	}
+	_used.clear();
+	_entries = 0;
+}
+
+/**
+ * Adds a cap of the globe to every cell it might overlap.
+ * Points right on the edge of the cap count as inside.
+ * @param center Center of the cap.
+ * @param radius Angular radius of the cap.
+ * @return Index of the new entry, entries are numbered in order.
+ */
+int SphereGrid::add(const CordPolar &center, double radius)
+{
+	const double cellHeight = M_PI / _rows, cellWidth = 2 * M_PI / _columns;
+	int entry = _entries++;
+	// slack for rounding, so points right on the edge aren't missed
+	radius += 1e-6;
+	double latMin = center.lat - radius, latMax = center.lat + radius;
+	int rowMin = latMin <= -M_PI_2 ? 0 : (int)floor((latMin + M_PI_2) / cellHeight);
+	int rowMax = latMax >= M_PI_2 ? _rows - 1 : (int)floor((latMax + M_PI_2) / cellHeight);
+	int columnMin = 0, columnMax = _columns - 1;
+	if (latMin > -M_PI_2 && latMax < M_PI_2)
+	{
+		double lonSpan = asin(sin(radius) / cos(center.lat));
+		columnMin = (int)floor((center.lon - lonSpan) / cellWidth);
+		columnMax = (int)floor((center.lon + lonSpan) / cellWidth);
+		if (columnMax - columnMin >= _columns)
+		{
+			columnMin = 0;
+			columnMax = _columns - 1;
+		}
+	}
+	for (int row = rowMin < 0 ? 0 : rowMin; row <= rowMax && row < _rows; ++row)
+	{
+		for (int column = columnMin; column <= columnMax; ++column)
+		{
+			int cell = row * _columns + ((column % _columns) + _columns) % _columns;
+			if (_cells[cell].empty())
+			{
+				_used.push_back(cell);
+			}
+			_cells[cell].push_back(entry);
+		}
+	}
+	return entry;
+}
+
+/**
+ * Gets the entries whose cap might cover a point of the globe.
+ * They still need to be checked against the real range.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return List of entries, in the order they were added.
+ */
+const std::vector<int> &SphereGrid::getEntries(double lon, double lat) const
+{
+	return _cells[getCell(lon, lat)];
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_SPHEREGRID_H
+#define OPENXCOM_SPHEREGRID_H
+
+#include <vector>
+#include "Cord.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Latitude/longitude grid over the globe for range lookups.
+ * Entries are caps around a point, and get listed in every cell
+ * the cap might overlap, so looking up a point gives a short list
+ * of entries that might cover it, in the order they were added.
+ * Caps that reach a pole cover whole rows of the grid.
+ */
+class SphereGrid
+{
+private:
+	int _rows, _columns, _entries;
+	std::vector< std::vector<int> > _cells;
+	std::vector<int> _used;
+	/// Gets the cell holding a point.
+	int getCell(double lon, double lat) const;
+public:
+	/// Creates an empty grid with a number of cells.
+	SphereGrid(int rows, int columns);
+	/// Cleans up the grid.
+	~SphereGrid();
+	/// Removes all the entries.
+	void clear();
+	/// Adds a cap to the grid.
+	int add(const CordPolar &center, double radius);
+	/// Gets the entries that might cover a point.
+	const std::vector<int> &getEntries(double lon, double lat) const;
+};
+
+}
+
+#endif
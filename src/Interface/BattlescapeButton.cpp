@@ -68,7 +68,10 @@ void BattlescapeButton::setGroup(BattlescapeButton **group)
 {
 	_group = group;
 	if (_group != 0 && *_group == this)
+	{
 		_inverted = true;
+		setDirty();
+	}
 }
 
 /**
@@ -86,11 +89,13 @@ void BattlescapeButton::mousePress(Action *action, State *state)
 			(*_group)->toggle(false);
 			*_group = this;
 			_inverted = true;
+			setDirty();
 		}
 	}
 	else if ((_tftdMode || _toggleMode == INVERT_CLICK ) && !_inverted && isButtonPressed() && isButtonHandled(action->getDetails()->button.button))
 	{
 		_inverted = true;
+		setDirty();
 	}
 	InteractiveSurface::mousePress(action, state);
 }
@@ -105,6 +110,7 @@ void BattlescapeButton::mouseRelease(Action *action, State *state)
 	if (_inverted && isButtonHandled(action->getDetails()->button.button))
 	{
 		_inverted = false;
+		setDirty();
 	}
 	InteractiveSurface::mouseRelease(action, state);
 }
@@ -115,9 +121,10 @@ void BattlescapeButton::mouseRelease(Action *action, State *state)
  */
 void BattlescapeButton::toggle(bool press)
 {
-	if (_tftdMode || _toggleMode == INVERT_TOGGLE || _inverted)
+	if ((_tftdMode || _toggleMode == INVERT_TOGGLE || _inverted) && _inverted != press)
 	{
 		_inverted = press;
+		setDirty();
 	}
 }
 
@@ -203,6 +210,9 @@ void BattlescapeButton::blit(Surface *surface)
 	if (_inverted)
 	{
 		_altSurface->blit(surface);
+		_dirty = false;
+		_damage.w = 0;
+		_damage.h = 0;
 	}
 	else
 	{
@@ -210,6 +220,22 @@ void BattlescapeButton::blit(Surface *surface)
 	}
 }
 
+/**
+ * Gets the changed area of the button, including
+ * the alternate surface when it's the one shown.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool BattlescapeButton::getDamage(SDL_Rect &rect)
+{
+	bool damaged = Surface::getDamage(rect);
+	if (_inverted && _altSurface != 0 && _visible && !_hidden && _altSurface->getDamage(rect))
+	{
+		damaged = true;
+	}
+	return damaged;
+}
+
 /**
  * Changes the position of the surface in the X axis.
  * @param x X position in pixels.
@@ -66,6 +66,8 @@ public:
 	void initSurfaces();
 	/// Blits this surface onto another one.
 	void blit(Surface *surface);
+	/// Gets the changed area of the button.
+	bool getDamage(SDL_Rect &rect);
 	/// Alters both versions of the button's X pos.
 	void setX(int x);
 	/// Alters both versions of the button's Y pos.
@@ -328,6 +328,25 @@ void ComboBox::blit(Surface *surface)
 	}
 }
 
+/**
+ * Gets the changed area of the combo box, including
+ * its button and dropdown list.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool ComboBox::getDamage(SDL_Rect &rect)
+{
+	bool damaged = Surface::getDamage(rect);
+	if (_visible && !_hidden)
+	{
+		damaged = _button->getDamage(rect) || damaged;
+		damaged = _arrow->getDamage(rect) || damaged;
+		damaged = _window->getDamage(rect) || damaged;
+		damaged = _list->getDamage(rect) || damaged;
+	}
+	return damaged;
+}
+
 /**
  * Passes events to internal components.
  * @param action Pointer to an action.
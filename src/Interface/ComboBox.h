@@ -94,6 +94,8 @@ public:
 	void setOptions(const std::vector<std::wstring> &options);
 	/// Blits the combo box onto another surface.
 	void blit(Surface *surface);	
+	/// Gets the changed area of the combo box.
+	bool getDamage(SDL_Rect &rect);
 	/// Thinks arrow buttons.
 	void think();
 	/// Handle arrow buttons.
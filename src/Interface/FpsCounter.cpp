@@ -18,10 +18,12 @@
  */
 
 #include "FpsCounter.h"
+#include <algorithm>
 #include <cmath>
 #include "../Engine/Action.h"
 #include "../Engine/Timer.h"
 #include "../Engine/Options.h"
+#include "../Engine/Logger.h"
 #include "NumberText.h"
 
 namespace OpenXcom
@@ -34,7 +36,7 @@ namespace OpenXcom
  * @param x X position in pixels.
  * @param y Y position in pixels.
  */
-FpsCounter::FpsCounter(int width, int height, int x, int y) : Surface(width, height, x, y), _frames(0)
+FpsCounter::FpsCounter(int width, int height, int x, int y) : Surface(width, height, x, y), _frames(0), _lastFrame(0), _frameTimeSum(0.0), _frameTimeSquares(0.0), _jitter(0.0)
 {
 	_visible = Options::fpsCounter;
 
@@ -97,13 +99,22 @@ void FpsCounter::think()
 }
 
 /**
- * Updates the amount of Frames per Second.
+ * Updates the amount of Frames per Second,
+ * and the frame time jitter over the last second.
  */
 void FpsCounter::update()
 {
 	int fps = (int)floor((double)_frames / _timer->getTime() * 1000);
 	_text->setValue(fps);
+	if (_frames > 1)
+	{
+		double mean = _frameTimeSum / _frames;
+		_jitter = sqrt(std::max(0.0, _frameTimeSquares / _frames - mean * mean));
+		Log(LOG_DEBUG) << "FPS: " << fps << " Frame time: " << mean << "ms Jitter: " << _jitter << "ms";
+	}
 	_frames = 0;
+	_frameTimeSum = 0.0;
+	_frameTimeSquares = 0.0;
 	_redraw = true;
 }
 
@@ -116,8 +127,29 @@ void FpsCounter::draw()
 	_text->blit(this);
 }
 
+/**
+ * Counts a new frame drawn, and how long it took since the last one.
+ */
 void FpsCounter::addFrame()
 {
+	Uint32 now = SDL_GetTicks();
+	if (_lastFrame != 0)
+	{
+		double frameTime = now - _lastFrame;
+		_frameTimeSum += frameTime;
+		_frameTimeSquares += frameTime * frameTime;
+	}
+	_lastFrame = now;
 	_frames++;
 }
+
+/**
+ * Returns the frame time jitter, the standard deviation
+ * of the time between frames over the last second.
+ * @return Jitter in milliseconds.
+ */
+double FpsCounter::getJitter() const
+{
+	return _jitter;
+}
 }
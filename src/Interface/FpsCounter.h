@@ -39,6 +39,8 @@ private:
 	NumberText *_text;
 	Timer *_timer;
 	int _frames;
+	Uint32 _lastFrame;
+	double _frameTimeSum, _frameTimeSquares, _jitter;
 public:
 	/// Creates a new FPS counter linked to a game.
 	FpsCounter(int width, int height, int x, int y);
@@ -56,7 +58,10 @@ public:
 	void update();
 	/// Draws the FPS counter.
 	void draw();
+	/// Counts a frame and measures its time.
 	void addFrame();
+	/// Gets the frame time jitter.
+	double getJitter() const;
 };
 
 }
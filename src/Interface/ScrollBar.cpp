@@ -33,7 +33,7 @@ namespace OpenXcom
  * @param x X position in pixels.
  * @param y Y position in pixels.
  */
-ScrollBar::ScrollBar(int width, int height, int x, int y) : InteractiveSurface(width, height, x, y), _list(0), _color(0), _pressed(false), _contrast(false), _offset(0), _bg(0)
+ScrollBar::ScrollBar(int width, int height, int x, int y) : InteractiveSurface(width, height, x, y), _list(0), _color(0), _pressed(false), _contrast(false), _offset(0), _bg(0), _lastScroll(0), _lastRows(0), _lastVisibleRows(0)
 {
 	_track = new Surface(width-2, height, x+1, y);
 	_thumb = new Surface(width, height, x, y);
@@ -93,6 +93,7 @@ void ScrollBar::setHeight(int height)
 void ScrollBar::setColor(Uint8 color)
 {
 	_color = color;
+	_redraw = true;
 }
 
 /**
@@ -112,6 +113,7 @@ Uint8 ScrollBar::getColor() const
 void ScrollBar::setHighContrast(bool contrast)
 {
 	_contrast = contrast;
+	_redraw = true;
 }
 
 /**
@@ -131,6 +133,7 @@ void ScrollBar::setTextList(TextList *list)
 void ScrollBar::setBackground(Surface *bg)
 {
 	_bg = bg;
+	_redraw = true;
 }
 
 /**
@@ -171,15 +174,40 @@ void ScrollBar::handle(Action *action, State *state)
  */
 void ScrollBar::blit(Surface *surface)
 {
+	if (listChanged())
+	{
+		invalidate();
+	}
 	Surface::blit(surface);
 	if (_visible && !_hidden)
 	{
 		_track->blit(surface);
 		_thumb->blit(surface);
-		invalidate();
 	}
 }
 
+/**
+ * Gets the changed area of the scrollbar, including
+ * the track and thumb.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool ScrollBar::getDamage(SDL_Rect &rect)
+{
+	bool damaged = Surface::getDamage(rect);
+	if (_visible && !_hidden)
+	{
+		if (listChanged())
+		{
+			addArea(rect);
+			damaged = true;
+		}
+		damaged = _track->getDamage(rect) || damaged;
+		damaged = _thumb->getDamage(rect) || damaged;
+	}
+	return damaged;
+}
+
 /**
  * The scrollbar only moves while the button is pressed.
  * @param action Pointer to an action.
@@ -264,6 +292,9 @@ void ScrollBar::drawTrack()
  */
 void ScrollBar::drawThumb()
 {
+	_lastScroll = _list->getScroll();
+	_lastRows = _list->getRows();
+	_lastVisibleRows = _list->getVisibleRows();
 	double scale = (double)getHeight() / _list->getRows();
 	_thumbRect.x = 0;
 	_thumbRect.y = (int)floor(_list->getScroll() * scale);
@@ -329,4 +360,18 @@ void ScrollBar::drawThumb()
 	_thumb->unlock();
 }
 
+/**
+ * Checks if the list was scrolled or resized since
+ * the thumb was last drawn, so it needs redrawing.
+ * @return True if the thumb is out of date.
+ */
+bool ScrollBar::listChanged() const
+{
+	if (_list == 0)
+	{
+		return false;
+	}
+	return _list->getScroll() != _lastScroll || _list->getRows() != _lastRows || _list->getVisibleRows() != _lastVisibleRows;
+}
+
 }
@@ -39,10 +39,13 @@ private:
 	SDL_Rect _thumbRect;
 	int _offset;
 	Surface *_bg;
+	size_t _lastScroll, _lastRows, _lastVisibleRows;
 	/// Draws the scrollbar track.
 	void drawTrack();
 	/// Draws the scrollbar thumb.
 	void drawThumb();
+	/// Checks if the list scrolled since the thumb was drawn.
+	bool listChanged() const;
 public:
 	/// Creates a new scrollbar with the specified size and position.
 	ScrollBar(int width, int height, int x = 0, int y = 0);
@@ -68,6 +71,8 @@ public:
 	void setPalette(SDL_Color *colors, int firstcolor = 0, int ncolors = 256);
 	/// Blits the scrollbar onto another surface.
 	void blit(Surface *surface);
+	/// Gets the changed area of the scrollbar.
+	bool getDamage(SDL_Rect &rect);
 	/// Moves the scrollbar.
 	void handle(Action *action, State *state);
 	/// Special handling for mouse presses.
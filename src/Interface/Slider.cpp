@@ -255,6 +255,25 @@ void Slider::blit(Surface *surface)
 	}
 }
 
+/**
+ * Gets the changed area of the slider, including
+ * its labels and button.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool Slider::getDamage(SDL_Rect &rect)
+{
+	bool damaged = Surface::getDamage(rect);
+	if (_visible && !_hidden)
+	{
+		damaged = _txtMinus->getDamage(rect) || damaged;
+		damaged = _txtPlus->getDamage(rect) || damaged;
+		damaged = _frame->getDamage(rect) || damaged;
+		damaged = _button->getDamage(rect) || damaged;
+	}
+	return damaged;
+}
+
 /**
  * The slider only moves while the button is pressed.
  * @param action Pointer to an action.
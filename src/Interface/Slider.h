@@ -74,6 +74,8 @@ public:
 	int getValue() const;
 	/// Blits the slider onto another surface.
 	void blit(Surface *surface);
+	/// Gets the changed area of the slider.
+	bool getDamage(SDL_Rect &rect);
 	/// Moves the slider.
 	void handle(Action *action, State *state);
 	/// Special handling for mouse presses.
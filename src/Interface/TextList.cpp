@@ -987,6 +987,33 @@ void TextList::blit(Surface *surface)
 	}
 }
 
+/**
+ * Gets the changed area of the list, including
+ * the selector, arrow buttons and scrollbar.
+ * @param rect Rectangle to grow with the damaged area.
+ * @return True if anything changed.
+ */
+bool TextList::getDamage(SDL_Rect &rect)
+{
+	bool damaged = Surface::getDamage(rect);
+	if (_visible && !_hidden)
+	{
+		damaged = _selector->getDamage(rect) || damaged;
+		if (_arrowPos != -1 && !_rows.empty())
+		{
+			for (size_t i = _rows[_scroll]; i < _texts.size() && i < _rows[_scroll] + _visibleRows; ++i)
+			{
+				damaged = _arrowLeft[i]->getDamage(rect) || damaged;
+				damaged = _arrowRight[i]->getDamage(rect) || damaged;
+			}
+		}
+		damaged = _up->getDamage(rect) || damaged;
+		damaged = _down->getDamage(rect) || damaged;
+		damaged = _scrollbar->getDamage(rect) || damaged;
+	}
+	return damaged;
+}
+
 /**
  * Passes events to arrow buttons.
  * @param action Pointer to an action.
@@ -173,6 +173,8 @@ public:
 	void draw();
 	/// Blits the text list onto another surface.
 	void blit(Surface *surface);
+	/// Gets the changed area of the list.
+	bool getDamage(SDL_Rect &rect);
 	/// Thinks arrow buttons.
 	void think();
 	/// Handles arrow buttons.
@@ -252,10 +252,12 @@ void Window::draw()
 
 	if (_bg != 0)
 	{
-		_bg->getCrop()->x = square.x - _dx;
-		_bg->getCrop()->y = square.y - _dy;
-		_bg->getCrop()->w = square.w ;
-		_bg->getCrop()->h = square.h ;
+		SDL_Rect crop;
+		crop.x = square.x - _dx;
+		crop.y = square.y - _dy;
+		crop.w = square.w;
+		crop.h = square.h;
+		_bg->setCrop(crop);
 		_bg->setX(square.x);
 		_bg->setY(square.y);
 		_bg->blit(this);
@@ -466,16 +466,16 @@ void NewBattleState::btnOkClick(Action *)
 	SavedBattleGame *bgame = new SavedBattleGame();
 	_game->getSavedGame()->setBattleGame(bgame);
 	bgame->setMissionType(_missionTypes[_cbxMission->getSelected()]);
-	BattlescapeGenerator bgen = BattlescapeGenerator(_game);
+	BattlescapeGenerator *bgen = new BattlescapeGenerator(_game);
 	Base *base = 0;
 
-	bgen.setTerrain(_game->getMod()->getTerrain(_terrainTypes[_cbxTerrain->getSelected()]));
+	bgen->setTerrain(_game->getMod()->getTerrain(_terrainTypes[_cbxTerrain->getSelected()]));
 
 	// base defense
 	if (_missionTypes[_cbxMission->getSelected()] == "STR_BASE_DEFENSE")
 	{
 		base = _craft->getBase();
-		bgen.setBase(base);
+		bgen->setBase(base);
 		_craft = 0;
 	}
 	// alien base
@@ -486,7 +486,7 @@ void NewBattleState::btnOkClick(Action *)
 		b->setId(1);
 		b->setAlienRace(_alienRaces[_cbxAlienRace->getSelected()]);
 		_craft->setDestination(b);
-		bgen.setAlienBase(b);
+		bgen->setAlienBase(b);
 		_game->getSavedGame()->getAlienBases()->push_back(b);
 	}
 	// ufo assault
@@ -495,7 +495,7 @@ void NewBattleState::btnOkClick(Action *)
 		Ufo *u = new Ufo(_game->getMod()->getUfo(_missionTypes[_cbxMission->getSelected()]));
 		u->setId(1);
 		_craft->setDestination(u);
-		bgen.setUfo(u);
+		bgen->setUfo(u);
 		// either ground assault or ufo crash
 		if (RNG::generate(0,1) == 1)
 			bgame->setMissionType("STR_UFO_GROUND_ASSAULT");
@@ -512,28 +512,27 @@ void NewBattleState::btnOkClick(Action *)
 		m->setId(1);
 		m->setAlienRace(_alienRaces[_cbxAlienRace->getSelected()]);
 		_craft->setDestination(m);
-		bgen.setMissionSite(m);
+		bgen->setMissionSite(m);
 		_game->getSavedGame()->getMissionSites()->push_back(m);
 	}
 
 	if (_craft)
 	{
 		_craft->setSpeed(0);
-		bgen.setCraft(_craft);
+		bgen->setCraft(_craft);
 	}
 
 	_game->getSavedGame()->setDifficulty((GameDifficulty)_cbxDifficulty->getSelected());
 
-	bgen.setWorldShade(_slrDarkness->getValue());
-	bgen.setAlienRace(_alienRaces[_cbxAlienRace->getSelected()]);
-	bgen.setAlienItemlevel(_slrAlienTech->getValue());
+	bgen->setWorldShade(_slrDarkness->getValue());
+	bgen->setAlienRace(_alienRaces[_cbxAlienRace->getSelected()]);
+	bgen->setAlienItemlevel(_slrAlienTech->getValue());
 	bgame->setDepth(_slrDepth->getValue());
 
-	bgen.run();
 
 	_game->popState();
 	_game->popState();
-	_game->pushState(new BriefingState(_craft, base));
+	_game->pushState(new BriefingState(_craft, base, bgen));
 	_craft = 0;
 }
 
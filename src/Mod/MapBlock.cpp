@@ -19,7 +19,9 @@
 #include "MapBlock.h"
 #include "../Battlescape/Position.h"
 #include <sstream>
+#include <fstream>
 #include "../Engine/Exception.h"
+#include "../Engine/FileMap.h"
 
 namespace OpenXcom
 {
@@ -27,7 +29,7 @@ namespace OpenXcom
 /**
  * MapBlock construction.
  */
-MapBlock::MapBlock(const std::string &name):_name(name), _size_x(10), _size_y(10), _size_z(4)
+MapBlock::MapBlock(const std::string &name):_name(name), _size_x(10), _size_y(10), _size_z(4), _mapLoaded(false), _routesLoaded(false)
 {
 	_groups.push_back(0);
 }
@@ -153,4 +155,57 @@ std::map<std::string, std::vector<Position> > *MapBlock::getItems()
 	return &_items;
 }
 
+/**
+ * Reads a whole file into memory in one go.
+ * @param filename Path of the file in the game data.
+ * @param data Vector to fill with the contents.
+ */
+void MapBlock::readFile(const std::string &filename, std::vector<char> *data)
+{
+	std::ifstream file(FileMap::getFilePath(filename).c_str(), std::ios::in | std::ios::binary);
+	if (!file)
+	{
+		throw Exception(filename + " not found");
+	}
+	file.seekg(0, std::ios::end);
+	std::streamoff size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	data->resize(size > 0 ? (size_t)size : 0);
+	if (!data->empty() && !file.read(&data->at(0), data->size()))
+	{
+		throw Exception("Could not read " + filename);
+	}
+}
+
+/**
+ * Gets the contents of the mapblock's MAP file. The file is
+ * only read the first time, the block keeps it after that
+ * so the next battle on the same terrain doesn't need to.
+ * @return MAP file data.
+ */
+const std::vector<char> &MapBlock::getMapFile()
+{
+	if (!_mapLoaded)
+	{
+		readFile("MAPS/" + _name + ".MAP", &_mapFile);
+		_mapLoaded = true;
+	}
+	return _mapFile;
+}
+
+/**
+ * Gets the contents of the mapblock's RMP file. The file is
+ * only read the first time, like the MAP file.
+ * @return RMP file data.
+ */
+const std::vector<char> &MapBlock::getRouteFile()
+{
+	if (!_routesLoaded)
+	{
+		readFile("ROUTES/" + _name + ".RMP", &_routeFile);
+		_routesLoaded = true;
+	}
+	return _routeFile;
+}
+
 }
@@ -43,6 +43,10 @@ private:
 	int _size_x, _size_y, _size_z;
 	std::vector<int> _groups, _revealedFloors;
 	std::map<std::string, std::vector<Position> > _items;
+	std::vector<char> _mapFile, _routeFile;
+	bool _mapLoaded, _routesLoaded;
+	/// Reads a whole file into memory.
+	static void readFile(const std::string &filename, std::vector<char> *data);
 public:
 	MapBlock(const std::string &name);
 	~MapBlock();
@@ -64,6 +68,10 @@ public:
 	bool isFloorRevealed(int floor);
 	/// Gets the layout for any items that belong in this map block.
 	std::map<std::string, std::vector<Position> > *getItems();
+	/// Gets the contents of the mapblock's MAP file.
+	const std::vector<char> &getMapFile();
+	/// Gets the contents of the mapblock's RMP file.
+	const std::vector<char> &getRouteFile();
 
 };
 
@@ -29,11 +29,12 @@ namespace OpenXcom
 
 MapData *MapDataSet::_blankTile = 0;
 MapData *MapDataSet::_scorchedTile = 0;
+std::list<MapDataSet*> MapDataSet::_idleSets;
 
 /**
  * MapDataSet construction.
  */
-MapDataSet::MapDataSet(const std::string &name) : _name(name), _surfaceSet(0), _loaded(false)
+MapDataSet::MapDataSet(const std::string &name) : _name(name), _surfaceSet(0), _loaded(false), _users(0)
 {
 }
 
@@ -42,6 +43,7 @@ MapDataSet::MapDataSet(const std::string &name) : _name(name), _surfaceSet(0), _
  */
 MapDataSet::~MapDataSet()
 {
+	_idleSets.remove(this);
 	unloadData();
 }
 
@@ -241,6 +243,45 @@ void MapDataSet::unloadData()
 	}
 }
 
+/**
+ * Marks the terrain data as used by a battle,
+ * loading it if it isn't in memory already.
+ */
+void MapDataSet::useData()
+{
+	loadData();
+	if (_users == 0)
+	{
+		_idleSets.remove(this);
+	}
+	_users++;
+}
+
+/**
+ * Marks the terrain data as no longer used by a battle.
+ * Data no battle uses is kept around in case the next battle
+ * is on the same terrain, only the sets that have gone unused
+ * the longest get unloaded.
+ */
+void MapDataSet::releaseData()
+{
+	if (_users == 0)
+	{
+		return;
+	}
+	_users--;
+	if (_users == 0 && _loaded)
+	{
+		_idleSets.push_back(this);
+		while (_idleSets.size() > MAX_IDLE_SETS)
+		{
+			MapDataSet *oldest = _idleSets.front();
+			_idleSets.pop_front();
+			oldest->unloadData();
+		}
+	}
+}
+
 /**
  * Loads the LOFTEMPS.DAT into the ruleset voxeldata.
  * @param filename Filename of the DAT file.
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <vector>
+#include <list>
 #include <SDL.h>
 #include <yaml-cpp/yaml.h>
 
@@ -43,8 +44,11 @@ private:
 	std::vector<MapData*> _objects;
 	SurfaceSet *_surfaceSet;
 	bool _loaded;
+	int _users;
 	static MapData *_blankTile;
 	static MapData *_scorchedTile;
+	static const size_t MAX_IDLE_SETS = 32;
+	static std::list<MapDataSet*> _idleSets;
 public:
 	MapDataSet(const std::string &name);
 	~MapDataSet();
@@ -64,6 +68,10 @@ public:
 	void loadData();
 	///	Unloads to free memory.
 	void unloadData();
+	/// Marks the data as used by a battle, loading it if needed.
+	void useData();
+	/// Marks the data as no longer used by a battle.
+	void releaseData();
 	/// Gets a blank floor tile.
 	static MapData *getBlankFloorTile();
 	/// Gets a scorched earth tile.
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _USE_MATH_DEFINES
+#include "PolygonIndex.h"
+#include <cmath>
+#include <algorithm>
+#include "Polygon.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates an empty polygon index.
+ */
+PolygonIndex::PolygonIndex() : _grid(90, 180)
+{
+}
+
+/**
+ * Cleans up the polygon index.
+ */
+PolygonIndex::~PolygonIndex()
+{
+}
+
+/**
+ * Rebuilds the index for a new set of polygons.
+ * The cells keep the polygons in list order, so lookups
+ * still find the first polygon that matches.
+ * @param polygons List of world polygons.
+ */
+void PolygonIndex::build(std::list<Polygon*> *polygons)
+{
+	// slack for rounding, cells are checked for real anyway
+	const double margin = 0.01;
+	_polygons.clear();
+	_vertices.clear();
+	_grid.clear();
+	for (std::list<Polygon*>::iterator i = polygons->begin(); i != polygons->end(); ++i)
+	{
+		if ((*i)->getPoints() == 0)
+		{
+			continue;
+		}
+		Entry entry;
+		entry.polygon = *i;
+		entry.first = _vertices.size();
+		entry.points = (*i)->getPoints();
+		Cord center;
+		for (int j = 0; j < entry.points; ++j)
+		{
+			Cord vertex = Cord(CordPolar((*i)->getLongitude(j), (*i)->getLatitude(j)));
+			_vertices.push_back(vertex);
+			center += vertex;
+		}
+		double radius = M_PI;
+		if (center.norm() > 1e-9)
+		{
+			center /= center.norm();
+			radius = 0;
+			for (int j = entry.first; j < entry.first + entry.points; ++j)
+			{
+				double dot = center.x * _vertices[j].x + center.y * _vertices[j].y + center.z * _vertices[j].z;
+				radius = std::max(radius, acos(std::min(1.0, std::max(-1.0, dot))));
+			}
+			radius += margin;
+		}
+		_polygons.push_back(entry);
+		_grid.add(radius < M_PI ? CordPolar(center) : CordPolar(0, 0), radius);
+	}
+}
+
+/**
+ * Finds the polygon containing a point of the globe. Only polygons
+ * with all their points near the point are considered, and they're
+ * projected on the plane touching the globe at the point.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return Pointer to the polygon, or NULL if there's none.
+ */
+Polygon *PolygonIndex::find(double lon, double lat) const
+{
+	const double zDiscard = 0.75f;
+	double coslat = cos(lat), sinlat = sin(lat);
+	double coslon = cos(lon), sinlon = sin(lon);
+	Cord point = Cord(sinlon * coslat, sinlat, coslon * coslat);
+
+	const std::vector<int> &cell = _grid.getEntries(lon, lat);
+	for (std::vector<int>::const_iterator i = cell.begin(); i != cell.end(); ++i)
+	{
+		const Entry &entry = _polygons[*i];
+		const Cord *vertex = &_vertices[entry.first];
+		bool discarded = false;
+		for (int j = 0; j < entry.points; ++j)
+		{
+			if (point.x * vertex[j].x + point.y * vertex[j].y + point.z * vertex[j].z < zDiscard)
+			{
+				discarded = true;
+				break;
+			}
+		}
+		if (discarded) continue;
+
+		bool odd = false;
+		double x = vertex[0].x * coslon - vertex[0].z * sinlon;
+		double y = coslat * vertex[0].y - sinlat * (vertex[0].z * coslon + vertex[0].x * sinlon);
+		for (int j = 0; j < entry.points; ++j)
+		{
+			int k = (j + 1) % entry.points; //index of next point in poly
+			double x2 = vertex[k].x * coslon - vertex[k].z * sinlon;
+			double y2 = coslat * vertex[k].y - sinlat * (vertex[k].z * coslon + vertex[k].x * sinlon);
+			if ( ((y>0)!=(y2>0)) && (0 < (x2-x)*(0-y)/(y2-y)+x) )
+				odd = !odd;
+			x = x2;
+			y = y2;
+		}
+		if (odd) return entry.polygon;
+	}
+	return NULL;
+}
+
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_POLYGONINDEX_H
+#define OPENXCOM_POLYGONINDEX_H
+
+#include <list>
+#include <vector>
+#include "../Geoscape/Cord.h"
+#include "../Geoscape/SphereGrid.h"
+
+namespace OpenXcom
+{
+
+class Polygon;
+
+/**
+ * Spatial index over the world polygons, for finding
+ * the polygon under a point of the globe.
+ * The globe is split in a grid of 2x2 degree cells, and every
+ * polygon is listed in the cells touched by the smallest cap
+ * around its points. The points are stored as
+ * unit vectors so testing a candidate needs no trigonometry.
+ */
+class PolygonIndex
+{
+private:
+	struct Entry
+	{
+		Polygon *polygon;
+		int first, points;
+	};
+	std::vector<Entry> _polygons;
+	std::vector<Cord> _vertices;
+	SphereGrid _grid;
+public:
+	/// Creates an empty polygon index.
+	PolygonIndex();
+	/// Cleans up the polygon index.
+	~PolygonIndex();
+	/// Rebuilds the index from a list of polygons.
+	void build(std::list<Polygon*> *polygons);
+	/// Gets the polygon under a point.
+	Polygon *find(double lon, double lat) const;
+};
+
+}
+
+#endif
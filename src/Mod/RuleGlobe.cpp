@@ -23,6 +23,7 @@
 #include <fstream>
 #include "../Engine/Exception.h"
 #include "Polygon.h"
+#include "PolygonIndex.h"
 #include "Polyline.h"
 #include "Texture.h"
 #include "../Engine/Palette.h"
@@ -35,7 +36,7 @@ namespace OpenXcom
 /**
  * Creates a blank ruleset for globe contents.
  */
-RuleGlobe::RuleGlobe()
+RuleGlobe::RuleGlobe() : _polygonIndex(new PolygonIndex())
 {
 }
 
@@ -56,6 +57,7 @@ RuleGlobe::~RuleGlobe()
 	{
 		delete i->second;
 	}
+	delete _polygonIndex;
 }
 
 /**
@@ -87,6 +89,10 @@ void RuleGlobe::load(const YAML::Node &node)
 			_polygons.push_back(polygon);
 		}
 	}
+	if (node["data"] || node["polygons"])
+	{
+		_polygonIndex->build(&_polygons);
+	}
 	if (node["polylines"])
 	{
 		for (std::list<Polyline*>::iterator i = _polylines.begin(); i != _polylines.end(); ++i)
@@ -136,6 +142,16 @@ std::list<Polygon*> *RuleGlobe::getPolygons()
 	return &_polygons;
 }
 
+/**
+ * Returns the spatial index used to find
+ * the polygon under a point of the globe.
+ * @return Pointer to the polygon index.
+ */
+const PolygonIndex *RuleGlobe::getPolygonIndex() const
+{
+	return _polygonIndex;
+}
+
 /**
  * Returns the list of polylines in the globe.
  * @return Pointer to the list of polylines.
@@ -28,6 +28,7 @@ namespace OpenXcom
 
 class Polygon;
 class Polyline;
+class PolygonIndex;
 class Texture;
 
 /**
@@ -40,6 +41,7 @@ class RuleGlobe
 private:
 	std::list<Polygon*> _polygons;
 	std::list<Polyline*> _polylines;
+	PolygonIndex *_polygonIndex;
 	std::map<int, Texture*> _textures;
 public:
 	/// Creates a blank globe ruleset.
@@ -50,6 +52,8 @@ public:
 	void load(const YAML::Node& node);
 	/// Gets the list of world polygons.
 	std::list<Polygon*> *getPolygons();
+	/// Gets the spatial index of the world polygons.
+	const PolygonIndex *getPolygonIndex() const;
 	/// Gets the list of world polylines.
 	std::list<Polyline*> *getPolylines();
 	/// Loads a set of polygons from a DAT file.
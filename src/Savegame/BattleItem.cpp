@@ -19,6 +19,7 @@
 #include "BattleItem.h"
 #include "BattleUnit.h"
 #include "Tile.h"
+#include "SerializationHelper.h"
 #include "../Mod/RuleItem.h"
 #include "../Mod/RuleInventory.h"
 
@@ -143,6 +144,40 @@ YAML::Node BattleItem::save() const
 	return node;
 }
 
+/**
+ * Loads the item's own values from a binary snapshot.
+ * Links to units, tiles and other items are restored
+ * by the battle.
+ * @param in Snapshot reader.
+ */
+void BattleItem::loadBinary(SnapshotReader &in)
+{
+	_inventoryX = in.readInt();
+	_inventoryY = in.readInt();
+	_ammoQuantity = in.readInt();
+	_painKiller = in.readInt();
+	_heal = in.readInt();
+	_stimulant = in.readInt();
+	_fuseTimer = in.readInt();
+	_droppedOnAlienTurn = in.readInt() != 0;
+}
+
+/**
+ * Saves the item's own values to a binary snapshot.
+ * @param out Snapshot writer.
+ */
+void BattleItem::saveBinary(SnapshotWriter &out) const
+{
+	out.writeInt(_inventoryX);
+	out.writeInt(_inventoryY);
+	out.writeInt(_ammoQuantity);
+	out.writeInt(_painKiller);
+	out.writeInt(_heal);
+	out.writeInt(_stimulant);
+	out.writeInt(_fuseTimer);
+	out.writeInt(_droppedOnAlienTurn);
+}
+
 /**
  * Gets the ruleset for the item's type.
  * @return Pointer to ruleset.
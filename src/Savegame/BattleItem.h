@@ -28,6 +28,8 @@ class RuleItem;
 class RuleInventory;
 class BattleUnit;
 class Tile;
+class SnapshotWriter;
+class SnapshotReader;
 
 /**
  * Represents a single item in the battlescape.
@@ -58,6 +60,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the item to YAML.
 	YAML::Node save() const;
+	/// Loads the item from a binary snapshot.
+	void loadBinary(SnapshotReader &in);
+	/// Saves the item to a binary snapshot.
+	void saveBinary(SnapshotWriter &out) const;
 	/// Gets the item's ruleset.
 	RuleItem *getRules() const;
 	/// Gets the item's ammo quantity
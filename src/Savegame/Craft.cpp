@@ -872,6 +872,16 @@ bool Craft::isDestroyed() const
 	return (_damage >= _rules->getMaxDamage());
 }
 
+/**
+ * Checks if the craft is sitting still, at its base or
+ * patrolling, so the geoscape has nothing to move.
+ * @return Is the craft idle?
+ */
+bool Craft::isIdle() const
+{
+	return !isDestroyed() && _dest == 0 && _takeoff == 0;
+}
+
 /**
  * Returns the amount of space available for
  * soldiers and vehicles.
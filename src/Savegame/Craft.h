@@ -157,6 +157,8 @@ public:
 	bool isInBattlescape() const;
 	/// Gets if craft is destroyed during dogfights.
 	bool isDestroyed() const;
+	/// Gets if the craft is sitting still.
+	bool isIdle() const;
 	/// Gets the amount of space available inside a craft.
 	int getSpaceAvailable() const;
 	/// Gets the amount of space used inside a craft.
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Node.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -104,6 +105,53 @@ YAML::Node Node::save() const
 	return node;
 }
 
+/**
+ * Loads the node from a binary snapshot.
+ * @param in Snapshot reader.
+ */
+void Node::loadBinary(SnapshotReader &in)
+{
+	_id = in.readInt();
+	_pos.x = in.readInt();
+	_pos.y = in.readInt();
+	_pos.z = in.readInt();
+	_type = in.readInt();
+	_rank = in.readInt();
+	_flags = in.readInt();
+	_reserved = in.readInt();
+	_priority = in.readInt();
+	_allocated = in.readInt() != 0;
+	_nodeLinks.resize(in.readCount(4));
+	for (std::vector<int>::iterator i = _nodeLinks.begin(); i != _nodeLinks.end(); ++i)
+	{
+		*i = in.readInt();
+	}
+}
+
+/**
+ * Saves the node to a binary snapshot, with the same
+ * fields as the YAML version.
+ * @param out Snapshot writer.
+ */
+void Node::saveBinary(SnapshotWriter &out) const
+{
+	out.writeInt(_id);
+	out.writeInt(_pos.x);
+	out.writeInt(_pos.y);
+	out.writeInt(_pos.z);
+	out.writeInt(_type);
+	out.writeInt(_rank);
+	out.writeInt(_flags);
+	out.writeInt(_reserved);
+	out.writeInt(_priority);
+	out.writeInt(_allocated);
+	out.writeInt(_nodeLinks.size());
+	for (std::vector<int>::const_iterator i = _nodeLinks.begin(); i != _nodeLinks.end(); ++i)
+	{
+		out.writeInt(*i);
+	}
+}
+
 /**
  * Get the node's id
  * @return unique id
@@ -25,6 +25,9 @@
 namespace OpenXcom
 {
 
+class SnapshotWriter;
+class SnapshotReader;
+
 enum NodeRank{NR_SCOUT=0, NR_XCOM, NR_SOLDIER, NR_NAVIGATOR, NR_LEADER, NR_ENGINEER, NR_MISC1, NR_MEDIC, NR_MISC2};
 
 /**
@@ -60,6 +63,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the node to YAML.
 	YAML::Node save() const;
+	/// Loads the node from a binary snapshot.
+	void loadBinary(SnapshotReader &in);
+	/// Saves the node to a binary snapshot.
+	void saveBinary(SnapshotWriter &out) const;
 	/// get the node's id
 	int getID() const;
 	/// get the node's paths
@@ -18,6 +18,9 @@
  */
 #include <assert.h>
 #include <vector>
+#include <new>
+#include <map>
+#include <cstring>
 #include "BattleItem.h"
 #include "SavedBattleGame.h"
 #include "SavedGame.h"
@@ -27,6 +30,7 @@
 #include "../Mod/MCDPatch.h"
 #include "../Battlescape/Pathfinding.h"
 #include "../Battlescape/TileEngine.h"
+#include "../Battlescape/AIAnalysis.h"
 #include "../Battlescape/BattlescapeState.h"
 #include "../Battlescape/BattlescapeGame.h"
 #include "../Battlescape/Position.h"
@@ -39,6 +43,7 @@
 #include "../Engine/RNG.h"
 #include "../Engine/Options.h"
 #include "../Engine/Logger.h"
+#include "../Engine/Exception.h"
 #include "SerializationHelper.h"
 
 namespace OpenXcom
@@ -47,7 +52,7 @@ namespace OpenXcom
 /**
  * Initializes a brand new battlescape saved game.
  */
-SavedBattleGame::SavedBattleGame() : _battleState(0), _mapsize_x(0), _mapsize_y(0), _mapsize_z(0), _selectedUnit(0), _lastSelectedUnit(0), _pathfinding(0), _tileEngine(0), _globalShade(0), _side(FACTION_PLAYER), _turn(1),
+SavedBattleGame::SavedBattleGame() : _battleState(0), _mapsize_x(0), _mapsize_y(0), _mapsize_z(0), _tiles(0), _tileStore(0), _tileInventories(0), _tileParticles(0), _selectedUnit(0), _lastSelectedUnit(0), _pathfinding(0), _tileEngine(0), _aiAnalysis(0), _globalShade(0), _side(FACTION_PLAYER), _turn(1), _seed(0),
                                      _debugMode(false), _aborted(false), _itemId(0), _objectiveType(-1), _objectivesDestroyed(0), _objectivesNeeded(0), _unitsFalling(false), _cheating(false), _tuReserved(BA_NONE), _kneelReserved(false), _depth(0), _ambience(-1), _ambientVolume(0.5)
 {
 	_tileSearch.resize(11*11);
@@ -63,15 +68,11 @@ SavedBattleGame::SavedBattleGame() : _battleState(0), _mapsize_x(0), _mapsize_y(
  */
 SavedBattleGame::~SavedBattleGame()
 {
-	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
-	{
-		delete _tiles[i];
-	}
-	delete[] _tiles;
+	deleteTiles();
 
 	for (std::vector<MapDataSet*>::iterator i = _mapDataSets.begin(); i != _mapDataSets.end(); ++i)
 	{
-		(*i)->unloadData();
+		(*i)->releaseData();
 	}
 
 	for (std::vector<Node*>::iterator i = _nodes.begin(); i != _nodes.end(); ++i)
@@ -103,6 +104,29 @@ SavedBattleGame::~SavedBattleGame()
 
 	delete _pathfinding;
 	delete _tileEngine;
+	delete _aiAnalysis;
+}
+
+/**
+ * Loads the packed tile data of a saved battle.
+ * @param tiles Tiles of the map.
+ * @param mapSize Number of tiles in the map.
+ * @param data Pointer to the tile data.
+ * @param totalTiles Number of tiles in the data.
+ * @param serKey Key to how the tiles were packed.
+ */
+static void loadTiles(Tile **tiles, int mapSize, Uint8 *data, size_t totalTiles, Tile::SerializationKey &serKey)
+{
+	Uint8 *r = data;
+	Uint8 *dataEnd = r + totalTiles * serKey.totalBytes;
+
+	while (r < dataEnd)
+	{
+		int index = unserializeInt(&r, serKey.index);
+		assert (index >= 0 && index < mapSize);
+		tiles[index]->loadBinary(r, serKey); // loadBinary's privileges to advance *r have been revoked
+		r += serKey.totalBytes-serKey.index; // r is now incremented strictly by totalBytes in case there are obsolete fields present in the data
+	}
 }
 
 /**
@@ -119,6 +143,7 @@ void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGam
 	_missionType = node["missionType"].as<std::string>(_missionType);
 	_globalShade = node["globalshade"].as<int>(_globalShade);
 	_turn = node["turn"].as<int>(_turn);
+	_seed = node["seed"].as<uint64_t>(_seed);
 	_depth = node["depth"].as<int>(_depth);
 	int selectedUnit = node["selectedUnit"].as<int>();
 
@@ -157,17 +182,7 @@ void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGam
 
 		// load binary tile data!
 		YAML::Binary binTiles = node["binTiles"].as<YAML::Binary>();
-
-		Uint8 *r = (Uint8*)binTiles.data();
-		Uint8 *dataEnd = r + totalTiles * serKey.totalBytes;
-
-		while (r < dataEnd)
-		{
-			int index = unserializeInt(&r, serKey.index);
-			assert (index >= 0 && index < _mapsize_x * _mapsize_z * _mapsize_y);
-			_tiles[index]->loadBinary(r, serKey); // loadBinary's privileges to advance *r have been revoked
-			r += serKey.totalBytes-serKey.index; // r is now incremented strictly by totalBytes in case there are obsolete fields present in the data
-		}
+		loadTiles(_tiles, _mapsize_x * _mapsize_y * _mapsize_z, (Uint8*)binTiles.data(), totalTiles, serKey);
 	}
 	if (_missionType == "STR_BASE_DEFENSE")
 	{
@@ -189,55 +204,7 @@ void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGam
 		_nodes.push_back(n);
 	}
 
-	for (YAML::const_iterator i = node["units"].begin(); i != node["units"].end(); ++i)
-	{
-		UnitFaction faction = (UnitFaction)(*i)["faction"].as<int>();
-		UnitFaction originalFaction = (UnitFaction)(*i)["originalFaction"].as<int>(faction);
-		int id = (*i)["id"].as<int>();
-		BattleUnit *unit;
-		if (id < BattleUnit::MAX_SOLDIER_ID) // Unit is linked to a geoscape soldier
-		{
-			// look up the matching soldier
-			unit = new BattleUnit(savedGame->getSoldier(id), _depth);
-		}
-		else
-		{
-			std::string type = (*i)["genUnitType"].as<std::string>();
-			std::string armor = (*i)["genUnitArmor"].as<std::string>();
-			// create a new Unit.
-			if(!mod->getUnit(type) || !mod->getArmor(armor)) continue;
-			unit = new BattleUnit(mod->getUnit(type), originalFaction, id, mod->getArmor(armor), mod->getStatAdjustment(savedGame->getDifficulty()), _depth);
-		}
-		unit->load(*i);
-		unit->setSpecialWeapon(this, mod);
-		_units.push_back(unit);
-		if (faction == FACTION_PLAYER)
-		{
-			if ((unit->getId() == selectedUnit) || (_selectedUnit == 0 && !unit->isOut()))
-				_selectedUnit = unit;
-		}
-		if (unit->getStatus() != STATUS_DEAD)
-		{
-			if (const YAML::Node &ai = (*i)["AI"])
-			{
-				BattleAIState *aiState;
-				if (faction == FACTION_NEUTRAL)
-				{
-					aiState = new CivilianBAIState(this, unit, 0);
-				}
-				else if (faction == FACTION_HOSTILE)
-				{
-					aiState = new AlienBAIState(this, unit, 0);
-				}
-				else
-				{
-					continue;
-				}
-				aiState->load(ai);
-				unit->setAIState(aiState);
-			}
-		}
-	}
+	loadUnits(node["units"], mod, savedGame, selectedUnit);
 	// matches up tiles and units
 	resetUnitTiles();
 
@@ -323,6 +290,66 @@ void SavedBattleGame::load(const YAML::Node &node, Mod *mod, SavedGame* savedGam
 	_music = node["music"].as<std::string>(_music);
 }
 
+/**
+ * Loads the units of a saved battle, along with their AI.
+ * @param units YAML list of units.
+ * @param mod Mod for the saved game.
+ * @param savedGame Pointer to the saved game.
+ * @param selectedUnit ID of the selected unit.
+ */
+void SavedBattleGame::loadUnits(const YAML::Node &units, Mod *mod, SavedGame *savedGame, int selectedUnit)
+{
+	for (YAML::const_iterator i = units.begin(); i != units.end(); ++i)
+	{
+		UnitFaction faction = (UnitFaction)(*i)["faction"].as<int>();
+		UnitFaction originalFaction = (UnitFaction)(*i)["originalFaction"].as<int>(faction);
+		int id = (*i)["id"].as<int>();
+		BattleUnit *unit;
+		if (id < BattleUnit::MAX_SOLDIER_ID) // Unit is linked to a geoscape soldier
+		{
+			// look up the matching soldier
+			unit = new BattleUnit(savedGame->getSoldier(id), _depth);
+		}
+		else
+		{
+			std::string type = (*i)["genUnitType"].as<std::string>();
+			std::string armor = (*i)["genUnitArmor"].as<std::string>();
+			// create a new Unit.
+			if(!mod->getUnit(type) || !mod->getArmor(armor)) continue;
+			unit = new BattleUnit(mod->getUnit(type), originalFaction, id, mod->getArmor(armor), mod->getStatAdjustment(savedGame->getDifficulty()), _depth);
+		}
+		unit->load(*i);
+		unit->setSpecialWeapon(this, mod);
+		_units.push_back(unit);
+		if (faction == FACTION_PLAYER)
+		{
+			if ((unit->getId() == selectedUnit) || (_selectedUnit == 0 && !unit->isOut()))
+				_selectedUnit = unit;
+		}
+		if (unit->getStatus() != STATUS_DEAD)
+		{
+			if (const YAML::Node &ai = (*i)["AI"])
+			{
+				BattleAIState *aiState;
+				if (faction == FACTION_NEUTRAL)
+				{
+					aiState = new CivilianBAIState(this, unit, 0);
+				}
+				else if (faction == FACTION_HOSTILE)
+				{
+					aiState = new AlienBAIState(this, unit, 0);
+				}
+				else
+				{
+					continue;
+				}
+				aiState->load(ai);
+				unit->setAIState(aiState);
+			}
+		}
+	}
+}
+
 /**
  * Loads the resources required by the map in the battle save.
  * @param mod Pointer to the mod.
@@ -331,7 +358,7 @@ void SavedBattleGame::loadMapResources(Mod *mod)
 {
 	for (std::vector<MapDataSet*>::const_iterator i = _mapDataSets.begin(); i != _mapDataSets.end(); ++i)
 	{
-		(*i)->loadData();
+		(*i)->useData();
 		if (mod->getMCDPatch((*i)->getName()))
 		{
 			mod->getMCDPatch((*i)->getName())->modifyData(*i);
@@ -378,6 +405,10 @@ YAML::Node SavedBattleGame::save() const
 	node["missionType"] = _missionType;
 	node["globalshade"] = _globalShade;
 	node["turn"] = _turn;
+	if (_seed)
+	{
+		node["seed"] = _seed;
+	}
 	node["selectedUnit"] = (_selectedUnit?_selectedUnit->getId():-1);
 	for (std::vector<MapDataSet*>::const_iterator i = _mapDataSets.begin(); i != _mapDataSets.end(); ++i)
 	{
@@ -455,6 +486,305 @@ YAML::Node SavedBattleGame::save() const
 	return node;
 }
 
+/**
+ * Loads the saved battle game from a binary snapshot
+ * made by saveBinary().
+ * @param in Snapshot reader.
+ * @param mod Mod for the saved game.
+ * @param savedGame Pointer to saved game.
+ */
+void SavedBattleGame::loadBinary(SnapshotReader &in, Mod *mod, SavedGame *savedGame)
+{
+	_mapsize_x = in.readInt();
+	_mapsize_y = in.readInt();
+	_mapsize_z = in.readInt();
+	_missionType = in.readString();
+	_globalShade = in.readInt();
+	_turn = in.readInt();
+	_seed = (Uint32)in.readInt();
+	_seed |= (uint64_t)(Uint32)in.readInt() << 32;
+	int selectedUnit = in.readInt();
+	_depth = in.readInt();
+	_objectiveType = in.readInt();
+	_objectivesDestroyed = in.readInt();
+	_objectivesNeeded = in.readInt();
+	_tuReserved = (BattleActionType)in.readInt();
+	_kneelReserved = in.readInt() != 0;
+	_ambience = in.readInt();
+	_ambientVolume = in.readDouble();
+	_music = in.readString();
+
+	for (int i = in.readCount(4); i > 0; --i)
+	{
+		_mapDataSets.push_back(mod->getMapDataSet(in.readString()));
+	}
+
+	initMap(_mapsize_x, _mapsize_y, _mapsize_z);
+
+	Tile::SerializationKey serKey;
+	memset(&serKey, 0, sizeof(Tile::SerializationKey));
+	serKey.index = in.readInt();
+	serKey.totalBytes = in.readInt();
+	serKey._fire = in.readInt();
+	serKey._smoke = in.readInt();
+	serKey._mapDataID = in.readInt();
+	serKey._mapDataSetID = in.readInt();
+	serKey.boolFields = in.readInt();
+	size_t totalTiles = in.readInt();
+	SnapshotReader tiles = in.readBlock();
+	if (serKey.totalBytes == 0 || tiles.getSize() != totalTiles * serKey.totalBytes)
+	{
+		throw Exception("Invalid tile data in battle snapshot");
+	}
+	loadTiles(_tiles, _mapsize_x * _mapsize_y * _mapsize_z, (Uint8*)tiles.getData(), totalTiles, serKey);
+
+	_baseModules.resize(in.readCount(4));
+	for (std::vector< std::vector<std::pair<int, int> > >::iterator i = _baseModules.begin(); i != _baseModules.end(); ++i)
+	{
+		i->resize(in.readCount(8));
+		for (std::vector<std::pair<int, int> >::iterator j = i->begin(); j != i->end(); ++j)
+		{
+			j->first = in.readInt();
+			j->second = in.readInt();
+		}
+	}
+
+	for (int i = in.readCount(4); i > 0; --i)
+	{
+		Node *n = new Node();
+		n->loadBinary(in);
+		_nodes.push_back(n);
+	}
+
+	loadUnits(YAML::Load(in.readString()), mod, savedGame, selectedUnit);
+	// matches up tiles and units
+	resetUnitTiles();
+
+	std::map<int, BattleUnit*> units;
+	for (std::vector<BattleUnit*>::iterator i = _units.begin(); i != _units.end(); ++i)
+	{
+		units[(*i)->getId()] = *i;
+	}
+	std::vector<RuleItem*> types;
+	for (int i = in.readCount(4); i > 0; --i)
+	{
+		types.push_back(mod->getItem(in.readString()));
+	}
+	std::vector<RuleInventory*> slots;
+	for (int i = in.readCount(4); i > 0; --i)
+	{
+		slots.push_back(mod->getInventory(in.readString()));
+	}
+
+	std::vector<BattleItem*> *toContainer[3] = {&_items, &_recoverConditional, &_recoverGuaranteed};
+	std::map<int, BattleItem*> itemIds;
+	std::vector<std::pair<BattleItem*, int> > ammo;
+	for (int pass = 0; pass != 3; ++pass)
+	{
+		for (int i = in.readCount(4); i > 0; --i)
+		{
+			int id = in.readInt();
+			int type = in.readInt();
+			int slot = in.readInt();
+			int owner = in.readInt();
+			int prevOwner = in.readInt();
+			int unit = in.readInt();
+			Position pos;
+			pos.x = in.readInt();
+			pos.y = in.readInt();
+			pos.z = in.readInt();
+			int ammoItem = in.readInt();
+			if (type < 0 || type >= (int)types.size() || slot < -1 || slot >= (int)slots.size())
+			{
+				throw Exception("Invalid item in battle snapshot");
+			}
+			_itemId = id;
+			BattleItem *item = new BattleItem(types[type], &_itemId);
+			item->loadBinary(in);
+			if (types[type] == 0)
+			{
+				// the item isn't in the mod anymore
+				delete item;
+				continue;
+			}
+			if (slot != -1)
+				item->setSlot(slots[slot]);
+
+			// match up items and units
+			std::map<int, BattleUnit*>::iterator bu = units.find(owner);
+			if (bu != units.end())
+			{
+				item->moveToOwner(bu->second);
+			}
+			bu = units.find(unit);
+			if (bu != units.end())
+			{
+				item->setUnit(bu->second);
+			}
+			bu = units.find(prevOwner);
+			if (bu != units.end())
+			{
+				item->setPreviousOwner(bu->second);
+			}
+
+			// match up items and tiles
+			if (item->getSlot() && item->getSlot()->getType() == INV_GROUND)
+			{
+				if (pos.x != -1)
+					getTile(pos)->addItem(item, mod->getInventory("STR_GROUND"));
+			}
+			toContainer[pass]->push_back(item);
+			if (pass == 0)
+			{
+				itemIds[item->getId()] = item;
+				ammo.push_back(std::make_pair(item, ammoItem));
+			}
+		}
+	}
+
+	// tie ammo items to their weapons
+	for (std::vector<std::pair<BattleItem*, int> >::iterator i = ammo.begin(); i != ammo.end(); ++i)
+	{
+		std::map<int, BattleItem*>::iterator ammoi = itemIds.find(i->second);
+		if (i->second != -1 && ammoi != itemIds.end())
+		{
+			i->first->setAmmoItem(ammoi->second);
+		}
+	}
+}
+
+/**
+ * Saves the saved battle game to a binary snapshot. The tiles
+ * are stored packed like in the YAML save, item types and
+ * inventory slots go in tables and are referred to by index.
+ * Units keep their YAML form, as they carry the AI state and
+ * the links to their soldiers.
+ * @param out Snapshot writer.
+ */
+void SavedBattleGame::saveBinary(SnapshotWriter &out) const
+{
+	out.writeInt(_mapsize_x);
+	out.writeInt(_mapsize_y);
+	out.writeInt(_mapsize_z);
+	out.writeString(_missionType);
+	out.writeInt(_globalShade);
+	out.writeInt(_turn);
+	out.writeInt((int)(Uint32)_seed);
+	out.writeInt((int)(Uint32)(_seed >> 32));
+	out.writeInt(_selectedUnit?_selectedUnit->getId():-1);
+	out.writeInt(_depth);
+	out.writeInt(_objectiveType);
+	out.writeInt(_objectivesDestroyed);
+	out.writeInt(_objectivesNeeded);
+	out.writeInt((int)_tuReserved);
+	out.writeInt(_kneelReserved);
+	out.writeInt(_ambience);
+	out.writeDouble(_ambientVolume);
+	out.writeString(_music);
+
+	out.writeInt(_mapDataSets.size());
+	for (std::vector<MapDataSet*>::const_iterator i = _mapDataSets.begin(); i != _mapDataSets.end(); ++i)
+	{
+		out.writeString((*i)->getName());
+	}
+
+	out.writeInt(Tile::serializationKey.index);
+	out.writeInt(Tile::serializationKey.totalBytes);
+	out.writeInt(Tile::serializationKey._fire);
+	out.writeInt(Tile::serializationKey._smoke);
+	out.writeInt(Tile::serializationKey._mapDataID);
+	out.writeInt(Tile::serializationKey._mapDataSetID);
+	out.writeInt(Tile::serializationKey.boolFields);
+	std::vector<Uint8> tileData(Tile::serializationKey.totalBytes * _mapsize_z * _mapsize_y * _mapsize_x);
+	Uint8 *w = tileData.empty() ? 0 : &tileData[0];
+	int totalTiles = 0;
+	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
+	{
+		if (!_tiles[i]->isVoid())
+		{
+			serializeInt(&w, Tile::serializationKey.index, i);
+			_tiles[i]->saveBinary(&w);
+			totalTiles++;
+		}
+	}
+	out.writeInt(totalTiles);
+	out.writeBlock(tileData.empty() ? 0 : &tileData[0], totalTiles * Tile::serializationKey.totalBytes);
+
+	out.writeInt(_baseModules.size());
+	for (std::vector< std::vector<std::pair<int, int> > >::const_iterator i = _baseModules.begin(); i != _baseModules.end(); ++i)
+	{
+		out.writeInt(i->size());
+		for (std::vector<std::pair<int, int> >::const_iterator j = i->begin(); j != i->end(); ++j)
+		{
+			out.writeInt(j->first);
+			out.writeInt(j->second);
+		}
+	}
+
+	out.writeInt(_nodes.size());
+	for (std::vector<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
+	{
+		(*i)->saveBinary(out);
+	}
+
+	YAML::Node units;
+	for (std::vector<BattleUnit*>::const_iterator i = _units.begin(); i != _units.end(); ++i)
+	{
+		units.push_back((*i)->save());
+	}
+	YAML::Emitter emitter;
+	emitter << units;
+	out.writeString(emitter.c_str());
+
+	const std::vector<BattleItem*> *fromContainer[3] = {&_items, &_recoverConditional, &_recoverGuaranteed};
+	std::map<std::string, int> typeIds, slotIds;
+	std::vector<std::string> types, slots;
+	for (int pass = 0; pass != 3; ++pass)
+	{
+		for (std::vector<BattleItem*>::const_iterator i = fromContainer[pass]->begin(); i != fromContainer[pass]->end(); ++i)
+		{
+			if (typeIds.insert(std::make_pair((*i)->getRules()->getType(), (int)types.size())).second)
+			{
+				types.push_back((*i)->getRules()->getType());
+			}
+			if ((*i)->getSlot() && slotIds.insert(std::make_pair((*i)->getSlot()->getId(), (int)slots.size())).second)
+			{
+				slots.push_back((*i)->getSlot()->getId());
+			}
+		}
+	}
+	out.writeInt(types.size());
+	for (std::vector<std::string>::const_iterator i = types.begin(); i != types.end(); ++i)
+	{
+		out.writeString(*i);
+	}
+	out.writeInt(slots.size());
+	for (std::vector<std::string>::const_iterator i = slots.begin(); i != slots.end(); ++i)
+	{
+		out.writeString(*i);
+	}
+	for (int pass = 0; pass != 3; ++pass)
+	{
+		out.writeInt(fromContainer[pass]->size());
+		for (std::vector<BattleItem*>::const_iterator i = fromContainer[pass]->begin(); i != fromContainer[pass]->end(); ++i)
+		{
+			BattleItem *item = *i;
+			Position pos = item->getTile() ? item->getTile()->getPosition() : Position(-1, -1, -1);
+			out.writeInt(item->getId());
+			out.writeInt(typeIds[item->getRules()->getType()]);
+			out.writeInt(item->getSlot() ? slotIds[item->getSlot()->getId()] : -1);
+			out.writeInt(item->getOwner() ? item->getOwner()->getId() : -1);
+			out.writeInt(item->getPreviousOwner() ? item->getPreviousOwner()->getId() : -1);
+			out.writeInt(item->getUnit() ? item->getUnit()->getId() : -1);
+			out.writeInt(pos.x);
+			out.writeInt(pos.y);
+			out.writeInt(pos.z);
+			out.writeInt(item->getAmmoItem() ? item->getAmmoItem()->getId() : -1);
+			item->saveBinary(out);
+		}
+	}
+}
+
 /**
  * Gets the array of tiles.
  * @return A pointer to the Tile array.
@@ -464,6 +794,28 @@ Tile **SavedBattleGame::getTiles() const
 	return _tiles;
 }
 
+/**
+ * Destroys the tiles of the map and frees their storage.
+ */
+void SavedBattleGame::deleteTiles()
+{
+	if (_tileStore)
+	{
+		for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
+		{
+			_tileStore[i].~Tile();
+		}
+		::operator delete(_tileStore);
+		_tileStore = 0;
+	}
+	delete[] _tileInventories;
+	_tileInventories = 0;
+	delete[] _tileParticles;
+	_tileParticles = 0;
+	delete[] _tiles;
+	_tiles = 0;
+}
+
 /**
  * Initializes the array of tiles and creates a pathfinding object.
  * @param mapsize_x
@@ -472,34 +824,40 @@ Tile **SavedBattleGame::getTiles() const
  */
 void SavedBattleGame::initMap(int mapsize_x, int mapsize_y, int mapsize_z)
 {
+	deleteTiles();
 	if (!_nodes.empty())
 	{
-		for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
-		{
-			delete _tiles[i];
-		}
-		delete[] _tiles;
-
 		for (std::vector<Node*>::iterator i = _nodes.begin(); i != _nodes.end(); ++i)
 		{
 			delete *i;
 		}
 
 		_nodes.clear();
+		for (std::vector<MapDataSet*>::iterator i = _mapDataSets.begin(); i != _mapDataSets.end(); ++i)
+		{
+			(*i)->releaseData();
+		}
 		_mapDataSets.clear();
 	}
 	_mapsize_x = mapsize_x;
 	_mapsize_y = mapsize_y;
 	_mapsize_z = mapsize_z;
 	_tiles = new Tile*[_mapsize_z * _mapsize_y * _mapsize_x];
-	/* create tile objects */
+	/* create tile objects, all in one block so they're laid out in map order,
+	   with their item and particle lists kept apart in tables of the same order */
+	_tileStore = static_cast<Tile*>(::operator new(sizeof(Tile) * _mapsize_z * _mapsize_y * _mapsize_x));
+	_tileInventories = new std::vector<BattleItem*>[_mapsize_z * _mapsize_y * _mapsize_x];
+	_tileParticles = new std::list<Particle*>[_mapsize_z * _mapsize_y * _mapsize_x];
 	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
 	{
 		Position pos;
 		getTileCoords(i, &pos.x, &pos.y, &pos.z);
-		_tiles[i] = new Tile(pos);
+		_tiles[i] = new (&_tileStore[i]) Tile(pos, &_tileInventories[i], &_tileParticles[i]);
+	}
+	if (_tileEngine)
+	{
+		_tileEngine->resetLighting();
 	}
-
 }
 
 /**
@@ -510,8 +868,10 @@ void SavedBattleGame::initUtilities(Mod *mod)
 {
 	delete _pathfinding;
 	delete _tileEngine;
+	delete _aiAnalysis;
 	_pathfinding = new Pathfinding(this);
 	_tileEngine = new TileEngine(this, mod->getVoxelData());
+	_aiAnalysis = new AIAnalysis(this, _pathfinding);
 }
 
 /**
@@ -775,6 +1135,15 @@ TileEngine *SavedBattleGame::getTileEngine() const
 	return _tileEngine;
 }
 
+/**
+ * Gets what the AI worked out so far this turn.
+ * @return Pointer to the AI analysis.
+ */
+AIAnalysis *SavedBattleGame::getAIAnalysis() const
+{
+	return _aiAnalysis;
+}
+
 /**
  * Gets the array of mapblocks.
  * @return Pointer to the array of mapblocks.
@@ -802,6 +1171,21 @@ int SavedBattleGame::getTurn() const
 	return _turn;
 }
 
+/**
+ * Gets the seed the AI's random streams are made from.
+ * It's picked from the game's generator the first time
+ * it's needed, and saved with the battle from then on.
+ * @return The battle seed.
+ */
+uint64_t SavedBattleGame::getSeed()
+{
+	if (_seed == 0)
+	{
+		_seed = RNG::next();
+	}
+	return _seed;
+}
+
 /**
  * Ends the current turn and progresses to the next one.
  */
@@ -1182,9 +1566,11 @@ Node *SavedBattleGame::getSpawnNode(int nodeRank, BattleUnit *unit)
  * @param scout Is the unit scouting?
  * @param unit Pointer to the unit (to get its position).
  * @param fromNode Pointer to the node the unit is at.
+ * @param pathfinding Pathfinding to check large units with, 0 for the battle's.
+ * @param random Random stream to pick with, 0 for the game's generator.
  * @return Pointer to the chosen node.
  */
-Node *SavedBattleGame::getPatrolNode(bool scout, BattleUnit *unit, Node *fromNode)
+Node *SavedBattleGame::getPatrolNode(bool scout, BattleUnit *unit, Node *fromNode, Pathfinding *pathfinding, RNG::RandomState *random)
 {
 	std::vector<Node *> compliantNodes;
 	Node *preferred = 0;
@@ -1192,7 +1578,8 @@ Node *SavedBattleGame::getPatrolNode(bool scout, BattleUnit *unit, Node *fromNod
 	if (fromNode == 0)
 	{
 		if (Options::traceAI) { Log(LOG_INFO) << "This alien got lost. :("; }
-		fromNode = getNodes()->at(RNG::generate(0, getNodes()->size() - 1));
+		int pick = random ? random->generate(0, getNodes()->size() - 1) : RNG::generate(0, getNodes()->size() - 1);
+		fromNode = getNodes()->at(pick);
 	}
 
 	// scouts roam all over while all others shuffle around to adjacent nodes at most:
@@ -1208,7 +1595,7 @@ Node *SavedBattleGame::getPatrolNode(bool scout, BattleUnit *unit, Node *fromNod
 			&& (!(n->getType() & Node::TYPE_FLYING) || unit->getMovementType() == MT_FLY)	// the flying unit bit is not set or the unit can fly
 			&& !n->isAllocated()																		// check if not allocated
 			&& !(n->getType() & Node::TYPE_DANGEROUS)													// don't go there if an alien got shot there; stupid behavior like that
-			&& setUnitPosition(unit, n->getPosition(), true)											// check if not already occupied
+			&& setUnitPosition(unit, n->getPosition(), true, pathfinding)								// check if not already occupied
 			&& getTile(n->getPosition()) && !getTile(n->getPosition())->getFire()						// you are not a firefighter; do not patrol into fire
 			&& (unit->getFaction() != FACTION_HOSTILE || !getTile(n->getPosition())->getDangerous())	// aliens don't run into a grenade blast
 			&& (!scout || n != fromNode)																// scouts push forward
@@ -1229,7 +1616,7 @@ Node *SavedBattleGame::getPatrolNode(bool scout, BattleUnit *unit, Node *fromNod
 		if (Options::traceAI) { Log(LOG_INFO) << (scout ? "Scout " : "Guard") << " found on patrol node! XXX XXX XXX"; }
 		if (unit->getArmor()->getSize() > 1 && !scout)
 		{
-			return getPatrolNode(true, unit, fromNode); // move dammit
+			return getPatrolNode(true, unit, fromNode, pathfinding, random); // move dammit
 		}
 		else
 			return 0;
@@ -1238,7 +1625,8 @@ Node *SavedBattleGame::getPatrolNode(bool scout, BattleUnit *unit, Node *fromNod
 	if (scout)
 	{
 		// scout picks a random destination:
-		return compliantNodes[RNG::generate(0, compliantNodes.size() - 1)];
+		int pick = random ? random->generate(0, compliantNodes.size() - 1) : RNG::generate(0, compliantNodes.size() - 1);
+		return compliantNodes[pick];
 	}
 	else
 	{
@@ -1468,9 +1856,10 @@ void SavedBattleGame::removeUnconsciousBodyItem(BattleUnit *bu)
  * @param bu The unit to be placed.
  * @param position The position to place the unit.
  * @param testOnly If true then just checks if the unit can be placed at the position.
+ * @param pathfinding Pathfinding to check large units with, 0 for the battle's.
  * @return True if the unit could be successfully placed.
  */
-bool SavedBattleGame::setUnitPosition(BattleUnit *bu, const Position &position, bool testOnly)
+bool SavedBattleGame::setUnitPosition(BattleUnit *bu, const Position &position, bool testOnly, Pathfinding *pathfinding)
 {
 	int size = bu->getArmor()->getSize() - 1;
 	Position zOffset (0,0,0);
@@ -1501,10 +1890,14 @@ bool SavedBattleGame::setUnitPosition(BattleUnit *bu, const Position &position,
 
 	if (size > 0)
 	{
-		getPathfinding()->setUnit(bu);
+		if (pathfinding == 0)
+		{
+			pathfinding = getPathfinding();
+		}
+		pathfinding->setUnit(bu);
 		for (int dir = 2; dir <= 4; ++dir)
 		{
-			if (getPathfinding()->isBlocked(getTile(position + zOffset), 0, dir, 0))
+			if (pathfinding->isBlocked(getTile(position + zOffset), 0, dir, 0))
 				return false;
 		}
 	}
@@ -19,10 +19,12 @@
 #ifndef OPENXCOM_SAVEDBATTLEGAME_H
 #define OPENXCOM_SAVEDBATTLEGAME_H
 
+#include <list>
 #include <vector>
 #include <string>
 #include <yaml-cpp/yaml.h>
 #include "BattleUnit.h"
+#include "../Engine/RNG.h"
 
 namespace OpenXcom
 {
@@ -35,9 +37,13 @@ class BattlescapeState;
 class Position;
 class Pathfinding;
 class TileEngine;
+class AIAnalysis;
 class BattleItem;
+class Particle;
 class Mod;
 class State;
+class SnapshotWriter;
+class SnapshotReader;
 
 /**
  * The battlescape data that gets written to disk when the game is saved.
@@ -51,16 +57,21 @@ private:
 	int _mapsize_x, _mapsize_y, _mapsize_z;
 	std::vector<MapDataSet*> _mapDataSets;
 	Tile **_tiles;
+	Tile *_tileStore;
+	std::vector<BattleItem*> *_tileInventories;
+	std::list<Particle*> *_tileParticles;
 	BattleUnit *_selectedUnit, *_lastSelectedUnit;
 	std::vector<Node*> _nodes;
 	std::vector<BattleUnit*> _units;
 	std::vector<BattleItem*> _items, _deleted;
 	Pathfinding *_pathfinding;
 	TileEngine *_tileEngine;
+	AIAnalysis *_aiAnalysis;
 	std::string _missionType;
 	int _globalShade;
 	UnitFaction _side;
 	int _turn;
+	uint64_t _seed;
 	bool _debugMode;
 	bool _aborted;
 	int _itemId;
@@ -76,8 +87,12 @@ private:
 	double _ambientVolume;
 	std::vector<BattleItem*> _recoverGuaranteed, _recoverConditional;
 	std::string _music;
+	/// Destroys the tiles of the map.
+	void deleteTiles();
 	/// Selects a soldier.
 	BattleUnit *selectPlayerUnit(int dir, bool checkReselect = false, bool setReselect = false, bool checkInventory = false);
+	/// Loads the units from YAML.
+	void loadUnits(const YAML::Node &units, Mod *mod, SavedGame *savedGame, int selectedUnit);
 public:
 	/// Creates a new battle save, based on the current generic save.
 	SavedBattleGame();
@@ -87,6 +102,10 @@ public:
 	void load(const YAML::Node& node, Mod *mod, SavedGame* savedGame);
 	/// Saves a saved battle game to YAML.
 	YAML::Node save() const;
+	/// Loads a saved battle game from a binary snapshot.
+	void loadBinary(SnapshotReader &in, Mod *mod, SavedGame *savedGame);
+	/// Saves a saved battle game to a binary snapshot.
+	void saveBinary(SnapshotWriter &out) const;
 	/// Sets the dimensions of the map and initializes it.
 	void initMap(int mapsize_x, int mapsize_y, int mapsize_z);
 	/// Initialises the pathfinding and tileengine.
@@ -162,10 +181,14 @@ public:
 	Pathfinding *getPathfinding() const;
 	/// Gets a pointer to the tileengine.
 	TileEngine *getTileEngine() const;
+	/// Gets the AI analysis.
+	AIAnalysis *getAIAnalysis() const;
 	/// Gets the playing side.
 	UnitFaction getSide() const;
 	/// Gets the turn number.
 	int getTurn() const;
+	/// Gets the seed of the AI random streams.
+	uint64_t getSeed();
 	/// Ends the turn.
 	void endTurn();
 	/// Sets debug mode.
@@ -193,7 +216,7 @@ public:
 	/// Gets a spawn node.
 	Node *getSpawnNode(int nodeRank, BattleUnit *unit);
 	/// Gets a patrol node.
-	Node *getPatrolNode(bool scout, BattleUnit *unit, Node *fromNode);
+	Node *getPatrolNode(bool scout, BattleUnit *unit, Node *fromNode, Pathfinding *pathfinding = 0, RNG::RandomState *random = 0);
 	/// Carries out new turn preparations.
 	void prepareNewTurn();
 	/// Revives unconscious units (healthcheck).
@@ -201,7 +224,7 @@ public:
 	/// Removes the body item that corresponds to the unit.
 	void removeUnconsciousBodyItem(BattleUnit *bu);
 	/// Sets or tries to set a unit of a certain size on a certain position of the map.
-	bool setUnitPosition(BattleUnit *bu, const Position &position, bool testOnly = false);
+	bool setUnitPosition(BattleUnit *bu, const Position &position, bool testOnly = false, Pathfinding *pathfinding = 0);
 	/// Adds this unit to the vector of falling units.
 	bool addFallingUnit(BattleUnit* unit);
 	/// Gets the vector of falling units.
@@ -21,6 +21,8 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <iterator>
+#include <cstring>
 #include <yaml-cpp/yaml.h>
 #include "../version.h"
 #include "../Engine/Logger.h"
@@ -62,6 +64,93 @@ const std::string SavedGame::AUTOSAVE_GEOSCAPE = "_autogeo_.asav",
    				  SavedGame::AUTOSAVE_BATTLESCAPE = "_autobattle_.asav",
 				  SavedGame::QUICKSAVE = "_quick_.asav";
 
+namespace
+{
+
+/// Marks a save file holding a binary snapshot instead of YAML.
+const char SNAPSHOT_MAGIC[4] = {'O', 'X', 'C', 'S'};
+const int SNAPSHOT_VERSION = 2;
+
+/**
+ * Checks if a save file gets written as a binary snapshot.
+ * Quick saves and autosaves are, as they're only ever loaded
+ * by the game, the rest stay YAML so players can edit them.
+ * @param filename Save filename.
+ * @return True for a snapshot.
+ */
+bool isSnapshotFile(const std::string &filename)
+{
+	const std::string ext = ".asav";
+	return filename.size() >= ext.size() && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+/**
+ * Reads a save file if it's a binary snapshot.
+ * @param path Full path to the save file.
+ * @param data Gets the snapshot data, minus the magic number.
+ * @return True if the file is a snapshot.
+ */
+bool loadSnapshot(const std::string &path, std::vector<Uint8> &data)
+{
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	char magic[sizeof(SNAPSHOT_MAGIC)];
+	if (!file || !file.read(magic, sizeof(magic)) || memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0)
+	{
+		return false;
+	}
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	if (data.empty())
+	{
+		throw Exception(path + " is truncated");
+	}
+	return true;
+}
+
+/**
+ * Reads just the brief of a save file if it's a binary snapshot.
+ * Snapshots start with a fixed header (magic number, version
+ * and brief size) followed by the brief, so the rest of the
+ * file doesn't need to be read to list the save.
+ * @param path Full path to the save file.
+ * @param brief Gets the brief YAML document.
+ * @return True if the file is a snapshot.
+ */
+bool loadSnapshotBrief(const std::string &path, std::string &brief)
+{
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	char magic[sizeof(SNAPSHOT_MAGIC)];
+	if (!file || !file.read(magic, sizeof(magic)) || memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0)
+	{
+		return false;
+	}
+	Uint8 header[8];
+	if (!file.read((char*)header, sizeof(header)))
+	{
+		throw Exception(path + " is truncated");
+	}
+	SnapshotReader in(header, sizeof(header));
+	if (in.readInt() != SNAPSHOT_VERSION)
+	{
+		throw Exception(path + " is not a vaild save file");
+	}
+	size_t size = (Uint32)in.readInt();
+	std::streampos start = file.tellg();
+	file.seekg(0, std::ios::end);
+	if ((size_t)(file.tellg() - start) < size)
+	{
+		throw Exception(path + " is truncated");
+	}
+	file.seekg(start);
+	brief.resize(size);
+	if (size > 0 && !file.read(&brief[0], size))
+	{
+		throw Exception(path + " is truncated");
+	}
+	return true;
+}
+
+}
+
 struct findRuleResearch : public std::unary_function<ResearchProject *,
 								bool>
 {
@@ -236,7 +325,16 @@ std::vector<SaveInfo> SavedGame::getList(Language *lang, bool autoquick)
 SaveInfo SavedGame::getSaveInfo(const std::string &file, Language *lang)
 {
 	std::string fullname = Options::getMasterUserFolder() + file;
-	YAML::Node doc = YAML::LoadFile(fullname);
+	YAML::Node doc;
+	std::string brief;
+	if (loadSnapshotBrief(fullname, brief))
+	{
+		doc = YAML::Load(brief);
+	}
+	else
+	{
+		doc = YAML::LoadFile(fullname);
+	}
 	SaveInfo save;
 
 	save.fileName = file;
@@ -299,15 +397,32 @@ SaveInfo SavedGame::getSaveInfo(const std::string &file, Language *lang)
 }
 
 /**
- * Loads a saved game's contents from a YAML file.
+ * Loads a saved game's contents from a YAML file,
+ * or a binary snapshot for quick saves and autosaves.
  * @note Assumes the saved game is blank.
- * @param filename YAML filename.
+ * @param filename Save filename.
  * @param mod Mod for the saved game.
  */
 void SavedGame::load(const std::string &filename, Mod *mod)
 {
 	std::string s = Options::getMasterUserFolder() + filename;
-	std::vector<YAML::Node> file = YAML::LoadAllFromFile(s);
+	std::vector<YAML::Node> file;
+	std::vector<Uint8> snapshot;
+	SnapshotReader snapshotIn(0, 0);
+	if (loadSnapshot(s, snapshot))
+	{
+		snapshotIn = SnapshotReader(&snapshot[0], snapshot.size());
+		if (snapshotIn.readInt() != SNAPSHOT_VERSION)
+		{
+			throw Exception(filename + " is not a vaild save file");
+		}
+		file.push_back(YAML::Load(snapshotIn.readString()));
+		file.push_back(YAML::Load(snapshotIn.readString()));
+	}
+	else
+	{
+		file = YAML::LoadAllFromFile(s);
+	}
 	if (file.empty())
 	{
 		throw Exception(filename + " is not a vaild save file");
@@ -475,7 +590,16 @@ void SavedGame::load(const std::string &filename, Mod *mod)
 		_missionStatistics.push_back(ms);
 	}
 
-	if (const YAML::Node &battle = doc["battleGame"])
+	if (!snapshot.empty())
+	{
+		if (snapshotIn.readInt() != 0)
+		{
+			SnapshotReader battle = snapshotIn.readBlock();
+			_battleGame = new SavedBattleGame();
+			_battleGame->loadBinary(battle, mod, this);
+		}
+	}
+	else if (const YAML::Node &battle = doc["battleGame"])
 	{
 		_battleGame = new SavedBattleGame();
 		_battleGame->load(battle, mod, this);
@@ -483,13 +607,15 @@ void SavedGame::load(const std::string &filename, Mod *mod)
 }
 
 /**
- * Saves a saved game's contents to a YAML file.
- * @param filename YAML filename.
+ * Saves a saved game's contents to a YAML file,
+ * or a binary snapshot for quick saves and autosaves.
+ * @param filename Save filename.
  */
 void SavedGame::save(const std::string &filename) const
 {
 	std::string s = Options::getMasterUserFolder() + filename;
-	std::ofstream sav(s.c_str());
+	bool snapshot = isSnapshotFile(filename);
+	std::ofstream sav(s.c_str(), snapshot ? std::ios::out | std::ios::binary : std::ios::out);
 	if (!sav)
 	{
 		throw Exception("Failed to save " + filename);
@@ -603,13 +729,41 @@ void SavedGame::save(const std::string &filename) const
 	{
 		node["missionStatistics"].push_back((*i)->save());
 	}
-	if (_battleGame != 0)
+	if (snapshot)
+	{
+		// the battle goes in binary, it makes up most of the save
+		YAML::Emitter briefOut, nodeOut;
+		briefOut << brief;
+		nodeOut << node;
+		// the header and brief come first, so the saves list reads nothing else
+		SnapshotWriter snap;
+		snap.writeInt(SNAPSHOT_VERSION);
+		snap.writeString(briefOut.c_str());
+		snap.writeString(nodeOut.c_str());
+		snap.writeInt(_battleGame != 0);
+		if (_battleGame != 0)
+		{
+			SnapshotWriter battle;
+			_battleGame->saveBinary(battle);
+			snap.writeBlock(&battle.getData()[0], battle.getData().size());
+		}
+		sav.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+		sav.write((const char*)&snap.getData()[0], snap.getData().size());
+	}
+	else
 	{
-		node["battleGame"] = _battleGame->save();
+		if (_battleGame != 0)
+		{
+			node["battleGame"] = _battleGame->save();
+		}
+		out << node;
+		sav << out.c_str();
 	}
-	out << node;
-	sav << out.c_str();
 	sav.close();
+	if (!sav)
+	{
+		throw Exception("Failed to save " + filename);
+	}
 }
 
 /**
@@ -137,9 +137,9 @@ public:
 	~SavedGame();
 	/// Gets list of saves in the user directory.
 	static std::vector<SaveInfo> getList(Language *lang, bool autoquick);
-	/// Loads a saved game from YAML.
+	/// Loads a saved game from YAML or a snapshot.
 	void load(const std::string &filename, Mod *mod);
-	/// Saves a saved game to YAML.
+	/// Saves a saved game to YAML or a snapshot.
 	void save(const std::string &filename) const;
 	/// Gets the game name.
 	std::wstring getName() const;
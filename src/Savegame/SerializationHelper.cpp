@@ -20,6 +20,9 @@
 #include <assert.h>
 #include <sstream>
 #include <limits>
+#include <cstring>
+#include <SDL_endian.h>
+#include "../Engine/Exception.h"
 
 namespace OpenXcom
 {
@@ -83,4 +86,164 @@ std::string serializeDouble(double value)
 	return stream.str();
 }
 
+/**
+ * Writes a 32-bit integer to the snapshot.
+ * @param value Integer value.
+ */
+void SnapshotWriter::writeInt(int value)
+{
+	Uint32 le = SDL_SwapLE32((Uint32)value);
+	const Uint8 *bytes = (const Uint8*)&le;
+	_data.insert(_data.end(), bytes, bytes + sizeof(le));
+}
+
+/**
+ * Writes a double to the snapshot, bit for bit.
+ * @param value Double value.
+ */
+void SnapshotWriter::writeDouble(double value)
+{
+	Uint64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	bits = SDL_SwapLE64(bits);
+	const Uint8 *bytes = (const Uint8*)&bits;
+	_data.insert(_data.end(), bytes, bytes + sizeof(bits));
+}
+
+/**
+ * Writes a string to the snapshot.
+ * @param value String value.
+ */
+void SnapshotWriter::writeString(const std::string &value)
+{
+	writeBlock(value.data(), value.size());
+}
+
+/**
+ * Writes a block of data to the snapshot.
+ * @param data Pointer to the data.
+ * @param size Size of the data in bytes.
+ */
+void SnapshotWriter::writeBlock(const void *data, size_t size)
+{
+	writeInt((int)size);
+	_data.insert(_data.end(), (const Uint8*)data, (const Uint8*)data + size);
+}
+
+/**
+ * Gets the snapshot data written so far.
+ * @return Snapshot data.
+ */
+const std::vector<Uint8> &SnapshotWriter::getData() const
+{
+	return _data;
+}
+
+/**
+ * Creates a reader for some snapshot data.
+ * @param data Pointer to the data.
+ * @param size Size of the data in bytes.
+ */
+SnapshotReader::SnapshotReader(const Uint8 *data, size_t size) : _pos(data), _end(data + size)
+{
+}
+
+/**
+ * Checks there's enough data left to read.
+ * @param size Number of bytes about to be read.
+ */
+void SnapshotReader::check(size_t size) const
+{
+	if ((size_t)(_end - _pos) < size)
+	{
+		throw Exception("Snapshot data is truncated");
+	}
+}
+
+/**
+ * Reads a 32-bit integer from the snapshot.
+ * @return Integer value.
+ */
+int SnapshotReader::readInt()
+{
+	Uint32 le;
+	check(sizeof(le));
+	memcpy(&le, _pos, sizeof(le));
+	_pos += sizeof(le);
+	return (int)SDL_SwapLE32(le);
+}
+
+/**
+ * Reads the number of entries in a list, making sure
+ * the snapshot is big enough to hold them.
+ * @param entrySize Smallest size of an entry in bytes.
+ * @return Number of entries.
+ */
+int SnapshotReader::readCount(size_t entrySize)
+{
+	int count = readInt();
+	if (count < 0 || (size_t)count > getSize() / entrySize)
+	{
+		throw Exception("Snapshot data is truncated");
+	}
+	return count;
+}
+
+/**
+ * Reads a double from the snapshot.
+ * @return Double value.
+ */
+double SnapshotReader::readDouble()
+{
+	Uint64 bits;
+	check(sizeof(bits));
+	memcpy(&bits, _pos, sizeof(bits));
+	_pos += sizeof(bits);
+	bits = SDL_SwapLE64(bits);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/**
+ * Reads a string from the snapshot.
+ * @return String value.
+ */
+std::string SnapshotReader::readString()
+{
+	SnapshotReader block = readBlock();
+	return std::string((const char*)block.getData(), block.getSize());
+}
+
+/**
+ * Reads a block of data from the snapshot.
+ * @return Reader for the data in the block.
+ */
+SnapshotReader SnapshotReader::readBlock()
+{
+	size_t size = (Uint32)readInt();
+	check(size);
+	SnapshotReader block(_pos, size);
+	_pos += size;
+	return block;
+}
+
+/**
+ * Gets the data left to read.
+ * @return Pointer to the data.
+ */
+const Uint8 *SnapshotReader::getData() const
+{
+	return _pos;
+}
+
+/**
+ * Gets the size of the data left to read.
+ * @return Size in bytes.
+ */
+size_t SnapshotReader::getSize() const
+{
+	return _end - _pos;
+}
+
 }
@@ -22,6 +22,7 @@
 
 #include <SDL_types.h>
 #include <string>
+#include <vector>
 
 namespace OpenXcom
 {
@@ -30,6 +31,58 @@ int unserializeInt(Uint8 **buffer, Uint8 sizeKey);
 void serializeInt(Uint8 **buffer, Uint8 sizeKey, int value);
 std::string serializeDouble(double value);
 
+/**
+ * Builds a binary snapshot in memory. Numbers are stored
+ * little-endian and strings and blocks of data are prefixed
+ * with their length, so the snapshot reads the same on
+ * any platform.
+ */
+class SnapshotWriter
+{
+private:
+	std::vector<Uint8> _data;
+public:
+	/// Writes a 32-bit integer.
+	void writeInt(int value);
+	/// Writes a double.
+	void writeDouble(double value);
+	/// Writes a string, prefixed with its length.
+	void writeString(const std::string &value);
+	/// Writes a block of data, prefixed with its length.
+	void writeBlock(const void *data, size_t size);
+	/// Gets the snapshot data.
+	const std::vector<Uint8> &getData() const;
+};
+
+/**
+ * Reads back a binary snapshot built by a SnapshotWriter.
+ * Reading past the end of the data throws an exception.
+ */
+class SnapshotReader
+{
+private:
+	const Uint8 *_pos, *_end;
+	/// Checks there's enough data left.
+	void check(size_t size) const;
+public:
+	/// Creates a reader for some snapshot data.
+	SnapshotReader(const Uint8 *data, size_t size);
+	/// Reads a 32-bit integer.
+	int readInt();
+	/// Reads the number of entries in a list.
+	int readCount(size_t entrySize);
+	/// Reads a double.
+	double readDouble();
+	/// Reads a string.
+	std::string readString();
+	/// Reads a block of data.
+	SnapshotReader readBlock();
+	/// Gets the data left to read.
+	const Uint8 *getData() const;
+	/// Gets the size of the data left to read.
+	size_t getSize() const;
+};
+
 }
 
 #endif
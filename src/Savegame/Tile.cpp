@@ -44,11 +44,17 @@ Tile::SerializationKey Tile::serializationKey =
  4 + 2*4 + 2*4 + 1 + 1 + 1 // total bytes to save one tile
 };
 
+unsigned int Tile::_terrainChanges = 0;
+unsigned int Tile::_fireChanges = 0;
+unsigned int Tile::_hazardChanges = 0;
+
 /**
  * constructor
  * @param pos Position.
+ * @param inventory Side table entry holding the items on this tile.
+ * @param particles Side table entry holding the particles on this tile.
  */
-Tile::Tile(const Position& pos): _smoke(0), _fire(0), _explosive(0), _explosiveType(0), _pos(pos), _unit(0), _animationOffset(0), _markerColor(0), _visible(false), _preview(-1), _TUMarker(-1), _overlaps(0), _danger(false)
+Tile::Tile(const Position& pos, std::vector<BattleItem *> *inventory, std::list<Particle*> *particles): _unit(0), _danger(false), _smoke(0), _fire(0), _visible(false), _animationOffset(0), _pos(pos), _inventory(inventory), _particles(particles), _explosive(0), _explosiveType(0), _markerColor(0), _preview(-1), _TUMarker(-1), _overlaps(0)
 {
 	for (int i = 0; i < 4; ++i)
 	{
@@ -60,12 +66,12 @@ Tile::Tile(const Position& pos): _smoke(0), _fire(0), _explosive(0), _explosiveT
 	for (int layer = 0; layer < LIGHTLAYERS; layer++)
 	{
 		_light[layer] = 0;
-		_lastLight[layer] = -1;
 	}
 	for (int i = 0; i < 3; ++i)
 	{
 		_discovered[i] = false;
 	}
+	touchTerrain();
 }
 
 /**
@@ -73,12 +79,12 @@ Tile::Tile(const Position& pos): _smoke(0), _fire(0), _explosive(0), _explosiveT
  */
 Tile::~Tile()
 {
-	_inventory.clear();
-	for (std::list<Particle*>::iterator i = _particles.begin(); i != _particles.end(); ++i)
+	_inventory->clear();
+	for (std::list<Particle*>::iterator i = _particles->begin(); i != _particles->end(); ++i)
 	{
 		delete *i;
 	}
-	_particles.clear();
+	_particles->clear();
 }
 
 /**
@@ -219,6 +225,7 @@ void Tile::setMapData(MapData *dat, int mapDataID, int mapDataSetID, int part)
 	_objects[part] = dat;
 	_mapDataID[part] = mapDataID;
 	_mapDataSetID[part] = mapDataSetID;
+	touchTerrain();
 }
 
 /**
@@ -240,7 +247,7 @@ void Tile::getMapData(int *mapDataID, int *mapDataSetID, int part) const
  */
 bool Tile::isVoid() const
 {
-	return _objects[0] == 0 && _objects[1] == 0 && _objects[2] == 0 && _objects[3] == 0 && _smoke == 0 && _inventory.empty();
+	return _objects[0] == 0 && _objects[1] == 0 && _objects[2] == 0 && _objects[3] == 0 && _smoke == 0 && _inventory->empty();
 }
 
 /**
@@ -354,6 +361,7 @@ int Tile::openDoor(int part, BattleUnit *unit, BattleActionType reserve)
 		if (unit &&	unit->getTimeUnits() < _objects[part]->getTUCost(unit->getMovementType()) + unit->getActionTUs(reserve, unit->getMainHandWeapon(false)))
 			return 4;
 		_currentFrame[part] = 1; // start opening door
+		touchTerrain();
 		return 1;
 	}
 	if (_objects[part]->isUFODoor() && _currentFrame[part] != 7) // ufo door != part 7 - door is still opening
@@ -372,6 +380,7 @@ int Tile::closeUfoDoor()
 		if (isUfoDoorOpen(part))
 		{
 			_currentFrame[part] = 0;
+			touchTerrain();
 			retval = 1;
 		}
 	}
@@ -420,7 +429,6 @@ bool Tile::isDiscovered(int part) const
 void Tile::resetLight(int layer)
 {
 	_light[layer] = 0;
-	_lastLight[layer] = _light[layer];
 }
 
 /**
@@ -431,7 +439,17 @@ void Tile::resetLight(int layer)
 void Tile::addLight(int light, int layer)
 {
 	if (_light[layer] < light)
-		_light[layer] = light;
+		_light[layer] = std::min(light, (int)MAX_LIGHT);
+}
+
+/**
+ * Set the light amount on the tile, replacing whatever was there.
+ * @param light Amount of light.
+ * @param layer Light is separated in 3 layers: Ambient, Static and Dynamic.
+ */
+void Tile::setLight(int light, int layer)
+{
+	_light[layer] = std::max(0, std::min(light, (int)MAX_LIGHT));
 }
 
 /**
@@ -609,6 +627,8 @@ void Tile::ignite(int power)
 				_smoke = 15 - std::max(1, std::min((getFlammability() / 10), 12));
 				_overlaps = 1;
 				_fire = getFuel() + 1;
+				++_fireChanges;
+				++_hazardChanges;
 				_animationOffset = RNG::generate(0,3);
 			}
 		}
@@ -640,15 +660,20 @@ void Tile::animate()
 			{
 				newframe = 0;
 			}
+			if (_objects[i]->isUFODoor())
+			{
+				// opening ufo doors stop blocking sight
+				touchTerrain();
+			}
 			_currentFrame[i] = newframe;
 		}
 	}
-	for (std::list<Particle*>::iterator i = _particles.begin(); i != _particles.end();)
+	for (std::list<Particle*>::iterator i = _particles->begin(); i != _particles->end();)
 	{
 		if (!(*i)->animate())
 		{
 			delete *i;
-			i = _particles.erase(i);
+			i = _particles->erase(i);
 		}
 		else
 		{
@@ -690,6 +715,10 @@ void Tile::setUnit(BattleUnit *unit, Tile *tileBelow)
  */
 void Tile::setFire(int fire)
 {
+	if (fire != _fire)
+	{
+		++_fireChanges;
+	}
 	_fire = fire;
 	_animationOffset = RNG::generate(0,3);
 }
@@ -719,6 +748,7 @@ void Tile::addSmoke(int smoke)
 		{
 			_smoke += smoke;
 		}
+		++_hazardChanges;
 		_animationOffset = RNG::generate(0,3);
 		addOverlap();
 	}
@@ -730,6 +760,10 @@ void Tile::addSmoke(int smoke)
  */
 void Tile::setSmoke(int smoke)
 {
+	if (smoke != _smoke)
+	{
+		++_hazardChanges;
+	}
 	_smoke = smoke;
 	_animationOffset = RNG::generate(0,3);
 }
@@ -762,7 +796,7 @@ int Tile::getAnimationOffset() const
 void Tile::addItem(BattleItem *item, RuleInventory *ground)
 {
 	item->setSlot(ground);
-	_inventory.push_back(item);
+	_inventory->push_back(item);
 	item->setTile(this);
 }
 
@@ -772,11 +806,11 @@ void Tile::addItem(BattleItem *item, RuleInventory *ground)
  */
 void Tile::removeItem(BattleItem *item)
 {
-	for (std::vector<BattleItem*>::iterator i = _inventory.begin(); i != _inventory.end(); ++i)
+	for (std::vector<BattleItem*>::iterator i = _inventory->begin(); i != _inventory->end(); ++i)
 	{
 		if ((*i) == item)
 		{
-			_inventory.erase(i);
+			_inventory->erase(i);
 			break;
 		}
 	}
@@ -791,7 +825,7 @@ int Tile::getTopItemSprite()
 {
 	int biggestWeight = -1;
 	int biggestItem = -1;
-	for (std::vector<BattleItem*>::iterator i = _inventory.begin(); i != _inventory.end(); ++i)
+	for (std::vector<BattleItem*>::iterator i = _inventory->begin(); i != _inventory->end(); ++i)
 	{
 		if ((*i)->getRules()->getWeight() > biggestWeight)
 		{
@@ -861,7 +895,7 @@ void Tile::prepareNewTurn()
  */
 std::vector<BattleItem *> *Tile::getInventory()
 {
-	return &_inventory;
+	return _inventory;
 }
 
 
@@ -959,6 +993,10 @@ void Tile::addOverlap()
  */
 void Tile::setDangerous()
 {
+	if (!_danger)
+	{
+		++_hazardChanges;
+	}
 	_danger = true;
 }
 
@@ -977,7 +1015,7 @@ bool Tile::getDangerous()
  */
 void Tile::addParticle(Particle *particle)
 {
-	_particles.push_back(particle);
+	_particles->push_back(particle);
 }
 
 /**
@@ -986,7 +1024,7 @@ void Tile::addParticle(Particle *particle)
  */
 std::list<Particle *> *Tile::getParticleCloud()
 {
-	return &_particles;
+	return _particles;
 }
 
 }
@@ -60,30 +60,39 @@ public:
 
 protected:
 	static const int LIGHTLAYERS = 3;
+	static const int MAX_LIGHT = 15;
+	// fields used by the lighting, sight and drawing loops come first,
+	// so a tile's hot data shares as few cache lines as possible
 	MapData *_objects[4];
-	int _mapDataID[4];
-	int _mapDataSetID[4];
-	int _currentFrame[4];
+	BattleUnit *_unit;
+	Uint8 _currentFrame[4];
+	Uint8 _light[LIGHTLAYERS];
 	bool _discovered[3];
-	int _light[LIGHTLAYERS], _lastLight[LIGHTLAYERS];
+	bool _danger;
 	int _smoke;
 	int _fire;
+	int _visible;
+	int _animationOffset;
+	unsigned int _terrainStamp;
+	Position _pos;
+	// item and particle lists live in side tables owned by the battle,
+	// keyed by tile index, so they don't bloat every tile
+	std::vector<BattleItem *> *_inventory;
+	std::list<Particle*> *_particles;
+	int _mapDataID[4];
+	int _mapDataSetID[4];
 	int _explosive;
 	int _explosiveType;
-	Position _pos;
-	BattleUnit *_unit;
-	std::vector<BattleItem *> _inventory;
-	int _animationOffset;
 	int _markerColor;
-	int _visible;
 	int _preview;
 	int _TUMarker;
 	int _overlaps;
-	bool _danger;
-	std::list<Particle*> _particles;
+	static unsigned int _terrainChanges, _fireChanges, _hazardChanges;
+	/// Notes that the terrain of the tile changed.
+	void touchTerrain() { _terrainStamp = ++_terrainChanges; }
 public:
 	/// Creates a tile.
-	Tile(const Position& pos);
+	Tile(const Position& pos, std::vector<BattleItem *> *inventory, std::list<Particle*> *particles);
 	/// Cleans up a tile.
 	~Tile();
 	/// Load the tile from yaml
@@ -153,8 +162,18 @@ public:
 	bool isDiscovered(int part) const;
 	/// Reset light to zero for this tile.
 	void resetLight(int layer);
+	/// Gets when the terrain of this tile last changed.
+	unsigned int getTerrainStamp() const { return _terrainStamp; }
+	/// Gets the count of terrain changes on all tiles.
+	static unsigned int getTerrainChanges() { return _terrainChanges; }
+	/// Gets the count of fires started, changed or put out on all tiles.
+	static unsigned int getFireChanges() { return _fireChanges; }
+	/// Gets the count of smoke or grenade danger changes on all tiles.
+	static unsigned int getHazardChanges() { return _hazardChanges; }
 	/// Add light to this tile.
 	void addLight(int light, int layer);
+	/// Set the light of this tile.
+	void setLight(int light, int layer);
 	/// Get the shade amount.
 	int getShade() const;
 	/// Destroy a tile part.
@@ -67,17 +67,20 @@ namespace OpenXcom
 		Surface *graphic = _game->getMod()->getSurface("INTERWIN.DAT");
 		graphic->setX(0);
 		graphic->setY(0);
-		graphic->getCrop()->x = 0;
-		graphic->getCrop()->y = 0;
-		graphic->getCrop()->w = _image->getWidth();
-		graphic->getCrop()->h = _image->getHeight();
-		_image->drawRect(graphic->getCrop(), 15);
+		SDL_Rect crop;
+		crop.x = 0;
+		crop.y = 0;
+		crop.w = _image->getWidth();
+		crop.h = _image->getHeight();
+		graphic->setCrop(crop);
+		_image->drawRect(&crop, 15);
 		graphic->blit(_image);
 
 		if (ufo->getModSprite().empty())
 		{
-			graphic->getCrop()->y = dogfightInterface->getElement("previewMid")->y + dogfightInterface->getElement("previewMid")->h * ufo->getSprite();
-			graphic->getCrop()->h = dogfightInterface->getElement("previewMid")->h;
+			crop.y = dogfightInterface->getElement("previewMid")->y + dogfightInterface->getElement("previewMid")->h * ufo->getSprite();
+			crop.h = dogfightInterface->getElement("previewMid")->h;
+			graphic->setCrop(crop);
 		}
 		else
 		{
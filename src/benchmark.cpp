@@ -0,0 +1,225 @@
+/*
+ * Copyright 2010-2015 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "Engine/Logger.h"
+#include "Engine/CrossPlatform.h"
+#include "Engine/Game.h"
+#include "Engine/Options.h"
+#include "Engine/Screen.h"
+#include "Engine/State.h"
+#include "Menu/TestState.h"
+#include "Geoscape/GeoscapeState.h"
+#include "Battlescape/BattlescapeState.h"
+#include "Savegame/SavedGame.h"
+#include "Savegame/SavedBattleGame.h"
+
+/*
+ * Headless benchmark of the rendering pipeline.
+ * Renders a few frames of each scene at several display sizes
+ * and with every software filter, using SDL's dummy video driver,
+ * and prints how long each stage of a frame took on average.
+ *
+ * Usage: openxcom_benchmark [-frames N] [-save FILE] [game options...]
+ * Without a save only TestState is rendered, with one the Geoscape
+ * is rendered too, and the Battlescape if the save is in a battle.
+ * Any other arguments are passed on to the game like usual
+ * (eg. -data, -user).
+ */
+
+using namespace OpenXcom;
+
+namespace
+{
+
+/**
+ * Software filter settings to test.
+ */
+struct BenchFilter
+{
+	const char *name;
+	bool scale, hqx, xbrz;
+};
+
+const BenchFilter filters[] =
+{
+	{ "nearest", false, false, false },
+	{ "scale", true, false, false },
+	{ "hqx", false, true, false },
+	{ "xbrz", false, false, true }
+};
+
+/// Display sizes to test, as multiples of the base resolution, plus a letterboxed HD display.
+const int scales[] = { 1, 2, 3, 4, 0 };
+
+/**
+ * Renders the same state again and again with every
+ * display size and filter, printing a line of timings for each.
+ * @param game Pointer to the game.
+ * @param name Name of the scene.
+ * @param state State to render.
+ * @param frames Number of frames per test.
+ */
+void benchScene(Game *game, const std::string &name, State *state, int frames)
+{
+	Screen *screen = game->getScreen();
+	state->init();
+	int baseWidth = Options::baseXResolution;
+	int baseHeight = Options::baseYResolution;
+
+	for (size_t i = 0; i < sizeof(scales) / sizeof(scales[0]); ++i)
+	{
+		for (size_t j = 0; j < sizeof(filters) / sizeof(filters[0]); ++j)
+		{
+			Options::displayWidth = scales[i] ? baseWidth * scales[i] : 1920;
+			Options::displayHeight = scales[i] ? baseHeight * scales[i] : 1080;
+			Options::useScaleFilter = filters[j].scale;
+			Options::useHQXFilter = filters[j].hqx;
+			Options::useXBRZFilter = filters[j].xbrz;
+			screen->resetDisplay();
+			state->redrawText();
+
+			// warm up caches and thread pools before timing anything
+			screen->clear();
+			state->blit();
+			screen->flip();
+			screen->resetFlipTimes();
+
+			double blitTime = 0.0;
+			double start = CrossPlatform::getPerformanceTime();
+			for (int frame = 0; frame < frames; ++frame)
+			{
+				state->think();
+				double blitStart = CrossPlatform::getPerformanceTime();
+				screen->clear();
+				state->blit();
+				blitTime += CrossPlatform::getPerformanceTime() - blitStart;
+				// time the whole pipeline, not just the parts that changed
+				screen->invalidate();
+				screen->flip();
+			}
+			double total = CrossPlatform::getPerformanceTime() - start;
+
+			double ms = 1000.0 / frames;
+			std::ostringstream display;
+			display << screen->getWidth() << "x" << screen->getHeight();
+			std::cout << std::left << std::setw(12) << name
+				<< std::setw(11) << display.str()
+				<< std::setw(9) << filters[j].name
+				<< std::fixed << std::setprecision(3) << std::right
+				<< std::setw(9) << blitTime * ms
+				<< std::setw(9) << screen->getFlipTime(Screen::FLIP_ZOOM) * ms
+				<< std::setw(9) << screen->getFlipTime(Screen::FLIP_PALETTE) * ms
+				<< std::setw(9) << screen->getFlipTime(Screen::FLIP_PRESENT) * ms
+				<< std::setw(9) << total * ms
+				<< std::endl;
+		}
+	}
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	int frames = 100;
+	std::string save;
+	std::vector<char*> args;
+	args.push_back(argv[0]);
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-frames" && i + 1 < argc)
+		{
+			frames = std::max(1, atoi(argv[++i]));
+		}
+		else if (arg == "-save" && i + 1 < argc)
+		{
+			save = argv[++i];
+		}
+		else
+		{
+			args.push_back(argv[i]);
+		}
+	}
+
+	SDL_putenv(const_cast<char*>("SDL_VIDEODRIVER=dummy"));
+	SDL_putenv(const_cast<char*>("SDL_AUDIODRIVER=dummy"));
+	Game *game = 0;
+	try
+	{
+		Logger::reportingLevel() = LOG_WARNING;
+		if (!Options::init(args.size(), &args[0]))
+			return EXIT_SUCCESS;
+		Options::useOpenGL = false;
+		Options::fullscreen = false;
+		Options::keepAspectRatio = true;
+		Options::baseXResolution = Options::displayWidth = Screen::ORIGINAL_WIDTH;
+		Options::baseYResolution = Options::displayHeight = Screen::ORIGINAL_HEIGHT;
+		game = new Game("OpenXcom benchmark");
+		State::setGamePtr(game);
+		Options::updateMods();
+		game->loadMods();
+		game->defaultLanguage();
+
+		std::cout << std::left << std::setw(12) << "scene" << std::setw(11) << "display" << std::setw(9) << "filter"
+			<< std::right << std::setw(9) << "blit" << std::setw(9) << "zoom" << std::setw(9) << "palette"
+			<< std::setw(9) << "flip" << std::setw(9) << "total" << "  (ms per frame, " << frames << " frames)" << std::endl;
+
+		TestState *test = new TestState;
+		benchScene(game, "test", test, frames);
+		delete test;
+
+		if (!save.empty())
+		{
+			SavedGame *saved = new SavedGame();
+			game->setSavedGame(saved);
+			saved->load(save, game->getMod());
+
+			GeoscapeState *geo = new GeoscapeState;
+			benchScene(game, "geoscape", geo, frames);
+			delete geo;
+
+			if (saved->getSavedBattle() != 0)
+			{
+				saved->getSavedBattle()->loadMapResources(game->getMod());
+				BattlescapeState *battle = new BattlescapeState;
+				saved->getSavedBattle()->setBattleState(battle);
+				benchScene(game, "battlescape", battle, frames);
+				saved->getSavedBattle()->setBattleState(0);
+				delete battle;
+			}
+		}
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << e.what() << std::endl;
+		delete game;
+		return EXIT_FAILURE;
+	}
+
+	delete game;
+	return EXIT_SUCCESS;
+}